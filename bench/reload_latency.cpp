@@ -0,0 +1,213 @@
+/**
+ * Live-edit latency benchmark.
+ *
+ * Drives the interactive loop (ShadeApp::pollShaderFile() and drawFrame(),
+ * as runLoop() does) and repeatedly saves a new version of the shader at a
+ * random point of the file poll interval.  For every save it measures the
+ * time until the watcher notices the change, the reload (compile and link),
+ * and the first frame drawn with the new program, up to the end of its
+ * present, then prints the distribution of each over all iterations.
+ */
+
+#include "app.h"
+#include <cli/cli.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+/* Longest a single save may take to show up before the run is abandoned */
+static const double RELOAD_TIMEOUT = 10.0;
+
+struct ReloadSample {
+	// Save to the poll that noticed it
+	double detect;
+	// loadFragmentShader(), ie. compile and link
+	double load;
+	// Drawing and presenting the first frame of the new program
+	double frame;
+	double total;
+};
+
+/* Each save is a different program, as when editing, so driver caches don't hide compile time */
+static bool writeShader(const std::string& path, int version) {
+	std::ofstream out(path.c_str());
+	out << "#version 330\n"
+	       "uniform float iTime;\n"
+	       "uniform vec2 iResolution;\n"
+	       "in vec2 Frag_UV;\n"
+	       "layout(location = 0) out vec4 Out_Color;\n"
+	       "const float VERSION = " << version << ".0;\n"
+	       "void main() {\n"
+	       "	vec2 p = Frag_UV * 2.0 - 1.0;\n"
+	       "	float d = length(p) * (8.0 + mod(VERSION, 7.0));\n"
+	       "	Out_Color = vec4(0.5 + 0.5 * cos(d - iTime + vec3(0.0, 2.0, 4.0) + VERSION), 1.0);\n"
+	       "}\n";
+	return out.good();
+}
+
+/* Re-runs the benchmark under a virtual display when there is none */
+static void ensureDisplay(int argc, const char* argv[]) {
+	if(getenv("DISPLAY") || getenv("WAYLAND_DISPLAY") || getenv("SHADE_BENCH_XVFB")) return;
+	if(system("command -v xvfb-run >/dev/null 2>&1") != 0) return;
+	setenv("SHADE_BENCH_XVFB", "1", 1);
+	std::vector<const char*> args;
+	args.push_back("xvfb-run");
+	args.push_back("-a");
+	args.push_back("/proc/self/exe");
+	for(int i = 1; i < argc; ++i) {
+		args.push_back(argv[i]);
+	}
+	args.push_back(NULL);
+	execvp("xvfb-run", (char* const*)&args[0]);
+	perror("xvfb-run");
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+	// Nearest rank
+	size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.5);
+	if(rank < 1) rank = 1;
+	if(rank > sorted.size()) rank = sorted.size();
+	return sorted[rank - 1];
+}
+
+static void printDistribution(const char* name, std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	double sum = 0.0;
+	for(size_t i = 0; i < values.size(); ++i) {
+		sum += values[i];
+	}
+	printf("%-12s %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n", name, values.front() * 1000.0, percentile(values, 50) * 1000.0,
+		percentile(values, 90) * 1000.0, percentile(values, 99) * 1000.0, values.back() * 1000.0, sum / values.size() * 1000.0);
+}
+
+int main(int argc, const char* argv[]) {
+	int iterations = 200;
+	int width = 800;
+	int height = 600;
+	const char* csvFile = NULL;
+	const char* present = "vsync";
+	bool verbose = false;
+
+	cli::Parser parser = {
+		cli::OptionFlag('v', "verbose", "output logging info", &verbose),
+		cli::OptionInt('n', "iterations", "number of saves to measure (default 200)", false, &iterations),
+		cli::OptionInt('w', "width", "window width", false, &width),
+		cli::OptionInt('h', "height", "window height", false, &height),
+		cli::OptionString('c', "csv", "also write every sample to this CSV file", false, &csvFile),
+		cli::OptionString('P', "present", "vsync (default), uncapped, low-latency, or a frame rate cap", false, &present)
+	};
+	FramePacer::Mode presentMode;
+	double fpsCap = 60.0;
+	if(!parser.parse(argc, argv) || iterations <= 0 || !parsePresentMode(present, presentMode, fpsCap)) {
+		fprintf(stderr, "Usage: reload_latency [options]\n\n"
+			"    Measures the time from saving a shader to presenting its first frame.\n\n");
+		parser.printOptionsUsage();
+		return EXIT_FAILURE;
+	}
+	loguru::g_stderr_verbosity = verbose ? loguru::Verbosity_INFO : loguru::Verbosity_OFF;
+	ensureDisplay(argc, argv);
+
+	char dirTemplate[] = "/tmp/shade_reload_latencyXXXXXX";
+	if(!mkdtemp(dirTemplate)) {
+		perror("mkdtemp");
+		return EXIT_FAILURE;
+	}
+	std::string dir = dirTemplate;
+	std::string shaderFile = dir + "/edited.glsl";
+	if(!writeShader(shaderFile, 0)) {
+		fprintf(stderr, "Couldn't write '%s'\n", shaderFile.c_str());
+		return EXIT_FAILURE;
+	}
+
+	ShadeApp app;
+	app.setPresentMode(presentMode, fpsCap);
+	if(!app.init("reload_latency", width, height) || !app.loadFragmentShader(shaderFile.c_str())) {
+		fprintf(stderr, "Couldn't set up the app\n");
+		return EXIT_FAILURE;
+	}
+
+	// fwatch compares whole seconds of mtime, so saves are stamped a second apart or they would go unnoticed
+	struct timeval stamp[2];
+	gettimeofday(&stamp[0], NULL);
+	stamp[0].tv_usec = 0;
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<double> phase(0.0, FILE_POLL_INTERVAL);
+	std::vector<ReloadSample> samples;
+	for(int i = 0; i < iterations; ++i) {
+		// Keep drawing like an idle session, then save somewhere within the poll interval
+		double saveAt = glfwGetTime() + phase(random);
+		while(glfwGetTime() < saveAt) {
+			app.pollShaderFile();
+			app.drawFrame();
+		}
+
+		++stamp[0].tv_sec;
+		stamp[1] = stamp[0];
+		if(!writeShader(shaderFile, i + 1) || utimes(shaderFile.c_str(), stamp) != 0) {
+			fprintf(stderr, "Couldn't save '%s'\n", shaderFile.c_str());
+			return EXIT_FAILURE;
+		}
+		double saved = glfwGetTime();
+
+		while(true) {
+			double polled = glfwGetTime();
+			bool reloaded = app.pollShaderFile();
+			double loaded = glfwGetTime();
+			app.drawFrame();
+			// Presented once the GPU is done with the swap
+			glFinish();
+			double presented = glfwGetTime();
+
+			if(reloaded) {
+				ReloadSample sample = { polled - saved, loaded - polled, presented - loaded, presented - saved };
+				samples.push_back(sample);
+				break;
+			}
+			if(presented - saved > RELOAD_TIMEOUT) {
+				fprintf(stderr, "Save %d wasn't picked up after %.0f s\n", i + 1, RELOAD_TIMEOUT);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	std::vector<double> detect, load, frame, total;
+	for(size_t i = 0; i < samples.size(); ++i) {
+		detect.push_back(samples[i].detect);
+		load.push_back(samples[i].load);
+		frame.push_back(samples[i].frame);
+		total.push_back(samples[i].total);
+	}
+	printf("%d reloads at %dx%d, present %s, poll interval %.2f s, times in ms\n\n", iterations, width, height, present, FILE_POLL_INTERVAL);
+	printf("%-12s %9s %9s %9s %9s %9s %9s\n", "", "min", "p50", "p90", "p99", "max", "mean");
+	printDistribution("detect", detect);
+	printDistribution("load", load);
+	printDistribution("first frame", frame);
+	printDistribution("total", total);
+
+	if(csvFile) {
+		FILE* csv = fopen(csvFile, "w");
+		if(!csv) {
+			fprintf(stderr, "Couldn't write '%s'\n", csvFile);
+		} else {
+			fprintf(csv, "iteration,detect_ms,load_ms,frame_ms,total_ms\n");
+			for(size_t i = 0; i < samples.size(); ++i) {
+				fprintf(csv, "%d,%.3f,%.3f,%.3f,%.3f\n", (int)i, samples[i].detect * 1000.0, samples[i].load * 1000.0,
+					samples[i].frame * 1000.0, samples[i].total * 1000.0);
+			}
+			fclose(csv);
+		}
+	}
+
+	unlink(shaderFile.c_str());
+	rmdir(dir.c_str());
+	return EXIT_SUCCESS;
+}
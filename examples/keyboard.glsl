@@ -0,0 +1,29 @@
+#version 330
+
+// Run with --channel0 keyboard, arrow keys move the dot and space toggles the color
+
+uniform float iTime;
+uniform vec2 iResolution;
+uniform sampler2D iChannel0;
+
+in vec2 Frag_UV;
+layout(location = 0) out vec4 Out_Color;
+
+const int KEY_SPACE = 32;
+const int KEY_LEFT = 37;
+const int KEY_UP = 38;
+const int KEY_RIGHT = 39;
+const int KEY_DOWN = 40;
+
+float key(int code, int row) {
+	return texelFetch(iChannel0, ivec2(code, row), 0).r;
+}
+
+void main() {
+	vec2 offset = 0.25 * vec2(key(KEY_RIGHT, 0) - key(KEY_LEFT, 0), key(KEY_UP, 0) - key(KEY_DOWN, 0));
+	vec2 uv = (Frag_UV - 0.5 - offset) * vec2(iResolution.x / iResolution.y, 1.0);
+
+	vec3 color = mix(vec3(1.0, 0.5, 0.1), vec3(0.1, 0.5, 1.0), key(KEY_SPACE, 2));
+	float disc = smoothstep(0.11, 0.1, length(uv));
+	Out_Color = vec4(color * disc, 1.0);
+}
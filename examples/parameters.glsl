@@ -0,0 +1,18 @@
+#version 330
+
+uniform float iTime;
+uniform vec2 iResolution;
+
+uniform float frequency = 20.0; // range(1.0, 100.0)
+uniform float speed = 5.0;      // range(0.0, 20.0)
+uniform vec3 tint = vec3(1.0, 0.4, 0.1); // color
+uniform bool invert = false;
+
+in vec2 Frag_UV;
+layout(location = 0) out vec4 Out_Color;
+
+void main() {
+	float wave = 0.5 + 0.5 * sin(length(Frag_UV - 0.5) * frequency - iTime * speed);
+	if(invert) wave = 1.0 - wave;
+	Out_Color = vec4(tint * wave, 1.0);
+}
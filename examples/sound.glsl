@@ -0,0 +1,9 @@
+// Render with: shade --sound out.wav --duration 10 examples/sound.glsl
+
+vec2 mainSound(int samp, float time) {
+	// A two-note arpeggio with a decaying envelope
+	float note = mod(floor(time * 4.0), 2.0) == 0.0 ? 440.0 : 660.0;
+	float envelope = exp(-6.0 * fract(time * 4.0));
+	float wave = sin(6.2831853 * note * time) * envelope * 0.4;
+	return vec2(wave, wave * 0.8);
+}
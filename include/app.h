@@ -7,19 +7,153 @@
 #include "imgui_impl_glfw_gl3.h"
 
 #include "shader.h"
+#include "parameters.h"
+#include "permutations.h"
 
 #include "file_watching.h"
+#include "render_target.h"
+#include "readback.h"
+#include "shm_output.h"
+#include "input_log.h"
+#include "channels.h"
+#include "render_graph.h"
+#include "sound.h"
+#include "export.h"
+#include "frame_pacing.h"
+#include "frame_stats.h"
+#include "builtin_block.h"
+#include "tile_scheduler.h"
+#include "playlist.h"
 
 #define MENUBAR_HEIGHT 19
 
+/* Seconds between checks of the shader file for changes */
+#define FILE_POLL_INTERVAL 1.0
+
+/* Seconds the window must keep its size before render targets are reallocated for it */
+#define RESIZE_SETTLE_TIME 0.2
+
+struct RenderJob;
+
+/* A shader drawn in a tile of the grid, see views.cpp */
+struct ShaderView {
+	std::string path;
+	fwatch::Timestamp timestamp;
+	// From the app's shared program cache: the program drawn, and a newer build still compiling
+	Permutation* current;
+	Permutation* pending;
+	std::string error;
+	RenderTarget target;
+	// Tiles are redrawn when the scheduler gets to them, time and frame count follow their own draws
+	double lastDrawTime;
+	int drawCount;
+
+	ShaderView():timestamp(fwatch::ZERO_TIMESTAMP), current(nullptr), pending(nullptr), lastDrawTime(0.0), drawCount(0) {}
+};
+
+/* A playlist entry being shown, or prepared to be shown next, see playlist.cpp */
+struct PlaylistSlot {
+	size_t entry;
+	// From the shared program cache, built in the background
+	Permutation* permutation;
+	RenderTarget target;
+	// Frames drawn offscreen before the entry is shown, so the driver's work on first draws is done
+	int warmupFrames;
+	// When the entry started showing, its iTime starts from 0 there
+	double startTime;
+	int frameCount;
+
+	PlaylistSlot():entry(0), permutation(nullptr), warmupFrames(0), startTime(-1.0), frameCount(0) {}
+};
+
 class ShadeApp {
 public:
 	ShadeApp();
 	~ShadeApp();
 
-	bool init(const char* title, uint16_t width, uint16_t height);
+	/* Headless apps use a hidden window and no UI, for offline rendering */
+	bool init(const char* title, uint16_t width, uint16_t height, bool headless = false);
 	bool loadFragmentShader(const char* filename = NULL);
 	int runLoop();
+
+	/* One iteration of runLoop(): reloads the shader if it changed, then draws and presents a frame */
+	bool pollShaderFile();
+	void drawFrame();
+
+	/* Swap interval and frame pacing of the interactive loop, see frame_pacing.h */
+	void setPresentMode(FramePacer::Mode mode, double fps = 60.0);
+
+	/**
+	 * Fullscreen at the desktop resolution of a monitor (0 is the primary,
+	 * -1 the one the window is mostly on), or back to the window it left.
+	 * Can be called before init().
+	 */
+	void setFullscreen(bool fullscreen, int monitor = -1);
+
+	bool isFullscreen() const {
+		return _fullscreen;
+	}
+
+	/* Writes the frame times of the interactive session as CSV when it ends, and where the UI exports them */
+	void setFrameTimesFile(const char* path) {
+		_frameTimesFile = path;
+	}
+
+	/* Renders the loaded shader offscreen and writes the frames as images */
+	int exportFrames(const ExportSettings& settings);
+
+	/* Renders every shader in a directory, see batch.cpp */
+	int runBatch(const char* shaderDir, const ExportSettings& settings);
+
+	/* Renders a ShaderToy sound shader to a WAV file, see sound.cpp */
+	int renderSound(const char* shaderFile, const SoundSettings& settings);
+
+	/* Renders jobs received on a Unix domain socket, see render_server.h */
+	int runServer(const char* socketPath);
+
+	/* Publishes every rendered frame to a shared-memory ring, see shm_output.h */
+	bool enableShmOutput(const char* name);
+
+	/* Records the inputs of every interactive frame to a file, see input_log.h */
+	bool startRecording(const char* path);
+
+	/**
+	 * Drives time and inputs from a recording instead of the live session.
+	 * With speed 0 every recorded frame is rendered once, as fast as possible,
+	 * otherwise recorded time is followed at the given speed.  Exports render
+	 * recorded frames by index.  Takes the frames of a loaded log, leaving it
+	 * empty.
+	 */
+	void startReplay(InputLog& log, double speed);
+
+	size_t getReplayLength() const {
+		return _replay.size();
+	}
+
+	/**
+	 * Adds a shader to the grid of views drawn instead of the loaded shader,
+	 * each in its own tile.  Views share one program cache and one buffer of
+	 * built-in uniforms, and reload when their file changes.
+	 */
+	bool addView(const char* path);
+
+	/* Adds a view of every .glsl file in a directory, for reviewing a shader library */
+	int addGallery(const char* dir);
+
+	/**
+	 * Cycles through the shaders of a playlist, see playlist.h.  Each is
+	 * built and warmed up offscreen while the previous one shows, and
+	 * crossfaded in over the given seconds.
+	 */
+	bool startPlaylist(const char* path, double crossfade = DEFAULT_CROSSFADE_TIME);
+
+	/* GPU milliseconds per frame the grid may spend redrawing tiles, see tile_scheduler.h */
+	void setTileBudget(double ms) {
+		_tileScheduler.setBudget(ms);
+	}
+
+	/* Binds a texture input to iChannelN, see createChannelInput() for the descriptions */
+	bool setChannel(int index, const char* spec);
 private:
 	bool setupGLFW(const char* title);
 	bool setupGLObjects();
@@ -27,10 +161,50 @@ private:
 	void cleanupShaders(bool cleanupBuiltins);
 
 	bool loadErrorShader();
+	bool loadProject(const char* path);
+	void buildShaderGraph();
 	bool relinkProgram();
+	void updateBakedPermutation();
+
+	void renderJob(PermutationCache& programs, RenderTarget& target, const RenderJob& job);
+	void publishFrame(const RenderTarget& target, uint64_t frameIndex);
+
+	FrameState sampleFrameState();
+	FrameState exportFrameState(int frameNumber, int fps);
+	void renderExportFrame(FrameState frame, RenderTarget& target);
+	InputFrame nextReplayFrame();
+	static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
+	void updateViewSize();
+	void applyPendingResize();
+	void applyFullscreen();
+	void applyInput(const InputFrame& input);
+	void applyKeyEvents(const std::vector<InputKeyEvent>& keys);
+	std::vector<ChannelInput*> getChannelInputs() const;
+	void updateChannels(FrameState& frame);
+	void bindChannels();
+	void useProgram(const FrameState& frame);
+	void drawQuad();
+	void renderGraph(const FrameState& frame, GLuint framebuffer, int width, int height);
+
+	void loadView(ShaderView& view);
+	void pollViewFiles();
+	void updateViews();
+	void getViewRect(size_t index, int rect[4]) const;
+	void drawViews(const FrameState& frame);
+	void clearViews();
+
+	void preparePlaylistSlot(PlaylistSlot& slot, size_t entry);
+	void drawPlaylistSlot(PlaylistSlot& slot, const FrameState& frame, double time);
+	void drawPlaylist(const FrameState& frame);
+	void stopPlaylist();
 
 	void initUI();
 	void drawUI();
+	void drawParameterUI();
+	void drawGraphUI();
+	void drawFrameStatsUI();
+	void drawViewsUI();
 
 	Program* _program;
     Shader* _vertexShader;
@@ -40,20 +214,91 @@ private:
     GLuint _indexBuffer;
 
     GLFWwindow* _window;
+    bool _headless;
 
     const char* _currentShaderFile;
     fwatch::Timestamp _currentShaderFileTimestamp;
+    double _lastFilePollTime;
 
+    // Render size: iResolution and the size of the pass outputs
     uint16_t _windowWidth;
     uint16_t _windowHeight;
 
+    // Pixels below the menu bar, these follow the window at once and the render size once they settle
+    int _viewWidth;
+    int _viewHeight;
+    bool _resizePending;
+    double _resizeTime;
+
+    bool _fullscreen;
+    int _fullscreenMonitor;
+    // Position and size of the window to restore when leaving fullscreen
+    int _windowedRect[4];
+
     Shader* _builtinVertexShader;
     Shader* _builtinErrorShader;
     Shader* _builtinDefaultShader;
 
-    GLint _uniform_Time;
-    GLint _uniform_Resolution;
-    GLint _uniform_Mouse;
+    BuiltinUniforms _builtinUniforms;
+
+    ParameterTable _parameters;
+
+    // Baked parameter permutations, used instead of _program when ready
+    PermutationCache _permutations;
+    Permutation* _bakedPermutation;
+    bool _bakeParameters;
+    bool _bakePending;
+    uint32_t _bakedVersion;
+    double _bakeRequestTime;
+
+    uint64_t _frameCount;
+    double _lastFrameTime;
+
+    // ShaderToy iMouse state, see FrameState::clickMouse
+    float _clickMouse[4];
+    bool _mouseWasDown;
+
+    // Shared-memory output; frames are rendered to _sceneTarget and read back asynchronously
+    ShmFrameOutput _shmOutput;
+    AsyncReadback _readback;
+    RenderTarget _sceneTarget;
+
+    // Input recording and replay
+    InputRecorder _recorder;
+    FramePacer _pacer;
+    FrameStats _frameStats;
+    std::string _frameTimesFile;
+    int _frameStatsWindow;
+    InputLog _replay;
+    double _replaySpeed;
+    double _replayStartTime;
+    size_t _replayFrame;
+    std::vector<InputKeyEvent> _pendingKeys;
+
+    ChannelInput* _channels[CHANNEL_COUNT];
+
+    // What is drawn each frame: the passes of a ShaderToy project, or a single pass drawing _program
+    RenderGraph* _graph;
+    bool _projectLoaded;
+
+    // Shaders drawn side by side instead, sharing programs and the built-in uniform buffer
+    std::vector<ShaderView*> _views;
+    PermutationCache _viewPrograms;
+    BuiltinBlockBuffer _viewBlock;
+    TileScheduler _tileScheduler;
+    std::vector<size_t> _scheduledTiles;
+
+    // Playlist; the slot shown and the next one swap at the end of each crossfade
+    std::vector<PlaylistEntry> _playlist;
+    PlaylistSlot _playlistSlots[2];
+    int _playlistCurrent;
+    double _crossfadeTime;
+    // Start of the crossfade under way, negative if none
+    double _fadeStart;
 
     bool _showFramerate;
+    bool _showParameters;
+    bool _showGraph;
+    bool _showFrameStats;
+    bool _showViews;
 };
\ No newline at end of file
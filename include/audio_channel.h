@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "channels.h"
+#include "fft.h"
+#include "wav.h"
+
+/**
+ * ShaderToy's music input: a 512x2 R8 texture with the spectrum of the audio
+ * around the current time in row 0 and the waveform in row 1.
+ *
+ * The audio position follows iTime (looping), not a playback clock, so the
+ * texture is a function of the frame time alone and exports with the fixed
+ * step clock are reproducible.  The file is decoded on a background thread
+ * that stays a few seconds ahead of the last position requested; if a frame
+ * needs samples that aren't decoded yet (eg. after a seek) update() waits.
+ */
+class AudioChannel : public ChannelInput {
+public:
+	static const int BIN_COUNT = 512;
+	static const int FFT_SIZE = 2 * BIN_COUNT;
+
+	AudioChannel();
+	~AudioChannel();
+
+	bool init(const char* path);
+
+	void update(const FrameState& frame);
+
+	GLuint getTexture() const {
+		return _texture;
+	}
+
+	int getWidth() const {
+		return BIN_COUNT;
+	}
+
+	int getHeight() const {
+		return 2;
+	}
+
+private:
+	AudioChannel(const AudioChannel&);
+	AudioChannel& operator=(const AudioChannel&);
+
+	void decodeLoop();
+	/* Copies count samples ending before position into out, waiting for the decoder if needed */
+	void fetch(int64_t position, float* out, int count);
+	void analyze(const float* samples);
+
+	WavReader _wav;
+	FFT _fft;
+	GLuint _texture;
+	int64_t _position;
+	std::vector<float> _window;
+	uint8_t _pixels[2][BIN_COUNT];
+
+	// Decoded samples; absolute sample i lives at _ring[i & (size - 1)], valid in [_begin, _end)
+	std::thread _decoder;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::vector<float> _ring;
+	int64_t _begin;
+	int64_t _end;
+	int64_t _playhead;
+	bool _stop;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "shader.h"
+#include "parameters.h"
+
+/* Uniform buffer binding the ShadeBuiltins block is read from */
+#define BUILTIN_BLOCK_BINDING 0
+
+/**
+ * Moves the built-in uniform declarations of a shader (iResolution, iTime,
+ * iTimeDelta, iFrameRate, iFrame, iMouse, iDate, iSampleRate) into a std140
+ * block named ShadeBuiltins, so the values for many programs can be written
+ * to one buffer once per frame instead of with glUniform calls per program.
+ * The block replaces the first declaration and the others become empty
+ * lines, so line numbers in compile errors still match the file.  Source
+ * older than GLSL 1.40, which has no uniform blocks, is returned unchanged.
+ */
+std::string moveBuiltinsToBlock(const std::string& source);
+
+/* Points the program's ShadeBuiltins block at BUILTIN_BLOCK_BINDING, if it has one */
+void bindBuiltinBlock(const Program& program);
+
+/**
+ * The ShadeBuiltins values of several frames (eg. one per view) in one
+ * uniform buffer, each at an offset aligned for glBindBufferRange().
+ */
+class BuiltinBlockBuffer {
+public:
+	BuiltinBlockBuffer():_buffer(0), _stride(0), _size(0) {}
+	~BuiltinBlockBuffer() { destroy(); }
+
+	/* Uploads the values of every frame, orphaning the previous contents */
+	void update(const std::vector<FrameState>& frames);
+
+	/* Binds the block of frames[index] of the last update() */
+	void bind(size_t index) const;
+
+	void destroy();
+
+private:
+	BuiltinBlockBuffer(const BuiltinBlockBuffer&);
+	BuiltinBlockBuffer& operator=(const BuiltinBlockBuffer&);
+
+	GLuint _buffer;
+	size_t _stride;
+	size_t _size;
+	std::vector<float> _data;
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "shader.h"
+#include "parameters.h"
+
+/**
+ * A texture input bound to one of the iChannelN samplers.
+ *
+ * Channels are updated once per frame, before the frame is drawn, and must
+ * only upload what changed since the previous frame.
+ */
+class ChannelInput {
+public:
+	virtual ~ChannelInput() {}
+
+	/* Brings the texture up to date for the frame about to be drawn */
+	virtual void update(const FrameState& frame) = 0;
+
+	/* A key event delivered to the frame, key is a GLFW key code */
+	virtual void handleKey(int key, int action) {}
+
+	/* Returns to the initial state, eg. before replaying inputs from the start */
+	virtual void reset() {}
+
+	/**
+	 * Offline renders (exports) must be reproducible: streaming inputs then
+	 * wait for the data of each frame instead of dropping or holding frames.
+	 */
+	virtual void setOffline(bool offline) {}
+
+	/* Whether the last update() changed the texture, so passes reading only unchanged inputs can be skipped */
+	virtual bool changed() const {
+		return true;
+	}
+
+	virtual GLenum getTarget() const {
+		return GL_TEXTURE_2D;
+	}
+
+	virtual GLuint getTexture() const = 0;
+	virtual int getWidth() const = 0;
+	virtual int getHeight() const = 0;
+};
+
+/**
+ * ShaderToy's keyboard texture: 256x3 R8, indexed by JavaScript key code.
+ * Row 0 is 1 while a key is held, row 1 is 1 on the frame it was pressed
+ * and row 2 flips on every press.
+ */
+class KeyboardChannel : public ChannelInput {
+public:
+	static const int KEY_COUNT = 256;
+
+	KeyboardChannel();
+	~KeyboardChannel();
+
+	bool init();
+
+	void update(const FrameState& frame);
+	void handleKey(int key, int action);
+	void reset();
+
+	bool changed() const {
+		return _uploaded;
+	}
+
+	GLuint getTexture() const {
+		return _texture;
+	}
+
+	int getWidth() const {
+		return KEY_COUNT;
+	}
+
+	int getHeight() const {
+		return 3;
+	}
+
+private:
+	KeyboardChannel(const KeyboardChannel&);
+	KeyboardChannel& operator=(const KeyboardChannel&);
+
+	GLuint _texture;
+	uint8_t _state[3][KEY_COUNT];
+	bool _dirty;
+	bool _pressedThisFrame;
+	bool _uploaded;
+};
+
+/**
+ * A still image, or a cubemap from six images named FILE, FILE_1 ... FILE_5
+ * (ShaderToy's naming, faces in GL order +X -X +Y -Y +Z -Z).  Images are
+ * flipped to GL's bottom-up rows when flip is set; mipmaps are generated.
+ */
+class ImageChannel : public ChannelInput {
+public:
+	ImageChannel():_texture(0), _target(GL_TEXTURE_2D), _width(0), _height(0) {}
+	~ImageChannel();
+
+	bool init(const char* path, bool flip = true, bool srgb = false);
+	bool initCubemap(const char* path, bool flip = false, bool srgb = false);
+
+	void update(const FrameState&) {}
+
+	bool changed() const {
+		return false;
+	}
+
+	GLenum getTarget() const {
+		return _target;
+	}
+
+	GLuint getTexture() const {
+		return _texture;
+	}
+
+	int getWidth() const {
+		return _width;
+	}
+
+	int getHeight() const {
+		return _height;
+	}
+
+private:
+	ImageChannel(const ImageChannel&);
+	ImageChannel& operator=(const ImageChannel&);
+
+	GLuint _texture;
+	GLenum _target;
+	int _width;
+	int _height;
+};
+
+/**
+ * RGBA8 texture updated with whole frames through a pair of pixel unpack
+ * buffers: upload() copies into an orphaned PBO and the texture update is a
+ * GPU-side copy that doesn't wait on the previous frame's transfer.
+ */
+class StreamingTexture {
+public:
+	StreamingTexture():_texture(0), _width(0), _height(0), _next(0) {
+		_pbo[0] = _pbo[1] = 0;
+	}
+	~StreamingTexture() { destroy(); }
+
+	bool create(int width, int height);
+	void destroy();
+
+	/* Replaces the contents with width * height RGBA8 pixels, bottom row first */
+	void upload(const uint8_t* rgba);
+
+	GLuint getTexture() const {
+		return _texture;
+	}
+
+	int getWidth() const {
+		return _width;
+	}
+
+	int getHeight() const {
+		return _height;
+	}
+
+private:
+	StreamingTexture(const StreamingTexture&);
+	StreamingTexture& operator=(const StreamingTexture&);
+
+	GLuint _texture;
+	GLuint _pbo[2];
+	int _width;
+	int _height;
+	int _next;
+};
+
+/**
+ * Index of the frame of a fps stream shown at time.  Tolerates the rounding
+ * of time = N / fps so frame N of an export picks stream frame N.
+ */
+int64_t channelFrameIndex(double time, double fps);
+
+/* Maps a GLFW key code to the JavaScript key code ShaderToy shaders expect, -1 if unmapped */
+int toBrowserKeyCode(int glfwKey);
+
+/**
+ * Creates a channel from a command line description:
+ *     keyboard    ShaderToy keyboard texture
+ *     image:FILE  a still image
+ *     audio:FILE  spectrum and waveform of a WAV file, see audio_channel.h
+ *     video:FILE  Y4M file, or any video through ffmpeg, see video_channel.h
+ *     sequence:PATTERN[@FPS]  numbered images, eg. shot_%05d.png@24 (default
+ *                 60 fps), see sequence_channel.h
+ * Returns NULL and logs an error if the description isn't valid.
+ */
+ChannelInput* createChannelInput(const char* spec);
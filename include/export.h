@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/* Frame range and timing of an offline render */
+struct ExportSettings {
+	std::vector<int> frames;
+	int fps;
+	std::string outDir;
+};
+
+/**
+ * Parses a frame list such as "0-59" or "0,10,20-29" into frame numbers.
+ * Ranges are inclusive.  Returns false on malformed input.
+ */
+bool parseFrameList(const char* spec, std::vector<int>& frames);
+
+/* Formats frame numbers back into the compact form accepted by parseFrameList() */
+std::string formatFrameList(const std::vector<int>& frames);
+
+/**
+ * Keeps the part of frames that shard K of N renders: every Nth frame
+ * starting at K, or the Kth of N contiguous blocks.  Parses "K/N" from spec.
+ */
+bool applyShard(const char* spec, bool contiguous, std::vector<int>& frames);
+
+/* Output path of a frame, eg. "<outDir>/<stem>_00042.png" */
+std::string frameFileName(const std::string& outDir, const std::string& stem, int frame);
+
+/* File name without directory or extension */
+std::string fileStem(const std::string& path);
+
+/* True if the output image of a frame already exists */
+bool frameExists(const std::string& outDir, const std::string& stem, int frame);
+
+/**
+ * Coordinates a multi-process export: spawns up to `workers` copies of this
+ * executable with the same arguments, each rendering a chunk of the frames
+ * that don't have an output image yet, and hands out further chunks as
+ * workers finish.  Returns once all frames exist or a chunk failed.  When
+ * frames carry state, each worker would render every frame before its
+ * chunk, so a single worker renders them all.  See shard.cpp.
+ */
+int runShardCoordinator(int argc, const char* argv[], const ExportSettings& settings, const std::string& stem, int workers, bool carriesState);
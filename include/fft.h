@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Radix-2 complex FFT of a fixed power-of-two size, in place on split real
+ * and imaginary arrays.  Twiddles are laid out contiguously per stage so the
+ * butterflies run four at a time with SSE where available.
+ */
+class FFT {
+public:
+	FFT():_size(0) {}
+
+	/* Returns false if size isn't a power of two >= 4 */
+	bool init(int size);
+
+	/* Forward transform, re and im hold getSize() values */
+	void transform(float* re, float* im) const;
+
+	int getSize() const {
+		return _size;
+	}
+
+private:
+	int _size;
+	std::vector<uint32_t> _bitReverse;
+	// Stage with half size h uses entries [h - 1, 2h - 1)
+	std::vector<float> _twiddleRe;
+	std::vector<float> _twiddleIm;
+};
@@ -1,7 +1,13 @@
 /* Rudimentary cross-platform (when completed) file modification polling */
 
+#include <string>
+#include <vector>
+
 #if defined(_WIN32)
 #include <windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/time.h>
 #endif
 
 namespace fwatch {
@@ -10,8 +16,6 @@ namespace fwatch {
 	typedef struct _FILETIME Timestamp;
 	const Timestamp ZERO_TIMESTAMP = {0,0};
 #else
-	#include <sys/stat.h>
-	#include <sys/time.h>
 	typedef time_t Timestamp;
 	const Timestamp ZERO_TIMESTAMP = 0;
 #endif
@@ -24,4 +28,13 @@ namespace fwatch {
  */
 bool checkFileModified(const char* path, Timestamp* lastTime);
 
+/**
+ * Lists the regular files in dir whose names end with extension (eg. ".glsl"),
+ * as full paths sorted by name.
+ */
+std::vector<std::string> listFiles(const char* dir, const char* extension);
+
+/* Creates dir if it doesn't exist yet, returns false on failure */
+bool makeDirectory(const char* dir);
+
 };
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+/**
+ * Presentation and frame pacing of the interactive loop.
+ *
+ *     VSYNC        swap interval 1, frames queue up behind the display
+ *     UNCAPPED     swap interval 0, as fast as the GPU goes
+ *     CAPPED       swap interval 0, frames started at a fixed rate by a
+ *                  limiter that sleeps, then spins for the last stretch
+ *     LOW_LATENCY  swap interval 1, but the CPU waits for each flip and
+ *                  starts the next frame (and samples input) as late as
+ *                  the measured frame time allows before the next vblank
+ *
+ * Latency is measured from the input a frame was drawn with to its
+ * present: the end of the flip in LOW_LATENCY, otherwise the GPU timestamp
+ * of a query put after the swap, against the GPU clock read when the input
+ * was sampled.  Without timer queries (before OpenGL 3.3) it is when a
+ * fence put after the swap is seen signaled, up to a frame late, so only an
+ * upper bound.
+ */
+class FramePacer {
+public:
+	enum Mode {
+		VSYNC,
+		UNCAPPED,
+		CAPPED,
+		LOW_LATENCY
+	};
+
+	FramePacer();
+
+	/* Takes effect with apply(), which needs the window's context current; fps is the cap for CAPPED */
+	void setMode(Mode mode, double fps = 60.0);
+	void apply();
+
+	/* Releases the fences of frames still in flight, while the context is alive */
+	void reset();
+
+	Mode getMode() const {
+		return _mode;
+	}
+
+	double getFpsCap() const {
+		return _fpsCap;
+	}
+
+	/* Waits until the frame should start, right before its input is sampled */
+	void beginFrame();
+
+	/* Timestamps the input the frame is drawn from */
+	void markInputSampled();
+
+	/* Swaps the window's buffers, as the mode wants */
+	void present(GLFWwindow* window);
+
+	/* Input-to-present latency in seconds, smoothed over recent frames (0 until measured) */
+	double getLatency() const {
+		return _latency;
+	}
+
+	/* Worst latency of the last second */
+	double getMaxLatency() const {
+		return _reportedMaxLatency;
+	}
+
+	/* Whether the latency is only an upper bound, see above */
+	bool isLatencyUpperBound() const {
+		return _mode != LOW_LATENCY && !_timerQueries;
+	}
+
+private:
+	FramePacer(const FramePacer&);
+	FramePacer& operator=(const FramePacer&);
+
+	struct PendingFrame {
+		double inputTime;
+		// With timer queries: the GPU clock at input time, and a timestamp query after the swap
+		GLint64 gpuInputTime;
+		GLuint query;
+		GLsync fence;
+	};
+
+	void sleepUntil(double time);
+	void collectPresented(bool wait);
+	void recordLatency(double latency);
+
+	Mode _mode;
+	double _fpsCap;
+	// Seconds between vblanks
+	double _refreshPeriod;
+	double _nextFrameTime;
+	double _inputTime;
+	GLint64 _gpuInputTime;
+	bool _timerQueries;
+	double _lastFlip;
+	// LOW_LATENCY: input to GPU done, a decaying maximum over recent frames
+	double _workEstimate;
+	// How long before a deadline sleeping stops and spinning starts, grows with observed oversleeping
+	double _spinMargin;
+	std::deque<PendingFrame> _pending;
+	std::vector<GLuint> _freeQueries;
+	double _latency;
+	double _maxLatency;
+	double _reportedMaxLatency;
+	double _maxLatencyStart;
+};
+
+/* Parses "vsync", "uncapped", "low-latency" or a frame rate cap such as "144" */
+bool parsePresentMode(const char* spec, FramePacer::Mode& mode, double& fps);
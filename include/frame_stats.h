@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "shader.h"
+
+/* Times of one presented frame */
+struct FrameSample {
+	uint64_t frame;
+	// Seconds since GLFW init, when the frame started
+	double start;
+	// Since the previous frame started
+	float intervalMs;
+	// From the start of the frame until it's handed to the swap
+	float cpuMs;
+	// GPU time of the frame's commands, -1 if unknown
+	float gpuMs;
+};
+
+/**
+ * The latest FRAME_RING_SIZE frame samples.  One thread pushes, any thread
+ * can copy a consistent snapshot without locks: the writer publishes each
+ * sample by advancing the count, readers drop whatever may have been
+ * overwritten while they copied.
+ */
+class FrameTimeRing {
+public:
+	enum { CAPACITY = 4096 };
+
+	FrameTimeRing():_samples(CAPACITY), _count(0) {}
+
+	void push(const FrameSample& sample);
+
+	/* Appends the samples still in the ring (at most the latest limit) to out, oldest first */
+	void copy(std::vector<FrameSample>& out, size_t limit = CAPACITY) const;
+
+	uint64_t getCount() const {
+		return _count.load(std::memory_order_acquire);
+	}
+
+private:
+	std::vector<FrameSample> _samples;
+	std::atomic<uint64_t> _count;
+};
+
+/**
+ * Counts of durations in log-linear buckets, as in HdrHistogram: 64 linear
+ * buckets below 64 us, then 32 per power of two, so a value is found again
+ * within about 3%, from 1 us to over a minute.
+ */
+class TimeHistogram {
+public:
+	enum {
+		SUB_BUCKETS = 32,
+		RANGES = 21,
+		BUCKET_COUNT = SUB_BUCKETS * 2 + SUB_BUCKETS * (RANGES - 1)
+	};
+
+	TimeHistogram() { clear(); }
+
+	void clear();
+	void record(double ms);
+	void add(const TimeHistogram& other);
+
+	/* Smallest time at least p percent of the recorded ones are at or below, 0 when empty */
+	double percentile(double p) const;
+
+	double getMax() const {
+		return _maxMs;
+	}
+
+	uint64_t getTotal() const {
+		return _total;
+	}
+
+private:
+	static int bucketIndex(uint32_t us);
+	static uint32_t bucketHighest(int index);
+
+	uint32_t _counts[BUCKET_COUNT];
+	uint64_t _total;
+	double _maxMs;
+};
+
+/* Percentiles of one series over one window */
+struct FrameTimePercentiles {
+	double p50;
+	double p95;
+	double p99;
+	double max;
+	uint64_t count;
+};
+
+/**
+ * Frame interval, CPU and GPU time of the interactive loop.  GPU time is
+ * measured with GL_TIME_ELAPSED queries read back a few frames later
+ * without stalling, so a sample is recorded once its query is done.
+ * Percentiles are kept per second and merged into rolling windows.
+ */
+class FrameStats {
+public:
+	enum Series {
+		INTERVAL,
+		CPU,
+		GPU,
+		SERIES_COUNT
+	};
+
+	enum Window {
+		LAST_SECOND,
+		LAST_10_SECONDS,
+		LAST_MINUTE,
+		ALL_TIME,
+		WINDOW_COUNT
+	};
+
+	FrameStats();
+
+	/* Brackets the CPU work and GL commands of a frame, end before the swap */
+	void beginFrame();
+	void endFrame();
+
+	/* Deletes the queries, while the context is current */
+	void reset();
+
+	FrameTimePercentiles getPercentiles(Series series, Window window) const {
+		return _percentiles[window][series];
+	}
+
+	const FrameTimeRing& getRing() const {
+		return _ring;
+	}
+
+	/* Writes the samples in the ring as CSV */
+	bool writeCSV(const char* path) const;
+
+private:
+	FrameStats(const FrameStats&);
+	FrameStats& operator=(const FrameStats&);
+
+	struct PendingFrame {
+		FrameSample sample;
+		GLuint query;
+	};
+
+	void collect(bool wait);
+	void record(const FrameSample& sample);
+	void rollSecond(double now);
+
+	FrameTimeRing _ring;
+	std::deque<PendingFrame> _pending;
+	std::vector<GLuint> _freeQueries;
+	FrameSample _current;
+	double _lastStart;
+	uint64_t _frame;
+
+	// Histograms of the current second and the 59 before it, SERIES_COUNT per second
+	std::vector<TimeHistogram> _seconds;
+	int _secondIndex;
+	double _secondStart;
+	TimeHistogram _allTime[SERIES_COUNT];
+	FrameTimePercentiles _percentiles[WINDOW_COUNT][SERIES_COUNT];
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * GL_KHR_debug support (core in GL 4.3, exposed by most 3.2+ drivers).
+ *
+ * Debug builds (SHADE_GL_DEBUG, on unless NDEBUG) ask for a debug context
+ * and log the driver's messages through loguru, so GL errors are reported
+ * without polling glGetError after every call.  Debug groups and object
+ * labels are set in every build, they are what GPU capture tools show for
+ * passes, programs and textures.  Everything is a no-op without KHR_debug.
+ */
+
+#include <string>
+#include <GL/gl3w.h>
+
+#ifndef SHADE_GL_DEBUG
+#ifdef NDEBUG
+#define SHADE_GL_DEBUG 0
+#else
+#define SHADE_GL_DEBUG 1
+#endif
+#endif
+
+/* Looks for KHR_debug once the context is current, and in debug builds installs the log callback */
+void initGLDebug();
+
+bool isGLDebugSupported();
+
+/* Whether driver messages are logged, in which case CHECK_GL has no need for glGetError */
+bool isGLDebugOutputEnabled();
+
+/* Names an object (GL_TEXTURE, GL_PROGRAM, ...) in messages and captures, it must have been bound or created already */
+void labelGLObject(GLenum identifier, GLuint name, const std::string& label);
+
+/* Brackets the GL calls made during its lifetime in a named group */
+class GLDebugGroup {
+public:
+	explicit GLDebugGroup(const char* name);
+	explicit GLDebugGroup(const std::string& name);
+	~GLDebugGroup();
+
+private:
+	GLDebugGroup(const GLDebugGroup&);
+	GLDebugGroup& operator=(const GLDebugGroup&);
+
+	bool _pushed;
+};
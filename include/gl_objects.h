@@ -0,0 +1,102 @@
+#pragma once
+
+/**
+ * Debug tracking of GL object lifetimes.
+ *
+ * With TRACK_GL_OBJECTS (on unless NDEBUG is defined), the create, gen and
+ * delete calls for shaders, programs, buffers, textures, framebuffers,
+ * vertex arrays and samplers made by code including shader.h go through
+ * wrappers that count the live objects per type and remember where each
+ * was created.  Deleting a name that isn't live (eg. deleting twice) is
+ * logged with its call site.  Code that includes gl3w.h directly (ImGui's
+ * backend) isn't tracked.
+ */
+
+#include <GL/gl3w.h>
+
+#ifndef TRACK_GL_OBJECTS
+#ifdef NDEBUG
+#define TRACK_GL_OBJECTS 0
+#else
+#define TRACK_GL_OBJECTS 1
+#endif
+#endif
+
+enum GLObjectType {
+	GL_OBJECT_SHADER,
+	GL_OBJECT_PROGRAM,
+	GL_OBJECT_BUFFER,
+	GL_OBJECT_TEXTURE,
+	GL_OBJECT_FRAMEBUFFER,
+	GL_OBJECT_VERTEX_ARRAY,
+	GL_OBJECT_SAMPLER,
+	GL_OBJECT_TYPE_COUNT
+};
+
+const char* getGLObjectTypeName(GLObjectType type);
+
+/* Live objects of a type created through the wrappers, 0 when tracking is compiled out */
+int getLiveGLObjects(GLObjectType type);
+
+/* Deletes of names that weren't live, each also logged as an error */
+int getStaleGLDeletes();
+
+/* Logs the live object counts, and with details where each live object was created */
+void logLiveGLObjects(bool details = false);
+
+void trackGLObjectsCreated(GLObjectType type, GLsizei count, const GLuint* names, const char* file, int line);
+void trackGLObjectsDeleted(GLObjectType type, GLsizei count, const GLuint* names, const char* file, int line);
+
+#if TRACK_GL_OBJECTS
+
+inline GLuint trackGLCreate(GLObjectType type, GLuint name, const char* file, int line) {
+	if(name != 0) trackGLObjectsCreated(type, 1, &name, file, line);
+	return name;
+}
+
+inline void trackGLGen(GLObjectType type, PFNGLGENTEXTURESPROC gen, GLsizei count, GLuint* names, const char* file, int line) {
+	gen(count, names);
+	trackGLObjectsCreated(type, count, names, file, line);
+}
+
+inline void trackGLDelete(GLObjectType type, PFNGLDELETETEXTURESPROC del, GLsizei count, const GLuint* names, const char* file, int line) {
+	trackGLObjectsDeleted(type, count, names, file, line);
+	del(count, names);
+}
+
+inline void trackGLDeleteOne(GLObjectType type, PFNGLDELETESHADERPROC del, GLuint name, const char* file, int line) {
+	trackGLObjectsDeleted(type, 1, &name, file, line);
+	del(name);
+}
+
+#undef glCreateShader
+#undef glDeleteShader
+#undef glCreateProgram
+#undef glDeleteProgram
+#undef glGenBuffers
+#undef glDeleteBuffers
+#undef glGenTextures
+#undef glDeleteTextures
+#undef glGenFramebuffers
+#undef glDeleteFramebuffers
+#undef glGenVertexArrays
+#undef glDeleteVertexArrays
+#undef glGenSamplers
+#undef glDeleteSamplers
+
+#define glCreateShader(type) trackGLCreate(GL_OBJECT_SHADER, gl3wCreateShader(type), __FILE__, __LINE__)
+#define glDeleteShader(name) trackGLDeleteOne(GL_OBJECT_SHADER, gl3wDeleteShader, name, __FILE__, __LINE__)
+#define glCreateProgram() trackGLCreate(GL_OBJECT_PROGRAM, gl3wCreateProgram(), __FILE__, __LINE__)
+#define glDeleteProgram(name) trackGLDeleteOne(GL_OBJECT_PROGRAM, gl3wDeleteProgram, name, __FILE__, __LINE__)
+#define glGenBuffers(n, names) trackGLGen(GL_OBJECT_BUFFER, gl3wGenBuffers, n, names, __FILE__, __LINE__)
+#define glDeleteBuffers(n, names) trackGLDelete(GL_OBJECT_BUFFER, gl3wDeleteBuffers, n, names, __FILE__, __LINE__)
+#define glGenTextures(n, names) trackGLGen(GL_OBJECT_TEXTURE, gl3wGenTextures, n, names, __FILE__, __LINE__)
+#define glDeleteTextures(n, names) trackGLDelete(GL_OBJECT_TEXTURE, gl3wDeleteTextures, n, names, __FILE__, __LINE__)
+#define glGenFramebuffers(n, names) trackGLGen(GL_OBJECT_FRAMEBUFFER, gl3wGenFramebuffers, n, names, __FILE__, __LINE__)
+#define glDeleteFramebuffers(n, names) trackGLDelete(GL_OBJECT_FRAMEBUFFER, gl3wDeleteFramebuffers, n, names, __FILE__, __LINE__)
+#define glGenVertexArrays(n, names) trackGLGen(GL_OBJECT_VERTEX_ARRAY, gl3wGenVertexArrays, n, names, __FILE__, __LINE__)
+#define glDeleteVertexArrays(n, names) trackGLDelete(GL_OBJECT_VERTEX_ARRAY, gl3wDeleteVertexArrays, n, names, __FILE__, __LINE__)
+#define glGenSamplers(n, names) trackGLGen(GL_OBJECT_SAMPLER, gl3wGenSamplers, n, names, __FILE__, __LINE__)
+#define glDeleteSamplers(n, names) trackGLDelete(GL_OBJECT_SAMPLER, gl3wDeleteSamplers, n, names, __FILE__, __LINE__)
+
+#endif
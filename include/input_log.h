@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Recording of the per-frame inputs of an interactive session, so it can be
+ * replayed frame-exactly (eg. headless, for exports and benchmarks).
+ *
+ * File format, little endian:
+ *     header: "SHDI", uint32 version, uint32 width, uint32 height
+ *     frame:  float64 time, float32 mouseX, float32 mouseY, uint8 buttons,
+ *             uint8 keyEventCount, keyEventCount x (uint16 key, uint8 action)
+ */
+
+struct InputKeyEvent {
+	uint16_t key;
+	uint8_t action;
+};
+
+struct InputFrame {
+	double time;
+	float mouse[2];
+	// Bit n set while mouse button n is down
+	uint8_t buttons;
+	std::vector<InputKeyEvent> keys;
+};
+
+class InputRecorder {
+public:
+	InputRecorder():_file(NULL), _frames(0) {}
+	~InputRecorder() { close(); }
+
+	bool open(const char* path, int width, int height);
+	void record(const InputFrame& frame);
+	void close();
+
+	bool isRecording() const {
+		return _file != NULL;
+	}
+
+private:
+	FILE* _file;
+	size_t _frames;
+};
+
+class InputLog {
+public:
+	InputLog():_width(0), _height(0) {}
+
+	bool load(const char* path);
+
+	bool empty() const {
+		return _frames.empty();
+	}
+
+	size_t size() const {
+		return _frames.size();
+	}
+
+	const InputFrame& frame(size_t index) const {
+		return _frames[index];
+	}
+
+	/* Index of the last frame recorded at or before time (relative to the first frame) */
+	size_t frameAt(double time) const;
+
+	int getWidth() const {
+		return _width;
+	}
+
+	int getHeight() const {
+		return _height;
+	}
+
+	void swap(InputLog& other) {
+		_frames.swap(other._frames);
+		std::swap(_width, other._width);
+		std::swap(_height, other._height);
+	}
+
+private:
+	std::vector<InputFrame> _frames;
+	int _width;
+	int _height;
+};
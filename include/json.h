@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Minimal JSON document model, enough to read project files.  Lookups of
+ * missing keys or indices return a null value, so chains like
+ * json["Shader"]["renderpass"][0] never fail.
+ */
+class JsonValue {
+public:
+	enum Type {
+		NUL,
+		BOOLEAN,
+		NUMBER,
+		STRING,
+		ARRAY,
+		OBJECT
+	};
+
+	JsonValue():_type(NUL), _boolean(false), _number(0.0) {}
+
+	Type getType() const {
+		return _type;
+	}
+
+	bool isNull() const {
+		return _type == NUL;
+	}
+
+	bool isString() const {
+		return _type == STRING;
+	}
+
+	bool isArray() const {
+		return _type == ARRAY;
+	}
+
+	bool isObject() const {
+		return _type == OBJECT;
+	}
+
+	/* Number of array elements or object members */
+	size_t size() const;
+
+	const JsonValue& operator[](size_t index) const;
+	const JsonValue& operator[](int index) const {
+		return (*this)[(size_t)index];
+	}
+	const JsonValue& operator[](const char* key) const;
+
+	/* Converting accessors: numbers and strings read as each other, anything else gives fallback */
+	std::string asString(const std::string& fallback = std::string()) const;
+	double asNumber(double fallback = 0.0) const;
+	bool asBool(bool fallback = false) const;
+
+	/* Parses text into value, returns false with a message and position in error */
+	static bool parse(const std::string& text, JsonValue& value, std::string& error);
+
+private:
+	friend class JsonParser;
+
+	Type _type;
+	bool _boolean;
+	double _number;
+	std::string _string;
+	std::vector<JsonValue> _array;
+	std::vector<std::pair<std::string, JsonValue> > _object;
+};
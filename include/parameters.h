@@ -0,0 +1,184 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#include "shader.h"
+
+/**
+ * A user-tweakable uniform of the current fragment shader.
+ *
+ * Parameters are discovered through uniform reflection.  Hints for the UI are
+ * read from a trailing comment on the uniform's declaration line, eg.
+ *
+ *     uniform float speed = 1.0; // range(0.0, 10.0)
+ *     uniform vec3 tint;         // color
+ */
+struct ShaderParameter {
+	std::string name;
+	GLenum type;
+	GLint location;
+
+	bool hasRange;
+	float minValue;
+	float maxValue;
+	bool isColor;
+
+	float floatValue[4];
+	GLint intValue[4];
+
+	// Set when the value has changed and must be written to the program
+	bool dirty;
+	// Set once the user has edited the value, only those are kept over the initializer on reloads
+	bool edited;
+};
+
+class ParameterTable {
+public:
+	ParameterTable():_version(0) {}
+
+	/**
+	 * Rebuilds the table from the active uniforms of a freshly linked program.
+	 * Built-in uniforms are skipped.  Values the user edited in parameters seen
+	 * before (same name and type) are carried over and marked dirty, others
+	 * start from the initial value stored in the program.
+	 */
+	void reflect(const Program& program, const std::string& source);
+
+	/* Writes dirty parameters to the program, which must be in use */
+	void apply();
+
+	/* Takes the values of the parameters of the same name and type in another table, marking the changed ones */
+	void copyValues(const ParameterTable& from);
+
+	/**
+	 * Rewrites source with the current value of each parameter baked in as a
+	 * #define replacing its uniform declaration, so the compiler can fold
+	 * them as constants.  The generated #define lines are returned in defines
+	 * and identify the permutation.  Declarations it can't parse (several
+	 * uniforms on a line, or one split across lines) are left as uniforms.
+	 */
+	std::string bakeSource(const std::string& source, std::string& defines) const;
+
+	/* Flags a parameter whose value was edited */
+	void markChanged(ShaderParameter& param) {
+		param.dirty = true;
+		++_version;
+	}
+
+	/* Flags a parameter the user edited, so its value outlives reloads */
+	void markEdited(ShaderParameter& param) {
+		param.edited = true;
+		markChanged(param);
+	}
+
+	/* Flags every parameter, so apply() writes the whole table */
+	void markAllChanged() {
+		for(size_t i = 0; i < _parameters.size(); ++i) {
+			markChanged(_parameters[i]);
+		}
+	}
+
+	/* Incremented whenever the table is rebuilt or a value changes */
+	uint32_t getVersion() const {
+		return _version;
+	}
+
+	void clear() {
+		_parameters.clear();
+		_retained.clear();
+		++_version;
+	}
+
+	std::vector<ShaderParameter>& getParameters() {
+		return _parameters;
+	}
+
+	const std::vector<ShaderParameter>& getParameters() const {
+		return _parameters;
+	}
+
+	/* Number of components in a parameter of the given type, or 0 if unsupported */
+	static int componentCount(GLenum type);
+
+	static bool isIntegerType(GLenum type);
+
+private:
+	std::vector<ShaderParameter> _parameters;
+	std::map<std::string, ShaderParameter> _retained;
+	uint32_t _version;
+};
+
+/* Returns true for uniforms that Shade sets itself (iTime, iResolution, ...) */
+bool isBuiltinUniform(const std::string& name);
+
+/* Number of iChannelN texture inputs */
+#define CHANNEL_COUNT 4
+
+/**
+ * Values of the built-in uniforms for one frame.  Shade's own uniforms are
+ * iTime, iResolution (vec2) and iMouse (vec2, cursor position with y down);
+ * ShaderToy's (iResolution as vec3, iMouse as vec4, iFrame, iTimeDelta,
+ * iFrameRate, iDate, iSampleRate, iChannelTime) are set too when declared.
+ */
+struct FrameState {
+	double time;
+	float resolution[2];
+	float mouse[2];
+	// Size of the texture bound to each channel, 0 if unbound
+	float channelResolution[CHANNEL_COUNT][3];
+
+	int frame;
+	float timeDelta;
+	// Year, month (0-11), day and seconds since midnight
+	float date[4];
+	// ShaderToy's iMouse: xy position while a button is down, zw click position, y up, z < 0 once released, w < 0 after the click frame
+	float clickMouse[4];
+
+	FrameState():time(0.0), frame(0), timeDelta(0.0f) {
+		resolution[0] = resolution[1] = 0.0f;
+		mouse[0] = mouse[1] = 0.0f;
+		memset(channelResolution, 0, sizeof(channelResolution));
+		memset(date, 0, sizeof(date));
+		memset(clickMouse, 0, sizeof(clickMouse));
+	}
+};
+
+/**
+ * Built-in uniform values for frame N of an offline render at a fixed
+ * step of 1/fps, dated January 1st 2000 so every render of it is the same.
+ * Exports, batch renders and render server jobs all start from this.
+ */
+FrameState fixedStepFrameState(int frameNumber, int fps, int width, int height);
+
+/* Locations of the built-in uniforms in a program, -1 if unused */
+struct BuiltinUniforms {
+	GLint time;
+	GLint resolution;
+	GLint mouse;
+	GLint channel[CHANNEL_COUNT];
+	GLint channelResolution;
+
+	// ShaderToy declares iResolution as vec3 and iMouse as vec4
+	int resolutionComponents;
+	int mouseComponents;
+	GLint frameNumber;
+	GLint timeDelta;
+	GLint frameRate;
+	GLint date;
+	GLint sampleRate;
+	GLint channelTime;
+
+	BuiltinUniforms();
+
+	void locate(const Program& program);
+
+	/**
+	 * Writes the frame's values to the program, which must be in use.
+	 * iChannelN samples texture unit N.
+	 */
+	void set(const FrameState& frame) const;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <stdint.h>
+
+#include "shader.h"
+#include "parameters.h"
+
+/* A build of a fragment shader variant */
+struct Permutation {
+	enum State {
+		COMPILING,
+		READY,
+		FAILED
+	};
+
+	Shader* fragmentShader;
+	Program* program;
+	BuiltinUniforms builtins;
+	// Parameters with the values the program was linked with
+	ParameterTable parameters;
+	State state;
+	std::string error;
+	uint64_t lastUsed;
+	// Holders keeping it from being evicted, see PermutationCache::pin()
+	int pins;
+};
+
+/**
+ * Programs built from variants of fragment shader source, keyed by a string
+ * identifying the variant (eg. the set of baked #defines).  Builds are started
+ * without waiting on the driver and finished by poll(), so with parallel
+ * shader compile support they happen in the background while the app keeps
+ * rendering with another program.
+ */
+class PermutationCache {
+public:
+	PermutationCache(size_t capacity = 16):_capacity(capacity), _useCounter(0) {}
+	~PermutationCache() { clear(); }
+
+	/**
+	 * Returns the permutation for key, starting a build from source if it
+	 * isn't cached.  The vertex shader must outlive the cache entries.
+	 */
+	Permutation* request(const std::string& key, const Shader* vertexShader, const std::string& source);
+
+	/* Marks a permutation as used, so it's the last to be evicted */
+	void touch(Permutation* permutation) {
+		permutation->lastUsed = ++_useCounter;
+	}
+
+	/**
+	 * Keeps a permutation from being evicted while something holds on to it
+	 * across frames without touching it, eg. a view that isn't shown.  The
+	 * cache grows past its capacity rather than evict a pinned entry.
+	 */
+	void pin(Permutation* permutation) {
+		++permutation->pins;
+	}
+
+	void unpin(Permutation* permutation) {
+		--permutation->pins;
+	}
+
+	/* Finishes builds the driver has completed */
+	void poll();
+
+	/* Finishes a build, blocking until the driver is done with it */
+	void wait(Permutation* permutation);
+
+	/* Drops all permutations, eg. when the shader source changes */
+	void clear();
+
+	size_t size() const {
+		return _permutations.size();
+	}
+
+	/* Takes effect at the next build, entries over it aren't evicted before */
+	void setCapacity(size_t capacity) {
+		_capacity = capacity;
+	}
+
+private:
+	void evict();
+
+	std::map<std::string, Permutation> _permutations;
+	size_t _capacity;
+	uint64_t _useCounter;
+};
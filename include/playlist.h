@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/* Seconds a playlist entry is shown when its line gives no duration */
+#define DEFAULT_PLAYLIST_DURATION 30.0
+
+/* Seconds of the crossfade from one playlist entry to the next */
+#define DEFAULT_CROSSFADE_TIME 1.5
+
+struct PlaylistEntry {
+	std::string path;
+	double duration;
+};
+
+/**
+ * Reads a playlist: one shader file per line, optionally followed by the
+ * seconds to show it, eg.
+ *
+ *     # Lobby screens
+ *     tunnel.glsl 60
+ *     plasma.glsl
+ *
+ * Blank lines and lines starting with # are skipped, and relative paths are
+ * relative to the playlist's directory.
+ */
+bool loadPlaylist(const char* path, std::vector<PlaylistEntry>& entries);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include "render_target.h"
+
+/**
+ * Asynchronous readback of a render target through a ring of pixel buffer
+ * objects.  start() queues glReadPixels into the next PBO with a fence and
+ * returns immediately; the pixels are mapped a few frames later, once the GPU
+ * has finished, instead of stalling the pipeline like a plain glReadPixels.
+ */
+class AsyncReadback {
+public:
+	AsyncReadback():_width(0), _height(0), _bytesPerPixel(0), _format(GL_RGBA), _type(GL_UNSIGNED_BYTE), _head(0), _pending(0), _mapped(-1) {}
+	~AsyncReadback() { destroy(); }
+
+	/* Allocates depth PBOs for reads of width x height pixels in format/type */
+	bool init(int width, int height, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE, int depth = 3);
+	void destroy();
+
+	/**
+	 * Queues a read of the whole target, tagged for identification when it
+	 * completes.  Returns false if every PBO still holds an unconsumed read.
+	 */
+	bool start(const RenderTarget& target, uint64_t tag);
+
+	/**
+	 * Maps the oldest queued read if it has completed (or waits for it when
+	 * wait is true) and returns its pixels, bottom row first.  Returns NULL if
+	 * nothing is ready.  The pointer is valid until unmap().
+	 */
+	const uint8_t* map(uint64_t& tag, bool wait);
+	void unmap();
+
+	/* Number of reads queued and not yet mapped */
+	int pending() const {
+		return _pending;
+	}
+
+	size_t frameSize() const {
+		return (size_t)_width * _height * _bytesPerPixel;
+	}
+
+	int getWidth() const {
+		return _width;
+	}
+
+	int getHeight() const {
+		return _height;
+	}
+
+private:
+	AsyncReadback(const AsyncReadback&);
+	AsyncReadback& operator=(const AsyncReadback&);
+
+	struct Slot {
+		GLuint pbo;
+		GLsync fence;
+		uint64_t tag;
+	};
+
+	std::vector<Slot> _slots;
+	int _width;
+	int _height;
+	int _bytesPerPixel;
+	GLenum _format;
+	GLenum _type;
+	int _head;
+	int _pending;
+	int _mapped;
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "shader.h"
+#include "parameters.h"
+#include "channels.h"
+#include "render_target.h"
+
+/* Side of the textures rendered by cubemap passes */
+#define CUBEMAP_PASS_SIZE 1024
+
+/* Filtering and wrapping of a pass input, applied with a sampler object */
+struct SamplerSettings {
+	enum Filter {
+		NEAREST,
+		LINEAR,
+		MIPMAP
+	};
+
+	Filter filter;
+	bool repeat;
+
+	SamplerSettings():filter(LINEAR), repeat(false) {}
+};
+
+/* What a pass samples through one of its iChannelN */
+struct PassInput {
+	enum Source {
+		NONE,
+		CHANNEL,
+		PASS
+	};
+
+	Source source;
+	// CHANNEL: a channel input, owned by the graph if added with addChannel()
+	ChannelInput* channel;
+	// PASS: index of the pass whose output is read
+	int pass;
+	// PASS: read the output of the previous frame (a feedback loop) rather than this frame's
+	bool previousFrame;
+	SamplerSettings sampler;
+	GLuint samplerObject;
+
+	PassInput():source(NONE), channel(NULL), pass(-1), previousFrame(false), samplerObject(0) {}
+};
+
+/**
+ * One fullscreen draw of a multipass render.  Buffer and cubemap passes
+ * render into textures, the output pass into the destination framebuffer.
+ * Reads of this frame's output are the edges of the graph; reads of the
+ * previous frame's output give the producer a second texture to swap with.
+ */
+struct RenderPass {
+	enum Type {
+		OUTPUT,
+		BUFFER,
+		CUBEMAP
+	};
+
+	std::string name;
+	Type type;
+	std::string source;
+	PassInput inputs[CHANNEL_COUNT];
+
+	// Drawn with the app's own program (a single shader file) instead of one built from source
+	bool external;
+
+	// Output size relative to the graph's (buffers), or to CUBEMAP_PASS_SIZE (cubemaps)
+	float scale;
+	// Drawn every Nth frame, or with 0 only when an input changed
+	int updateInterval;
+
+	Shader* fragmentShader;
+	Program* program;
+	BuiltinUniforms builtins;
+	GLint cubeFace;
+
+	// Scheduling, set by RenderGraph::build()
+	// Position in the schedule, -1 if nothing drawn reads the output
+	int order;
+	// Reads time or input uniforms
+	bool varyingUniforms;
+	// Drawn every frame with varying uniforms, or reads such a pass, so changes every frame
+	bool timeVarying;
+	// Read as the previous frame's output, so it keeps two textures
+	bool history;
+	// Only read later in the same frame: its texture is shared with passes drawn outside that span
+	bool transient;
+	int slot;
+	// Set when a reader samples with mipmaps, which are then generated after each draw
+	bool mipmaps;
+
+	// Size of the output, set by RenderGraph::resize()
+	int width;
+	int height;
+
+	// BUFFER; both point to the same target unless history is set
+	RenderTarget* targets[2];
+	// CUBEMAP
+	GLuint cubeTextures[2];
+	GLuint cubeFramebuffer;
+	int current;
+
+	// Graph frames of the last draw and the one before (0 if none)
+	uint64_t lastDrawn;
+	uint64_t previousDrawn;
+	uint64_t drawCount;
+	uint64_t skipCount;
+
+	RenderPass();
+
+	/* Texture holding the latest output, 0 for the output pass */
+	GLuint getOutputTexture() const;
+	GLenum getOutputTarget() const {
+		return type == CUBEMAP ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	}
+
+private:
+	RenderPass(const RenderPass&);
+	RenderPass& operator=(const RenderPass&);
+};
+
+/**
+ * Passes and the channel inputs they read, drawn in dependency order.
+ *
+ * build() sorts the passes topologically by their reads of this frame's
+ * outputs (ties keep the order passes were added in) and drops passes the
+ * output doesn't depend on.  Buffers that change every frame and are only
+ * read within the frame share textures when their lifetimes don't overlap;
+ * the others keep their own textures, so a pass whose inputs and uniforms
+ * didn't change since its last draw can be skipped.  Passes can render at
+ * a fraction of the output size and on every Nth frame only; those on the
+ * same interval are spread over its frames by their position.
+ */
+class RenderGraph {
+public:
+	RenderGraph():_width(0), _height(0), _frame(0), _textureBytes(0) {}
+	~RenderGraph();
+
+	/* The graph owns the passes */
+	RenderPass* addPass(const std::string& name, RenderPass::Type type);
+
+	/* Takes ownership of a channel input read by passes */
+	ChannelInput* addChannel(ChannelInput* channel);
+
+	/**
+	 * Compiles and links every pass (in parallel where the driver can) and
+	 * schedules them.  Returns false with the logs in error, or if passes
+	 * read each other's output within a frame.
+	 */
+	bool build(const Shader* vertexShader, std::string& error);
+
+	/* Orders the passes and plans their storage again after changing their settings, call resize() next */
+	bool schedule(std::string& error);
+
+	/**
+	 * (Re)allocates buffer textures for an output size, contents start
+	 * cleared and every pass is drawn next frame.  Frames are counted again
+	 * from there, so passes on an interval take the same turns as on a load.
+	 */
+	bool resize(int width, int height);
+
+	/* Whether frames depend on earlier ones: a pass reads its previous output, or isn't drawn every frame */
+	bool carriesState() const;
+
+	/* Starts a frame, before the first needsDraw() */
+	void beginFrame();
+
+	/* Whether a pass must be drawn this frame, or can keep its output */
+	bool needsDraw(const RenderPass& pass) const;
+
+	/* Records the draw of a pass, making its new output current */
+	void markDrawn(RenderPass& pass);
+	void markSkipped(RenderPass& pass);
+
+	/* Texture bound for a PASS input, honoring previousFrame */
+	GLuint getInputTexture(const PassInput& input) const;
+
+	/* Size of what a pass samples through an input, 0x0 if unbound */
+	void getInputSize(const PassInput& input, int& width, int& height) const;
+
+	std::vector<RenderPass*>& getPasses() {
+		return _passes;
+	}
+
+	/* Passes in drawing order */
+	const std::vector<RenderPass*>& getSchedule() const {
+		return _schedule;
+	}
+
+	const std::vector<ChannelInput*>& getChannels() const {
+		return _channels;
+	}
+
+	int getWidth() const {
+		return _width;
+	}
+
+	int getHeight() const {
+		return _height;
+	}
+
+	/* Pass outputs allocated by resize(), and their size in bytes */
+	size_t getTextureCount() const {
+		return _targets.size() + countCubeTextures();
+	}
+
+	size_t getTextureBytes() const {
+		return _textureBytes;
+	}
+
+	/* Textures shared by transient passes */
+	int getSlotCount() const {
+		return (int)_slotScales.size();
+	}
+
+private:
+	RenderGraph(const RenderGraph&);
+	RenderGraph& operator=(const RenderGraph&);
+
+	size_t countCubeTextures() const;
+	uint64_t lastChanged(const ChannelInput* channel) const;
+	void destroyTargets();
+
+	std::vector<RenderPass*> _passes;
+	std::vector<RenderPass*> _schedule;
+	std::vector<ChannelInput*> _channels;
+	std::vector<RenderTarget*> _targets;
+	int _width;
+	int _height;
+	uint64_t _frame;
+	size_t _textureBytes;
+	// Scale of the passes sharing each slot
+	std::vector<float> _slotScales;
+	// Frame each channel read by a pass last changed
+	std::vector<std::pair<ChannelInput*, uint64_t> > _channelChanges;
+};
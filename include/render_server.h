@@ -0,0 +1,80 @@
+#pragma once
+
+/**
+ * Local render server (shade --serve PATH).
+ *
+ * Clients connect to the Unix domain socket at PATH and send one job per
+ * connection: header lines terminated by a "source" line, followed by the
+ * fragment shader source.
+ *
+ *     SHADE 1
+ *     width 256              (default 256)
+ *     height 256             (default 256)
+ *     frames 0-59            (default 0, see parseFrameList())
+ *     fps 60                 (default 60)
+ *     format png             (png or rgba, raw RGBA8 bottom row first)
+ *     uniform speed 2.5      (repeatable, 1-4 values, overrides initializers)
+ *     source 1234            (byte count of the source that follows)
+ *     <source bytes>
+ *
+ * The server answers with "OK <frame count>\n" followed by each frame as
+ * "FRAME <number> <width> <height> <byte count>\n<bytes>" as soon as it is
+ * rendered, then "DONE\n".  Errors are reported as "ERROR <byte count>\n"
+ * followed by the message (eg. the compile log), and close the connection.
+ *
+ * Jobs are rendered one at a time on the thread owning the GL context.
+ * Programs are cached by source, so repeated jobs skip compilation.
+ */
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "export.h"
+
+struct RenderJob {
+	int client;
+	std::string source;
+	int width;
+	int height;
+	ExportSettings settings;
+	bool png;
+	std::vector<std::pair<std::string, std::vector<float> > > uniforms;
+	double queuedTime;
+};
+
+/**
+ * Jobs waiting to be rendered.  Small jobs are picked first to keep their
+ * latency low, but a job that has waited longer than maxWait seconds goes
+ * next regardless of size.
+ */
+class RenderJobQueue {
+public:
+	RenderJobQueue(double maxWait = 1.0):_maxWait(maxWait) {}
+
+	void push(const RenderJob& job) {
+		_jobs.push_back(job);
+	}
+
+	/* Removes the next job to render, returns false if the queue is empty */
+	bool pop(RenderJob& job, double now);
+
+	bool empty() const {
+		return _jobs.empty();
+	}
+
+	size_t size() const {
+		return _jobs.size();
+	}
+
+private:
+	std::deque<RenderJob> _jobs;
+	double _maxWait;
+};
+
+/**
+ * Reads a job request from a connected client.  Returns false with a message
+ * in error if the request is malformed.
+ */
+bool readRenderJob(int client, RenderJob& job, std::string& error);
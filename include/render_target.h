@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "shader.h"
+
+/* An offscreen framebuffer with a single color texture */
+class RenderTarget {
+public:
+	RenderTarget():_fbo(0), _texture(0), _width(0), _height(0), _internalFormat(GL_RGBA8) {}
+	~RenderTarget() { destroy(); }
+
+	/* (Re)allocates the target, returns false if the framebuffer is incomplete */
+	bool create(int width, int height, GLenum internalFormat = GL_RGBA8);
+	void destroy();
+
+	/* Names the texture and framebuffer in GL debug output and captures */
+	void setLabel(const std::string& label) const;
+
+	/* Binds the framebuffer and sets the viewport to cover it */
+	void bind() const;
+	static void unbind();
+
+	/* Reads the color buffer back as tightly packed RGBA8, bottom row first */
+	void readPixels(std::vector<uint8_t>& pixels) const;
+
+	GLuint getFramebuffer() const {
+		return _fbo;
+	}
+
+	GLuint getTexture() const {
+		return _texture;
+	}
+
+	int getWidth() const {
+		return _width;
+	}
+
+	int getHeight() const {
+		return _height;
+	}
+
+	GLenum getInternalFormat() const {
+		return _internalFormat;
+	}
+
+private:
+	RenderTarget(const RenderTarget&);
+	RenderTarget& operator=(const RenderTarget&);
+
+	GLuint _fbo;
+	GLuint _texture;
+	int _width;
+	int _height;
+	GLenum _internalFormat;
+};
+
+/* Writes RGBA8 pixels (bottom row first, as read from GL) to a PNG file */
+bool writePNG(const char* path, int width, int height, const std::vector<uint8_t>& pixels);
+
+/* Same as writePNG(), to memory */
+bool encodePNG(int width, int height, const std::vector<uint8_t>& pixels, std::vector<uint8_t>& png);
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "channels.h"
+
+/**
+ * A numbered image sequence as a channel texture, eg. frames/shot_%05d.png
+ * with image N shown at iTime N / fps.
+ *
+ * A pool of threads decodes images with stb_image ahead of the shader clock
+ * into a bounded cache, evicting the least recently used frames outside the
+ * read-ahead window.  Decoded frames are uploaded through a PBO.  Frames that
+ * aren't decoded yet are held interactively and waited for offline.
+ */
+class ImageSequenceChannel : public ChannelInput {
+public:
+	static const int READ_AHEAD = 16;
+	static const size_t CACHE_FRAMES = 48;
+
+	ImageSequenceChannel();
+	~ImageSequenceChannel();
+
+	/* pattern is a printf format with one integer conversion */
+	bool init(const char* pattern, double fps);
+
+	void update(const FrameState& frame);
+	void setOffline(bool offline) {
+		_offline = offline;
+	}
+
+	GLuint getTexture() const {
+		return _texture.getTexture();
+	}
+
+	int getWidth() const {
+		return _texture.getWidth();
+	}
+
+	int getHeight() const {
+		return _texture.getHeight();
+	}
+
+private:
+	ImageSequenceChannel(const ImageSequenceChannel&);
+	ImageSequenceChannel& operator=(const ImageSequenceChannel&);
+
+	struct CachedFrame {
+		enum State {
+			LOADING,
+			READY,
+			MISSING
+		};
+
+		State state;
+		int width;
+		int height;
+		std::vector<uint8_t> rgba;
+		uint64_t lastUsed;
+	};
+
+	void workerLoop();
+	/* Queues decodes for the read-ahead window and drops queued ones outside it, with the lock held */
+	void schedule(int64_t first);
+	void evict(int64_t first);
+
+	std::string _pattern;
+	double _fps;
+	StreamingTexture _texture;
+	int64_t _shown;
+	bool _offline;
+	bool _missing;
+
+	std::vector<std::thread> _workers;
+	std::mutex _mutex;
+	std::condition_variable _work;
+	std::condition_variable _done;
+	std::deque<int64_t> _tasks;
+	std::map<int64_t, CachedFrame> _cache;
+	uint64_t _useCounter;
+	bool _stop;
+};
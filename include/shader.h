@@ -1,8 +1,11 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <loguru/loguru.hpp>
 #include <GL/gl3w.h>
+#include "gl_objects.h"
+#include "gl_debug.h"
 
 #if CHECK_OPENGL
 #if __APPLE__
@@ -27,25 +30,62 @@ inline void __checkGLError(const char* stmt, const char* fname, int line) {
     }
 }
 
+// Polling glGetError syncs with the driver, debug output reports the same errors without it
 #define CHECK_GL(stmt) \
     do { \
         stmt; \
-        __checkGLError(#stmt, __FILE__, __LINE__); \
+        if(!isGLDebugOutputEnabled()) __checkGLError(#stmt, __FILE__, __LINE__); \
     } while (0)
 #else
 #define CHECK_GL(stmt) stmt
 #endif
 
+// From ARB/KHR_parallel_shader_compile, which gl3w doesn't know about
+#ifndef GL_COMPLETION_STATUS_ARB
+#define GL_COMPLETION_STATUS_ARB 0x91B1
+#endif
+
+/**
+ * Checks for (ARB|KHR)_parallel_shader_compile.  When available, compiles and
+ * links started with startCompile()/startLink() proceed on driver threads and
+ * can be polled without blocking.
+ */
+bool isParallelShaderCompileSupported();
+
 class Shader {
 public:
+	Shader():_id(0) {}
 	~Shader() { if(_id != 0) CHECK_GL(glDeleteShader(_id)); }
 	bool compile(GLenum shaderType, const std::string& sourceFile);
 	bool compile(GLenum shaderType, GLint size, const GLchar* data, const char* filename);
+
+	/* Split compile: startCompile() doesn't wait on the driver, checkCompileStatus() does */
+	void startCompile(GLenum shaderType, GLint size, const GLchar* data);
+	bool startCompile(GLenum shaderType, const std::string& sourceFile);
+	bool checkCompileStatus(const char* filename);
+
 	GLuint getID() const {
 		return _id;
 	}
+	const std::string& getSource() const {
+		return _source;
+	}
+	/* Compiler output of the last failed compile */
+	const std::string& getInfoLog() const {
+		return _infoLog;
+	}
 private:
 	GLuint _id;
+	std::string _source;
+	std::string _infoLog;
+};
+
+/* An active uniform as reported by glGetActiveUniform */
+struct UniformInfo {
+	std::string name;
+	GLenum type;
+	GLint size;
+	GLint location;
 };
 
 class Program {
@@ -74,10 +114,24 @@ public:
 
 	bool link() const;
 
+	/* Split link, see Shader::startCompile() */
+	void startLink() const;
+	bool isLinkComplete() const;
+	bool checkLinkStatus() const;
+
 	void use() const;
 
+	/* Enumerates the active uniforms of the linked program */
+	std::vector<UniformInfo> getActiveUniforms() const;
+
+	/* Linker output of the last failed link */
+	const std::string& getInfoLog() const {
+		return _infoLog;
+	}
+
 private:
 	const Shader* _vertex;
 	const Shader* _fragment;
 	GLuint _id;
+	mutable std::string _infoLog;
 };
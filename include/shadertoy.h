@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "render_graph.h"
+
+/**
+ * Import of projects exported from ShaderToy (the JSON of the "Shader"
+ * API, or of a saved page).  Buffer passes are drawn in name order, then
+ * the cubemap pass, then the image pass; common code is prepended to every
+ * pass.  Texture inputs are loaded from files next to the project, by the
+ * base name of their ShaderToy path or the full path below the project
+ * directory.  Sound passes and music, webcam and microphone inputs aren't
+ * supported and are left unbound.
+ */
+
+/* Fills graph with the passes and channel inputs of a project, false with a message in error */
+bool loadShaderToyProject(const char* path, RenderGraph& graph, std::string& error);
+
+/* Whether a file is loaded as a ShaderToy project rather than a fragment shader */
+bool isShaderToyProject(const char* path);
+
+/**
+ * Whether frames of a project depend on earlier ones (see
+ * RenderGraph::carriesState()), read from the JSON alone so it works
+ * without a GL context.  Passes the output doesn't read count too.
+ */
+bool shaderToyProjectCarriesState(const char* path);
+
+/**
+ * Wraps the code of a ShaderToy pass, which defines mainImage() (or
+ * mainCubemap() for cubemap passes), into a complete fragment shader
+ * declaring ShaderToy's uniforms.  channelTypes holds the sampler type of
+ * each iChannelN.  The output pass is opaque, as on the site.
+ */
+std::string buildShaderToyPass(const std::string& common, const std::string& code, RenderPass::Type type, const GLenum channelTypes[CHANNEL_COUNT]);
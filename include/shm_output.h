@@ -0,0 +1,87 @@
+#pragma once
+
+/**
+ * Publishes rendered frames into a POSIX shared-memory ring buffer that other
+ * processes can map and read without copies, encoding or sockets.
+ *
+ * The object named NAME (see shm_open) starts with a ShmRingHeader padded to
+ * 4096 bytes, followed by slotCount slots of slotSize bytes.  Each slot is a
+ * ShmFrameHeader with the pixels (bottom row first, as rendered by GL)
+ * starting headerSize bytes into the slot, so they're page aligned too.
+ *
+ * Consumers wait for new frames with FUTEX_WAIT on ShmRingHeader::sequence
+ * (a shared, non-private futex), then read slot latestSlot.  The
+ * slot's seqlock is odd while the slot is being written; a consumer should
+ * re-check it after copying or processing to detect a frame overwritten
+ * underneath it.
+ */
+
+#include <stdint.h>
+#include <string>
+
+#define SHADE_SHM_MAGIC 0x45444853 // "SHDE"
+#define SHADE_SHM_VERSION 1
+
+enum ShmPixelFormat {
+	SHM_FORMAT_RGBA8 = 1,
+	SHM_FORMAT_RGBA32F = 2
+};
+
+struct ShmRingHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t slotSize;
+	uint32_t headerSize;
+	// Futex word, incremented and woken after every published frame
+	uint32_t sequence;
+	uint32_t latestSlot;
+	uint64_t latestFrame;
+};
+
+struct ShmFrameHeader {
+	uint32_t seqlock;
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+	uint32_t reserved;
+	uint64_t frameIndex;
+	// CLOCK_MONOTONIC at publication
+	uint64_t timestampNs;
+};
+
+class ShmFrameOutput {
+public:
+	ShmFrameOutput():_fd(-1), _base(nullptr), _mappedSize(0), _published(0) {}
+	~ShmFrameOutput() { close(); }
+
+	/* Creates (or replaces) the shared-memory object, sized for frames of width x height */
+	bool open(const char* name, int width, int height, ShmPixelFormat format, int slotCount = 4);
+	void close();
+
+	/* Copies a frame into the next slot and wakes waiting consumers */
+	void publish(const uint8_t* pixels, uint64_t frameIndex);
+
+	bool isOpen() const {
+		return _base != nullptr;
+	}
+
+private:
+	ShmFrameOutput(const ShmFrameOutput&);
+	ShmFrameOutput& operator=(const ShmFrameOutput&);
+
+	ShmRingHeader* header() const {
+		return (ShmRingHeader*)_base;
+	}
+
+	std::string _name;
+	int _fd;
+	uint8_t* _base;
+	size_t _mappedSize;
+	uint64_t _published;
+	uint32_t _width;
+	uint32_t _height;
+	uint32_t _stride;
+	uint32_t _format;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+/* Output of a sound shader render (shade --sound FILE SHADER) */
+struct SoundSettings {
+	std::string output;
+	double duration;
+	int sampleRate;
+};
+
+/* Stereo samples rendered per draw, one per texel of a SOUND_BLOCK_WIDTH x SOUND_BLOCK_HEIGHT RG32F target */
+#define SOUND_BLOCK_WIDTH 512
+#define SOUND_BLOCK_HEIGHT 512
+
+/**
+ * Wraps the source of a ShaderToy sound shader, which defines
+ * vec2 mainSound(int samp, float time) (or the older mainSound(float time)),
+ * into a fragment shader writing the sample of each texel of a block.  The
+ * wrapper declares iSampleRate and iBlockOffset, the index of the block's
+ * first sample.  Returns an empty string if there is no mainSound().
+ */
+std::string buildSoundShader(const std::string& source);
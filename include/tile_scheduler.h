@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <GL/gl3w.h>
+
+/* GPU milliseconds per frame the grid of views may spend drawing tiles */
+#define DEFAULT_TILE_BUDGET_MS 8.0
+
+/* Cost assumed for tiles not measured yet, or without timer queries */
+#define DEFAULT_TILE_COST_MS 1.0
+
+/**
+ * Picks which tiles of a grid to redraw each frame so their GPU time stays
+ * within a budget; the others keep showing their last image.  Tiles are
+ * taken round-robin from where the previous frame stopped, as many as fit
+ * by their estimated cost, and at least one so every tile keeps updating.
+ *
+ * Costs are measured with pairs of GL_TIMESTAMP queries around each draw
+ * (timestamps, unlike GL_TIME_ELAPSED, can be taken while the frame's own
+ * elapsed time query is active) and read back once done, without stalling.
+ * A tile is timed again once its last result is in.  Without OpenGL 3.3
+ * every tile is assumed to cost DEFAULT_TILE_COST_MS.
+ */
+class TileScheduler {
+public:
+	TileScheduler():_budgetMs(DEFAULT_TILE_BUDGET_MS), _next(0), _plannedMs(0.0) {}
+	~TileScheduler() { destroy(); }
+
+	void setBudget(double ms) {
+		_budgetMs = ms;
+	}
+
+	double getBudget() const {
+		return _budgetMs;
+	}
+
+	/* Fills tiles with the indices of the tiles to draw this frame, out of count */
+	void schedule(size_t count, std::vector<size_t>& tiles);
+
+	/* Bracket the GL commands drawing a scheduled tile */
+	void beginTile(size_t tile);
+	void endTile(size_t tile);
+
+	/* Forgets the cost of a tile, eg. when it draws with a new program */
+	void invalidate(size_t tile);
+
+	/* Estimated GPU milliseconds of a tile, negative until measured */
+	double getCost(size_t tile) const {
+		return tile < _tiles.size() && _tiles[tile].measured ? _tiles[tile].cost : -1.0;
+	}
+
+	/* Estimated cost of the tiles scheduled for the current frame */
+	double getPlannedMs() const {
+		return _plannedMs;
+	}
+
+	/* Deletes the queries, while the context is current */
+	void destroy();
+
+private:
+	TileScheduler(const TileScheduler&);
+	TileScheduler& operator=(const TileScheduler&);
+
+	struct Tile {
+		GLuint queries[2];
+		bool started;
+		bool timing;
+		bool measured;
+		double cost;
+	};
+
+	void collect();
+
+	std::vector<Tile> _tiles;
+	double _budgetMs;
+	size_t _next;
+	double _plannedMs;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "channels.h"
+#include "y4m.h"
+
+/**
+ * A video as a channel texture.  Y4M files are read directly, anything else
+ * is piped through ffmpeg.  A decoder thread converts frames to RGBA ahead of
+ * the shader clock into a bounded queue; update() takes the frame for iTime
+ * and uploads it through a PBO.
+ *
+ * Interactively the render loop never waits: late frames are dropped, and
+ * when the decoder falls behind the last frame is held.  Files loop and can
+ * be seeked; piped videos hold their last frame once they end, and going
+ * back restarts ffmpeg and decodes forward.  Offline renders wait for the
+ * exact frame.
+ */
+class VideoChannel : public ChannelInput {
+public:
+	// Decoded frames queued ahead of the shader clock
+	static const size_t QUEUE_DEPTH = 8;
+
+	VideoChannel();
+	~VideoChannel();
+
+	bool init(const char* path);
+
+	void update(const FrameState& frame);
+	void setOffline(bool offline) {
+		_offline = offline;
+	}
+
+	GLuint getTexture() const {
+		return _texture.getTexture();
+	}
+
+	int getWidth() const {
+		return _texture.getWidth();
+	}
+
+	int getHeight() const {
+		return _texture.getHeight();
+	}
+
+private:
+	VideoChannel(const VideoChannel&);
+	VideoChannel& operator=(const VideoChannel&);
+
+	struct Frame {
+		int64_t index;
+		std::vector<uint8_t> rgba;
+	};
+
+	void decodeLoop();
+	/* Restarts decoding at frame index, with the lock held */
+	void requestSeek(int64_t index);
+
+	Y4MReader _reader;
+	// Read from the reader in init(), it reopens the stream while the decoder seeks a pipe
+	double _frameRate;
+	bool _seekable;
+	StreamingTexture _texture;
+	int64_t _shown;
+	bool _offline;
+
+	std::thread _decoder;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::deque<Frame> _queue;
+	// Buffers of consumed frames, reused by the decoder
+	std::vector<std::vector<uint8_t> > _free;
+	int64_t _nextIndex;
+	int64_t _seekTo;
+	bool _ended;
+	bool _stop;
+};
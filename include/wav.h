@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Streaming reader for RIFF WAVE files: 8, 16, 24 and 32 bit integer PCM and
+ * 32 bit float, any number of channels.  Frames are decoded on demand and
+ * downmixed to mono floats in [-1, 1].
+ */
+class WavReader {
+public:
+	WavReader():_file(NULL), _sampleRate(0), _channels(0), _bitsPerSample(0), _isFloat(false), _dataOffset(0), _frameCount(0) {}
+	~WavReader() { close(); }
+
+	bool open(const char* path);
+	void close();
+
+	/* Decodes up to count frames starting at frame, returns the number decoded */
+	size_t read(uint64_t frame, float* mono, size_t count);
+
+	int getSampleRate() const {
+		return _sampleRate;
+	}
+
+	int getChannels() const {
+		return _channels;
+	}
+
+	uint64_t getFrameCount() const {
+		return _frameCount;
+	}
+
+private:
+	WavReader(const WavReader&);
+	WavReader& operator=(const WavReader&);
+
+	FILE* _file;
+	int _sampleRate;
+	int _channels;
+	int _bitsPerSample;
+	bool _isFloat;
+	long _dataOffset;
+	uint64_t _frameCount;
+};
+
+/**
+ * Writes 16 bit stereo PCM WAV files.  The length is given up front so the
+ * header is final and the file can be streamed, eg. to stdout (path "-").
+ */
+class WavWriter {
+public:
+	WavWriter():_file(NULL), _frames(0) {}
+	~WavWriter() { close(); }
+
+	bool open(const char* path, int sampleRate, uint64_t frameCount);
+	void close();
+
+	/* Writes interleaved stereo frames, clamping to [-1, 1] */
+	bool write(const float* stereo, size_t count);
+
+private:
+	WavWriter(const WavWriter&);
+	WavWriter& operator=(const WavWriter&);
+
+	FILE* _file;
+	uint64_t _frames;
+	std::vector<int16_t> _buffer;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Reader for YUV4MPEG2 streams, from a file or a pipe (eg. ffmpeg with
+ * -f yuv4mpegpipe).  Frames are converted to RGBA8, bottom row first as GL
+ * expects.  Supports 4:2:0, 4:2:2, 4:4:4 and mono 8 bit, BT.601 limited range.
+ */
+class Y4MReader {
+public:
+	Y4MReader():_file(NULL), _pipe(false), _width(0), _height(0), _fpsNum(0), _fpsDen(1), _chroma(CHROMA_420), _dataOffset(0), _frameCount(0), _position(0), _ffmpeg(0) {}
+	~Y4MReader() { close(); }
+
+	bool open(const char* path);
+	/* Decodes any video ffmpeg can read by piping it through ffmpeg as Y4M */
+	bool openWithFFmpeg(const char* path);
+	void close();
+
+	/* Decodes the next frame into rgba (width * height * 4 bytes), false at the end */
+	bool readFrame(uint8_t* rgba);
+
+	/* Positions the reader on a frame; pipes restart ffmpeg when going back and decode forward to it */
+	bool seek(uint64_t frame);
+
+	/* Whether seeking is random access, rather than decoding every frame up to the target */
+	bool isSeekable() const {
+		return !_pipe;
+	}
+
+	int getWidth() const {
+		return _width;
+	}
+
+	int getHeight() const {
+		return _height;
+	}
+
+	double getFrameRate() const {
+		return (double)_fpsNum / _fpsDen;
+	}
+
+	/* 0 when unknown, ie. for pipes */
+	uint64_t getFrameCount() const {
+		return _frameCount;
+	}
+
+private:
+	Y4MReader(const Y4MReader&);
+	Y4MReader& operator=(const Y4MReader&);
+
+	enum Chroma {
+		CHROMA_420,
+		CHROMA_422,
+		CHROMA_444,
+		CHROMA_MONO
+	};
+
+	bool readHeader(const char* path);
+	size_t frameDataSize() const;
+	/* Reads the next frame's YUV data into _yuv */
+	bool readFrameData();
+
+	FILE* _file;
+	bool _pipe;
+	int _width;
+	int _height;
+	int _fpsNum;
+	int _fpsDen;
+	Chroma _chroma;
+	long _dataOffset;
+	uint64_t _frameCount;
+	// Index of the next frame read
+	uint64_t _position;
+	std::string _path;
+	// Process id of the ffmpeg writing into the pipe, 0 when there's none
+	int _ffmpeg;
+	std::vector<uint8_t> _yuv;
+};
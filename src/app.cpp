@@ -1,6 +1,12 @@
 #include "app.h"
 
 #include "builtins.h"
+#include "shadertoy.h"
+
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
 
 static void error_callback(int error, const char* description) {
     LOG_F(ERROR, "Error %d: %s\n", error, description);
@@ -14,20 +20,72 @@ ShadeApp::ShadeApp() {
 	_builtinDefaultShader = nullptr;
 	_builtinErrorShader = nullptr;
 	_currentShaderFile = nullptr;
+	_window = nullptr;
+	_headless = false;
+	_frameCount = 0;
+	_lastFrameTime = 0.0;
+	_lastFilePollTime = 0.0;
+	_viewWidth = 0;
+	_viewHeight = 0;
+	_resizePending = false;
+	_resizeTime = 0.0;
+	_fullscreen = false;
+	_fullscreenMonitor = -1;
+	memset(_windowedRect, 0, sizeof(_windowedRect));
+	memset(_clickMouse, 0, sizeof(_clickMouse));
+	_mouseWasDown = false;
+	_graph = nullptr;
+	_projectLoaded = false;
+	_vao = 0;
+	_vertexBuffer = 0;
+	_indexBuffer = 0;
+	_replaySpeed = 1.0;
+	_replayStartTime = 0.0;
+	_replayFrame = 0;
+	for(int i = 0; i < CHANNEL_COUNT; ++i) {
+		_channels[i] = nullptr;
+	}
     _showFramerate = true;
+    _showParameters = true;
+    _showGraph = false;
+    _showFrameStats = false;
+    _showViews = false;
+    _playlistCurrent = 0;
+    _crossfadeTime = DEFAULT_CROSSFADE_TIME;
+    _fadeStart = -1.0;
+    _frameStatsWindow = FrameStats::LAST_10_SECONDS;
+    _bakedPermutation = nullptr;
+    _bakeParameters = false;
+    _bakePending = false;
+    _bakedVersion = 0;
+    _bakeRequestTime = 0.0;
 }
 
 ShadeApp::~ShadeApp() {
+	for(int i = 0; i < CHANNEL_COUNT; ++i) {
+		delete _channels[i];
+	}
+	delete _graph;
+	stopPlaylist();
+	clearViews();
 	cleanupShaders(true);
+	_pacer.reset();
+	_frameStats.reset();
+	if(_vao != 0) {
+		glDeleteBuffers(1, &_vertexBuffer);
+		glDeleteBuffers(1, &_indexBuffer);
+		glDeleteVertexArrays(1, &_vao);
+	}
 }
 
-bool ShadeApp::init(const char* title, uint16_t width, uint16_t height) {
+bool ShadeApp::init(const char* title, uint16_t width, uint16_t height, bool headless) {
 	_windowWidth = width;
 	_windowHeight = height;
+	_headless = headless;
 	if(!setupGLFW(title)) return false;
 	if(!setupGLObjects()) return false;
 	if(!loadBuiltins()) return false;
-	initUI();
+	if(!_headless) initUI();
 	return true;
 }
 
@@ -55,10 +113,18 @@ bool ShadeApp::setupGLObjects() {
     CHECK_GL(glDisableVertexAttribArray(1));
     CHECK_GL(glBindVertexArray(0));
 
+    labelGLObject(GL_VERTEX_ARRAY, _vao, "Fullscreen quad");
+    labelGLObject(GL_BUFFER, _vertexBuffer, "Fullscreen quad vertices");
+    labelGLObject(GL_BUFFER, _indexBuffer, "Fullscreen quad indices");
+
     return true;
 }
 
 void ShadeApp::cleanupShaders(bool cleanupBuiltins) {
+	// Permutations are built from the fragment shader being replaced
+	_permutations.clear();
+	_bakedPermutation = nullptr;
+
 	if(cleanupBuiltins) {
 		if(_builtinVertexShader) {
 			if (_vertexShader == _builtinVertexShader) {
@@ -121,6 +187,7 @@ bool ShadeApp::loadBuiltins() {
 		cleanupShaders(true);
 		return false;
 	}
+	labelGLObject(GL_PROGRAM, _program->getID(), "<built-in default>");
 
 	_vertexShader = _builtinVertexShader;
 	_fragmentShader = _builtinDefaultShader;
@@ -143,14 +210,436 @@ bool ShadeApp::relinkProgram() {
     }
     
     _program = program;
+    labelGLObject(GL_PROGRAM, _program->getID(), _fragmentShader == _builtinErrorShader ? "<built-in error>" :
+        (_fragmentShader == _builtinDefaultShader || !_currentShaderFile ? "<built-in default>" : _currentShaderFile));
+
+    _builtinUniforms.locate(*_program);
 
-    _uniform_Time = glGetUniformLocation(_program->getID(), "iTime");
-    _uniform_Resolution = glGetUniformLocation(_program->getID(), "iResolution");
-    _uniform_Mouse = glGetUniformLocation(_program->getID(), "iMouse");
+    _parameters.reflect(*_program, _fragmentShader->getSource());
 
     return true;
 }
 
+/* Keeps the baked permutation in sync with the parameter values */
+void ShadeApp::updateBakedPermutation() {
+    _permutations.poll();
+
+    if(!_bakeParameters || _parameters.getParameters().empty()) {
+        _bakedPermutation = nullptr;
+        _bakePending = false;
+        _bakedVersion = _parameters.getVersion();
+        return;
+    }
+
+    // Render with uniforms while values are being tweaked, and rebake once they settle
+    if(_bakedVersion != _parameters.getVersion() || (!_bakedPermutation && !_bakePending)) {
+        _bakedVersion = _parameters.getVersion();
+        _bakedPermutation = nullptr;
+        _bakePending = true;
+        _bakeRequestTime = glfwGetTime() + 0.5;
+    }
+
+    if(_bakePending && glfwGetTime() >= _bakeRequestTime) {
+        std::string defines;
+        std::string source = _parameters.bakeSource(_fragmentShader->getSource(), defines);
+        _bakedPermutation = _permutations.request(defines, _vertexShader, source);
+        _bakePending = false;
+    }
+}
+
+/* Year, month (0-11), day and seconds since midnight, as ShaderToy's iDate */
+static void currentDate(float date[4]) {
+    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+    time_t seconds = std::chrono::system_clock::to_time_t(now);
+    double fraction = std::chrono::duration<double>(now - std::chrono::system_clock::from_time_t(seconds)).count();
+    struct tm local = *localtime(&seconds);
+    date[0] = (float)(local.tm_year + 1900);
+    date[1] = (float)local.tm_mon;
+    date[2] = (float)local.tm_mday;
+    date[3] = (float)(local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec + fraction);
+}
+
+/* Built-in uniform values for the next interactive frame */
+FrameState ShadeApp::sampleFrameState() {
+    InputFrame input;
+    if(!_replay.empty()) {
+        input = nextReplayFrame();
+    } else {
+        input.time = glfwGetTime();
+        double x, y;
+        int width, height;
+        glfwGetCursorPos(_window, &x, &y);
+        glfwGetWindowSize(_window, &width, &height);
+        // From screen coordinates below the menu bar to render pixels, which differ on HiDPI
+        // screens, until a resize settles, and when the window shows a fixed-size shm output
+        int areaHeight = height - MENUBAR_HEIGHT;
+        input.mouse[0] = width > 0 ? (float)x * _windowWidth / width : 0.0f;
+        input.mouse[1] = areaHeight > 0 ? ((float)y - MENUBAR_HEIGHT) * _windowHeight / areaHeight : 0.0f;
+        input.buttons = 0;
+        // Clicks on the UI aren't clicks on the shader
+        if(_headless || !ImGui::GetIO().WantCaptureMouse) {
+            for(int b = 0; b < 8; ++b) {
+                if(glfwGetMouseButton(_window, b) == GLFW_PRESS) input.buttons |= 1 << b;
+            }
+        }
+        input.keys.swap(_pendingKeys);
+        _pendingKeys.clear();
+        _recorder.record(input);
+    }
+    applyInput(input);
+
+    FrameState frame;
+    frame.time = input.time;
+    frame.resolution[0] = (float)_windowWidth;
+    frame.resolution[1] = (float)_windowHeight;
+    frame.mouse[0] = input.mouse[0];
+    frame.mouse[1] = input.mouse[1];
+    frame.frame = (int)_frameCount;
+    frame.timeDelta = _frameCount > 0 ? (float)(input.time - _lastFrameTime) : 0.0f;
+    _lastFrameTime = input.time;
+    currentDate(frame.date);
+    memcpy(frame.clickMouse, _clickMouse, sizeof(_clickMouse));
+    return frame;
+}
+
+/* Built-in uniform values for an exported frame */
+FrameState ShadeApp::exportFrameState(int frameNumber, int fps) {
+    FrameState frame = fixedStepFrameState(frameNumber, fps, _windowWidth, _windowHeight);
+    if(!_replay.empty()) {
+        // Exported frame N is recorded frame N
+        size_t index = (size_t)frameNumber < _replay.size() ? frameNumber : _replay.size() - 1;
+        const InputFrame& input = _replay.frame(index);
+
+        // Key and click state depend on every earlier frame, start over when exporting out of order
+        if(index + 1 < _replayFrame) {
+            std::vector<ChannelInput*> channels = getChannelInputs();
+            for(size_t i = 0; i < channels.size(); ++i) {
+                channels[i]->reset();
+            }
+            memset(_clickMouse, 0, sizeof(_clickMouse));
+            _mouseWasDown = false;
+            _replayFrame = 0;
+        }
+        for(; _replayFrame <= index; ++_replayFrame) {
+            applyInput(_replay.frame(_replayFrame));
+        }
+
+        frame.time = input.time;
+        frame.date[3] = (float)frame.time;
+        frame.mouse[0] = input.mouse[0];
+        frame.mouse[1] = input.mouse[1];
+        memcpy(frame.clickMouse, _clickMouse, sizeof(_clickMouse));
+    }
+    return frame;
+}
+
+/* Advances the replay, ending the run loop after the last recorded frame */
+InputFrame ShadeApp::nextReplayFrame() {
+    if(_replayFrame == 0 && _frameCount == 0) {
+        _replayStartTime = glfwGetTime();
+    }
+
+    size_t index = _replayFrame;
+    if(_replaySpeed > 0.0) {
+        index = _replay.frameAt((glfwGetTime() - _replayStartTime) * _replaySpeed);
+        if(index < _replayFrame) index = _replayFrame;
+    }
+
+    // Key events of frames skipped at high speed still have to be delivered
+    InputFrame input = _replay.frame(index);
+    input.keys.clear();
+    for(size_t i = _replayFrame; i <= index; ++i) {
+        const std::vector<InputKeyEvent>& keys = _replay.frame(i).keys;
+        input.keys.insert(input.keys.end(), keys.begin(), keys.end());
+    }
+    _replayFrame = index + 1;
+
+    if(_replayFrame >= _replay.size()) {
+        double elapsed = glfwGetTime() - _replayStartTime;
+        printf("Replayed %d recorded frames in %.2f s (%d rendered, %.1f fps)\n", (int)_replay.size(), elapsed,
+            (int)_frameCount + 1, elapsed > 0.0 ? (_frameCount + 1) / elapsed : 0.0);
+        glfwSetWindowShouldClose(_window, 1);
+        // Hold the last frame if the loop runs once more
+        _replayFrame = _replay.size() - 1;
+    }
+    return input;
+}
+
+bool ShadeApp::startRecording(const char* path) {
+    return _recorder.open(path, _windowWidth, _windowHeight);
+}
+
+void ShadeApp::startReplay(InputLog& log, double speed) {
+    _replay.swap(log);
+    if(_replay.getWidth() != _windowWidth || _replay.getHeight() != _windowHeight) {
+        LOG_F(WARNING, "Input was recorded at %dx%d, mouse positions won't match %dx%d", _replay.getWidth(), _replay.getHeight(), _windowWidth, _windowHeight);
+    }
+    _replaySpeed = speed;
+    _replayFrame = 0;
+}
+
+/* Records key events for the shader and the input log, then hands them to ImGui */
+void ShadeApp::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    ShadeApp* app = (ShadeApp*)glfwGetWindowUserPointer(window);
+    // Typing into a text field shouldn't reach the shader
+    bool toShader = action == GLFW_RELEASE || !ImGui::GetIO().WantCaptureKeyboard;
+    if(app && key == GLFW_KEY_F11 && action == GLFW_PRESS) {
+        app->setFullscreen(!app->_fullscreen);
+    }
+    if(app && key >= 0 && action != GLFW_REPEAT && toShader) {
+        InputKeyEvent event = { (uint16_t)key, (uint8_t)action };
+        app->_pendingKeys.push_back(event);
+    }
+    ImGui_ImplGlfwGL3_KeyCallback(window, key, scancode, action, mods);
+}
+
+/* Follows the framebuffer at once, the render targets are reallocated by applyPendingResize() */
+void ShadeApp::framebufferSizeCallback(GLFWwindow* window, int width, int height) {
+    ShadeApp* app = (ShadeApp*)glfwGetWindowUserPointer(window);
+    if(app) app->updateViewSize();
+}
+
+void ShadeApp::updateViewSize() {
+    int framebufferWidth, framebufferHeight, windowWidth, windowHeight;
+    glfwGetFramebufferSize(_window, &framebufferWidth, &framebufferHeight);
+    glfwGetWindowSize(_window, &windowWidth, &windowHeight);
+    // Minimized, keep what's allocated for when the window comes back
+    if(framebufferWidth <= 0 || framebufferHeight <= 0 || windowHeight <= 0) return;
+
+    // The menu bar is sized in screen coordinates, framebuffers are in pixels
+    int menubar = (int)ceil((double)MENUBAR_HEIGHT * framebufferHeight / windowHeight);
+    int width = std::min(framebufferWidth, 0xffff);
+    int height = std::min(std::max(framebufferHeight - menubar, 1), 0xffff);
+    if(width == _viewWidth && height == _viewHeight) return;
+    _viewWidth = width;
+    _viewHeight = height;
+    _resizePending = true;
+    _resizeTime = glfwGetTime();
+}
+
+/* Resizes the render once the window stopped changing, rather than on every step of a drag */
+void ShadeApp::applyPendingResize() {
+    if(!_resizePending || glfwGetTime() - _resizeTime < RESIZE_SETTLE_TIME) return;
+    _resizePending = false;
+    // Shared-memory readers expect the size the ring was opened with, the window shows it scaled
+    if(_shmOutput.isOpen()) return;
+    if(_viewWidth == _windowWidth && _viewHeight == _windowHeight) return;
+
+    _windowWidth = (uint16_t)_viewWidth;
+    _windowHeight = (uint16_t)_viewHeight;
+    // renderGraph() reallocates the pass outputs for the new size
+    LOG_F(INFO, "Rendering at %dx%d", _windowWidth, _windowHeight);
+}
+
+/* The monitor the window overlaps the most, the primary one if none */
+static GLFWmonitor* findWindowMonitor(GLFWwindow* window) {
+    int count;
+    GLFWmonitor** monitors = glfwGetMonitors(&count);
+    int x, y, width, height;
+    glfwGetWindowPos(window, &x, &y);
+    glfwGetWindowSize(window, &width, &height);
+
+    GLFWmonitor* best = glfwGetPrimaryMonitor();
+    int bestArea = 0;
+    for(int i = 0; i < count; ++i) {
+        int monitorX, monitorY;
+        glfwGetMonitorPos(monitors[i], &monitorX, &monitorY);
+        const GLFWvidmode* mode = glfwGetVideoMode(monitors[i]);
+        int overlapWidth = std::min(x + width, monitorX + mode->width) - std::max(x, monitorX);
+        int overlapHeight = std::min(y + height, monitorY + mode->height) - std::max(y, monitorY);
+        if(overlapWidth > 0 && overlapHeight > 0 && overlapWidth * overlapHeight > bestArea) {
+            best = monitors[i];
+            bestArea = overlapWidth * overlapHeight;
+        }
+    }
+    return best;
+}
+
+void ShadeApp::setFullscreen(bool fullscreen, int monitor) {
+    _fullscreen = fullscreen;
+    _fullscreenMonitor = monitor;
+    if(_window && !_headless) applyFullscreen();
+}
+
+void ShadeApp::applyFullscreen() {
+    GLFWmonitor* current = glfwGetWindowMonitor(_window);
+    if(!_fullscreen) {
+        if(current) {
+            glfwSetWindowMonitor(_window, NULL, _windowedRect[0], _windowedRect[1], _windowedRect[2], _windowedRect[3], GLFW_DONT_CARE);
+            _pacer.apply();
+        }
+        return;
+    }
+
+    GLFWmonitor* monitor = NULL;
+    int count;
+    GLFWmonitor** monitors = glfwGetMonitors(&count);
+    if(_fullscreenMonitor >= count) {
+        LOG_F(WARNING, "There is no monitor %d, %d connected", _fullscreenMonitor, count);
+    } else if(_fullscreenMonitor >= 0) {
+        monitor = monitors[_fullscreenMonitor];
+    }
+    if(!monitor) monitor = current ? current : findWindowMonitor(_window);
+    if(!monitor) {
+        LOG_F(ERROR, "No monitor to go fullscreen on");
+        _fullscreen = false;
+        return;
+    }
+
+    if(!current) {
+        glfwGetWindowPos(_window, &_windowedRect[0], &_windowedRect[1]);
+        glfwGetWindowSize(_window, &_windowedRect[2], &_windowedRect[3]);
+    }
+    // The desktop's mode, so the monitor doesn't have to switch modes
+    const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+    glfwSetWindowMonitor(_window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
+    // Some platforms reset the swap interval with the window's monitor
+    _pacer.apply();
+    LOG_F(INFO, "Fullscreen on %s, %dx%d at %d Hz", glfwGetMonitorName(monitor), mode->width, mode->height, mode->refreshRate);
+}
+
+/* Feeds a frame of input to the channels and the iMouse click state */
+void ShadeApp::applyInput(const InputFrame& input) {
+    applyKeyEvents(input.keys);
+
+    // ShaderToy's mouse is in pixels with y up, and only tracks while the left button is down
+    bool down = (input.buttons & 1) != 0;
+    float x = input.mouse[0];
+    float y = (float)_windowHeight - input.mouse[1];
+    if(down) {
+        _clickMouse[0] = x;
+        _clickMouse[1] = y;
+        if(!_mouseWasDown) {
+            _clickMouse[2] = x;
+            _clickMouse[3] = y;
+        } else {
+            _clickMouse[3] = -fabsf(_clickMouse[3]);
+        }
+    } else {
+        _clickMouse[2] = -fabsf(_clickMouse[2]);
+        _clickMouse[3] = -fabsf(_clickMouse[3]);
+    }
+    _mouseWasDown = down;
+}
+
+void ShadeApp::applyKeyEvents(const std::vector<InputKeyEvent>& keys) {
+    std::vector<ChannelInput*> channels = getChannelInputs();
+    for(size_t k = 0; k < keys.size(); ++k) {
+        for(size_t i = 0; i < channels.size(); ++i) {
+            channels[i]->handleKey(keys[k].key, keys[k].action);
+        }
+    }
+}
+
+/* Channels set on the command line and those of the loaded project */
+std::vector<ChannelInput*> ShadeApp::getChannelInputs() const {
+    std::vector<ChannelInput*> channels;
+    for(int i = 0; i < CHANNEL_COUNT; ++i) {
+        if(_channels[i]) channels.push_back(_channels[i]);
+    }
+    if(_graph) {
+        channels.insert(channels.end(), _graph->getChannels().begin(), _graph->getChannels().end());
+    }
+    return channels;
+}
+
+bool ShadeApp::setChannel(int index, const char* spec) {
+    if(index < 0 || index >= CHANNEL_COUNT) return false;
+    ChannelInput* channel = createChannelInput(spec);
+    if(!channel) return false;
+    delete _channels[index];
+    _channels[index] = channel;
+    // The shader's graph binds the channels, rebuild it with the new one
+    if(!_projectLoaded) {
+        delete _graph;
+        _graph = nullptr;
+    }
+    return true;
+}
+
+/* Uploads what changed in the channel textures and reports their sizes to the frame */
+void ShadeApp::updateChannels(FrameState& frame) {
+    for(int i = 0; i < CHANNEL_COUNT; ++i) {
+        if(!_channels[i]) continue;
+        _channels[i]->update(frame);
+        frame.channelResolution[i][0] = (float)_channels[i]->getWidth();
+        frame.channelResolution[i][1] = (float)_channels[i]->getHeight();
+        frame.channelResolution[i][2] = 1.0f;
+    }
+    // Project channels report their sizes per pass, see renderGraph()
+    if(_graph) {
+        const std::vector<ChannelInput*>& channels = _graph->getChannels();
+        for(size_t i = 0; i < channels.size(); ++i) {
+            channels[i]->update(frame);
+        }
+    }
+}
+
+/* Binds iChannelN to texture unit N */
+void ShadeApp::bindChannels() {
+    for(int i = 0; i < CHANNEL_COUNT; ++i) {
+        if(!_channels[i]) continue;
+        CHECK_GL(glActiveTexture(GL_TEXTURE0 + i));
+        CHECK_GL(glBindTexture(_channels[i]->getTarget(), _channels[i]->getTexture()));
+    }
+    CHECK_GL(glActiveTexture(GL_TEXTURE0));
+}
+
+/* Binds the program to draw with this frame and sets its uniforms */
+void ShadeApp::useProgram(const FrameState& frame) {
+    updateBakedPermutation();
+    bindChannels();
+    if(_bakedPermutation && _bakedPermutation->state == Permutation::READY) {
+        _bakedPermutation->program->use();
+        // Uniforms the bake couldn't rewrite (eg. several declared on one line) are still set from the table
+        _bakedPermutation->parameters.copyValues(_parameters);
+        _bakedPermutation->parameters.apply();
+        _bakedPermutation->builtins.set(frame);
+    } else {
+        _program->use();
+        _parameters.apply();
+        _builtinUniforms.set(frame);
+    }
+}
+
+bool ShadeApp::enableShmOutput(const char* name) {
+    if(!_sceneTarget.create(_windowWidth, _windowHeight)) return false;
+    _sceneTarget.setLabel("Shared memory output");
+    if(!_readback.init(_windowWidth, _windowHeight)) return false;
+    return _shmOutput.open(name, _windowWidth, _windowHeight, SHM_FORMAT_RGBA8);
+}
+
+/* Queues a readback of the target and publishes the reads that have completed */
+void ShadeApp::publishFrame(const RenderTarget& target, uint64_t frameIndex) {
+    uint64_t tag;
+    const uint8_t* pixels;
+    if(!_readback.start(target, frameIndex)) {
+        // All buffers in flight: wait for the oldest rather than drop a frame
+        if((pixels = _readback.map(tag, true)) != NULL) {
+            _shmOutput.publish(pixels, tag);
+            _readback.unmap();
+        }
+        _readback.start(target, frameIndex);
+    }
+    while((pixels = _readback.map(tag, false)) != NULL) {
+        _shmOutput.publish(pixels, tag);
+        _readback.unmap();
+    }
+}
+
+/* Draws the fullscreen quad with the program in use */
+void ShadeApp::drawQuad() {
+    CHECK_GL(glBindVertexArray(_vao));
+    CHECK_GL(glEnableVertexAttribArray(0));
+    CHECK_GL(glEnableVertexAttribArray(1));
+    
+    CHECK_GL(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0));
+    
+    CHECK_GL(glDisableVertexAttribArray(0));
+    CHECK_GL(glDisableVertexAttribArray(1));
+    CHECK_GL(glBindVertexArray(0));
+}
+
 bool ShadeApp::loadErrorShader() {
     cleanupShaders(false);
 
@@ -160,11 +649,52 @@ bool ShadeApp::loadErrorShader() {
     return relinkProgram();
 }
 
+/* Loads a ShaderToy project, the passes are drawn by renderGraph() */
+bool ShadeApp::loadProject(const char* path) {
+    RenderGraph* graph = new RenderGraph;
+    std::string error;
+    if(!loadShaderToyProject(path, *graph, error) || !graph->build(_builtinVertexShader, error)) {
+        LOG_F(ERROR, "%s", error.c_str());
+        delete graph;
+        return loadErrorShader();
+    }
+
+    // Keep a valid program around for the parts of the app that don't know about passes
+    cleanupShaders(false);
+    _vertexShader = _builtinVertexShader;
+    _fragmentShader = _builtinDefaultShader;
+    _graph = graph;
+    _projectLoaded = true;
+    return relinkProgram();
+}
+
+/* A graph of one output pass drawing the current program with the channels set on the command line */
+void ShadeApp::buildShaderGraph() {
+    RenderGraph* graph = new RenderGraph;
+    RenderPass* pass = graph->addPass(_currentShaderFile ? _currentShaderFile : "default", RenderPass::OUTPUT);
+    pass->external = true;
+    for(int i = 0; i < CHANNEL_COUNT; ++i) {
+        if(!_channels[i]) continue;
+        pass->inputs[i].source = PassInput::CHANNEL;
+        pass->inputs[i].channel = _channels[i];
+    }
+    std::string error;
+    graph->build(_builtinVertexShader, error);
+    _graph = graph;
+}
+
 bool ShadeApp::loadFragmentShader(const char* shaderFile) {
 	_currentShaderFile = shaderFile;
 	_currentShaderFileTimestamp = fwatch::ZERO_TIMESTAMP;
 	fwatch::checkFileModified(shaderFile, &_currentShaderFileTimestamp);
 
+    delete _graph;
+    _graph = nullptr;
+    _projectLoaded = false;
+    if(isShaderToyProject(shaderFile)) {
+        return loadProject(shaderFile);
+    }
+
     Shader* fragmentShader = new Shader;
     
     if(!fragmentShader->compile(GL_FRAGMENT_SHADER, shaderFile)) {
@@ -176,7 +706,11 @@ bool ShadeApp::loadFragmentShader(const char* shaderFile) {
     _vertexShader = _builtinVertexShader;
     _fragmentShader = fragmentShader;
     
-    return relinkProgram();
+    if(!relinkProgram()) {
+        // Without a program there'd be nothing to draw with
+        return loadErrorShader();
+    }
+    return true;
 }
 
 /* GLFW specific window setup */
@@ -186,15 +720,20 @@ bool ShadeApp::setupGLFW(const char* title) {
     if (!glfwInit())
         return false;
 
-    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, _headless ? GL_FALSE : GL_TRUE);
+    // Headless renders go to offscreen targets, but GLFW still needs a (hidden) window for the context
+    glfwWindowHint(GLFW_VISIBLE, _headless ? GL_FALSE : GL_TRUE);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if SHADE_GL_DEBUG
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
 #if __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-    _window = glfwCreateWindow(_windowWidth, _windowHeight + MENUBAR_HEIGHT, title, NULL, NULL);
+    _window = glfwCreateWindow(_windowWidth, _windowHeight + (_headless ? 0 : MENUBAR_HEIGHT), title, NULL, NULL);
     if (!_window)
     {
         glfwTerminate();
@@ -202,6 +741,7 @@ bool ShadeApp::setupGLFW(const char* title) {
     }
 
     glfwMakeContextCurrent(_window);
+    glfwSetWindowUserPointer(_window, this);
 
     if (gl3wInit()) {
         LOG_F(FATAL, "Failed to initialize OpenGL\n");
@@ -214,62 +754,103 @@ bool ShadeApp::setupGLFW(const char* title) {
     }
 
     LOG_F(INFO, "OpenGL %s, GLSL %s\n", glGetString(GL_VERSION), glGetString(GL_SHADING_LANGUAGE_VERSION));
+    initGLDebug();
+    if(!_headless) {
+        _pacer.apply();
+
+        // Render at the framebuffer's resolution from the start, on HiDPI screens it has more pixels than the window
+        glfwSetFramebufferSizeCallback(_window, framebufferSizeCallback);
+        updateViewSize();
+        _resizePending = false;
+        if(_viewWidth > 0) {
+            _windowWidth = (uint16_t)_viewWidth;
+            _windowHeight = (uint16_t)_viewHeight;
+        }
+        if(_fullscreen) applyFullscreen();
+    }
 
     return true;
 }
 
-int ShadeApp::runLoop() {
-	double lastFilePollTime = glfwGetTime();
-    while (!glfwWindowShouldClose(_window)) {
-    	// Poll for file change
-    	if(_currentShaderFile && glfwGetTime() - lastFilePollTime > 1.0) {
-    		if (fwatch::checkFileModified(_currentShaderFile, &_currentShaderFileTimestamp)) {
-    			loadFragmentShader(_currentShaderFile);
-    		}
-    		lastFilePollTime = glfwGetTime();
-    	}
+bool ShadeApp::pollShaderFile() {
+	if(glfwGetTime() - _lastFilePollTime < FILE_POLL_INTERVAL) return false;
+	_lastFilePollTime = glfwGetTime();
+	pollViewFiles();
 
-        ImGui_ImplGlfwGL3_NewFrame();
+	if(!_currentShaderFile || !fwatch::checkFileModified(_currentShaderFile, &_currentShaderFileTimestamp)) return false;
+	loadFragmentShader(_currentShaderFile);
+	logLiveGLObjects();
+	return true;
+}
 
-        ////////// BEGIN FRAME ///////////
+void ShadeApp::drawFrame() {
+    // Events are polled as the frame starts so its input is as fresh as the pacing allows
+    _pacer.beginFrame();
+    _frameStats.beginFrame();
+    glfwPollEvents();
+    applyPendingResize();
+    ImGui_ImplGlfwGL3_NewFrame();
 
-        glClear(GL_COLOR_BUFFER_BIT);
+    ////////// BEGIN FRAME ///////////
 
-        drawUI();
+    glClear(GL_COLOR_BUFFER_BIT);
 
-        glViewport(0,0,_windowWidth,_windowHeight);
+    drawUI();
 
-        _program->use();
-
-        if (_uniform_Time != -1) {
-            glUniform1f(_uniform_Time, glfwGetTime());
-        }
-        if (_uniform_Resolution != -1) {
-            glUniform2f(_uniform_Resolution, (float)_windowWidth, (float)_windowHeight);
-        }
-        if (_uniform_Mouse != -1) {
-            double x, y;
-            glfwGetCursorPos(_window, &x, &y);
-            glUniform2f(_uniform_Mouse, (float)x, (float)y - MENUBAR_HEIGHT);
-        }
+    FrameState frame = sampleFrameState();
+    _pacer.markInputSampled();
+    updateChannels(frame);
+    if(!_graph) {
+        buildShaderGraph();
+    }
+    if(!_playlist.empty()) {
+        drawPlaylist(frame);
+    } else if(_showViews && !_views.empty()) {
+        drawViews(frame);
+    } else if(_shmOutput.isOpen()) {
+        // Render offscreen so the frame can be read back, then show it in the window
+        renderGraph(frame, _sceneTarget.getFramebuffer(), _windowWidth, _windowHeight);
+        publishFrame(_sceneTarget, _frameCount);
+
+        CHECK_GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, _sceneTarget.getFramebuffer()));
+        CHECK_GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+        bool scaled = _viewWidth != _windowWidth || _viewHeight != _windowHeight;
+        CHECK_GL(glBlitFramebuffer(0, 0, _windowWidth, _windowHeight, 0, 0, _viewWidth, _viewHeight, GL_COLOR_BUFFER_BIT, scaled ? GL_LINEAR : GL_NEAREST));
+        RenderTarget::unbind();
+    } else {
+        renderGraph(frame, 0, _windowWidth, _windowHeight);
+    }
+    ++_frameCount;
 
+    //////////// END FRAME ///////////
+    {
+        GLDebugGroup group("UI");
+        ImGui::Render();
+    }
+    _frameStats.endFrame();
+    _pacer.present(_window);
+}
 
-        CHECK_GL(glBindVertexArray(_vao));
-        CHECK_GL(glEnableVertexAttribArray(0));
-        CHECK_GL(glEnableVertexAttribArray(1));
-        
-        CHECK_GL(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0));
-        
-        CHECK_GL(glDisableVertexAttribArray(0));
-        CHECK_GL(glDisableVertexAttribArray(1));
-        CHECK_GL(glBindVertexArray(0));
+void ShadeApp::setPresentMode(FramePacer::Mode mode, double fps) {
+    _pacer.setMode(mode, fps);
+    if(_window && !_headless) _pacer.apply();
+}
 
-        //////////// END FRAME ///////////
-        ImGui::Render();
-        glfwSwapBuffers(_window);
-        glfwPollEvents();
+int ShadeApp::runLoop() {
+	_lastFilePollTime = glfwGetTime();
+    while (!glfwWindowShouldClose(_window)) {
+        pollShaderFile();
+        drawFrame();
     }
 
+    _recorder.close();
+    if(_frameStats.getRing().getCount() > 0 && !_frameTimesFile.empty()) {
+        _frameStats.writeCSV(_frameTimesFile.c_str());
+    }
+    _pacer.reset();
+    _frameStats.reset();
+    stopPlaylist();
+    clearViews();
     glfwTerminate();
 
     return 0;
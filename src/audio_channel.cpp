@@ -0,0 +1,168 @@
+#include "audio_channel.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <loguru/loguru.hpp>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Seconds decoded ahead of the playhead, and kept in total
+static const double DECODE_AHEAD = 2.0;
+static const double RING_SECONDS = 4.0;
+static const size_t DECODE_CHUNK = 4096;
+
+// Byte range of the spectrum, same as WebAudio's AnalyserNode defaults
+static const float MIN_DECIBELS = -100.0f;
+static const float MAX_DECIBELS = -30.0f;
+
+AudioChannel::AudioChannel():_texture(0), _position(-1), _begin(0), _end(0), _playhead(0), _stop(false) {
+	memset(_pixels, 0, sizeof(_pixels));
+}
+
+AudioChannel::~AudioChannel() {
+	if(_decoder.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_wake.notify_all();
+		_decoder.join();
+	}
+	if(_texture) {
+		glDeleteTextures(1, &_texture);
+	}
+}
+
+bool AudioChannel::init(const char* path) {
+	if(!_wav.open(path) || _wav.getFrameCount() == 0) return false;
+	_fft.init(FFT_SIZE);
+
+	// Hann window
+	_window.resize(FFT_SIZE);
+	for(int i = 0; i < FFT_SIZE; ++i) {
+		_window[i] = 0.5f - 0.5f * (float)cos(2.0 * M_PI * i / FFT_SIZE);
+	}
+
+	size_t ringSize = 1;
+	while(ringSize < RING_SECONDS * _wav.getSampleRate()) ringSize *= 2;
+	_ring.resize(ringSize);
+
+	CHECK_GL(glGenTextures(1, &_texture));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, _texture));
+	CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, BIN_COUNT, 2, 0, GL_RED, GL_UNSIGNED_BYTE, _pixels));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+	labelGLObject(GL_TEXTURE, _texture, path);
+
+	_decoder = std::thread(&AudioChannel::decodeLoop, this);
+	return true;
+}
+
+void AudioChannel::decodeLoop() {
+	int64_t length = (int64_t)_wav.getFrameCount();
+	int64_t ahead = (int64_t)(DECODE_AHEAD * _wav.getSampleRate());
+	int64_t mask = (int64_t)_ring.size() - 1;
+	std::vector<float> chunk(DECODE_CHUNK);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(!_stop) {
+		if(_end - _playhead >= ahead) {
+			_wake.wait(lock);
+			continue;
+		}
+
+		// Decode outside the lock; the file loops, negative positions are silence
+		int64_t start = _end;
+		lock.unlock();
+		size_t count = DECODE_CHUNK;
+		if(start < 0) {
+			if((int64_t)count > -start) count = (size_t)-start;
+			memset(&chunk[0], 0, count * sizeof(float));
+		} else {
+			int64_t frame = start % length;
+			count = _wav.read(frame, &chunk[0], (size_t)std::min<int64_t>(count, length - frame));
+			if(count == 0) {
+				// Truncated file, treat the rest as silence
+				count = DECODE_CHUNK;
+				memset(&chunk[0], 0, count * sizeof(float));
+			}
+		}
+		lock.lock();
+
+		// A seek while decoding makes the chunk useless
+		if(_end != start) continue;
+		for(size_t i = 0; i < count; ++i) {
+			_ring[(start + i) & mask] = chunk[i];
+		}
+		_end += count;
+		if(_end - _begin > (int64_t)_ring.size()) {
+			_begin = _end - (int64_t)_ring.size();
+		}
+		_wake.notify_all();
+	}
+}
+
+void AudioChannel::fetch(int64_t position, float* out, int count) {
+	int64_t first = position - count;
+	int64_t mask = (int64_t)_ring.size() - 1;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_playhead = position;
+	if(first < _begin || first > _end + (int64_t)DECODE_CHUNK) {
+		// Seek: restart decoding at the window
+		_begin = _end = first;
+	}
+	_wake.notify_all();
+	while(_end < position) {
+		_wake.wait(lock);
+	}
+	for(int i = 0; i < count; ++i) {
+		out[i] = _ring[(first + i) & mask];
+	}
+}
+
+void AudioChannel::analyze(const float* samples) {
+	float re[FFT_SIZE], im[FFT_SIZE];
+	for(int i = 0; i < FFT_SIZE; ++i) {
+		re[i] = samples[i] * _window[i];
+		im[i] = 0.0f;
+	}
+	_fft.transform(re, im);
+
+	for(int i = 0; i < BIN_COUNT; ++i) {
+		float magnitude = sqrtf(re[i] * re[i] + im[i] * im[i]) / FFT_SIZE;
+		float db = 20.0f * log10f(magnitude + 1e-12f);
+		float v = 255.0f * (db - MIN_DECIBELS) / (MAX_DECIBELS - MIN_DECIBELS);
+		_pixels[0][i] = (uint8_t)(v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v));
+	}
+
+	// Waveform of the most recent samples, 128 is silence
+	const float* recent = samples + FFT_SIZE - BIN_COUNT;
+	for(int i = 0; i < BIN_COUNT; ++i) {
+		float v = 128.0f + 128.0f * recent[i];
+		_pixels[1][i] = (uint8_t)(v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v));
+	}
+}
+
+void AudioChannel::update(const FrameState& frame) {
+	int64_t position = (int64_t)floor(frame.time * _wav.getSampleRate());
+	if(position < 0) position = 0;
+	if(position == _position) return;
+	_position = position;
+
+	float samples[FFT_SIZE];
+	fetch(position, samples, FFT_SIZE);
+	analyze(samples);
+
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, _texture));
+	CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	CHECK_GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, BIN_COUNT, 2, GL_RED, GL_UNSIGNED_BYTE, _pixels));
+	CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+}
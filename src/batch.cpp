@@ -0,0 +1,160 @@
+#include "app.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* How many shaders to keep compiling ahead of the one being rendered */
+static const size_t MAX_COMPILES_IN_FLIGHT = 16;
+
+struct BatchJob {
+	std::string file;
+	Shader* shader;
+	Program* program;
+	bool ok;
+	std::string error;
+	double compileTime;
+	double renderTime;
+};
+
+static void startJob(BatchJob& job, const Shader* vertexShader) {
+	double start = glfwGetTime();
+	job.shader = new Shader;
+	if(!job.shader->startCompile(GL_FRAGMENT_SHADER, job.file)) {
+		job.error = job.shader->getInfoLog();
+		delete job.shader;
+		job.shader = nullptr;
+		return;
+	}
+	job.program = new Program(vertexShader, job.shader);
+	job.program->bindAttribLocation(0, "Pos");
+	job.program->bindAttribLocation(1, "UV");
+	job.program->startLink();
+	job.compileTime = glfwGetTime() - start;
+}
+
+static void finishJob(BatchJob& job) {
+	delete job.program;
+	delete job.shader;
+	job.program = nullptr;
+	job.shader = nullptr;
+}
+
+static void writeReport(FILE* out, const std::vector<BatchJob>& jobs, size_t frameCount) {
+	size_t failed = 0;
+	double compileTotal = 0.0, renderTotal = 0.0;
+	fprintf(out, "%-40s %8s %12s %12s\n", "shader", "status", "compile ms", "ms/frame");
+	for(size_t i = 0; i < jobs.size(); ++i) {
+		const BatchJob& job = jobs[i];
+		compileTotal += job.compileTime;
+		renderTotal += job.renderTime;
+		if(!job.ok) ++failed;
+		fprintf(out, "%-40s %8s %12.2f %12.2f\n", fileStem(job.file).c_str(), job.ok ? "ok" : "FAILED",
+			job.compileTime * 1000.0, job.ok ? job.renderTime * 1000.0 / frameCount : 0.0);
+	}
+	fprintf(out, "\n%d shaders, %d failed, %.2f s compiling, %.2f s rendering\n",
+		(int)jobs.size(), (int)failed, compileTotal, renderTotal);
+
+	for(size_t i = 0; i < jobs.size(); ++i) {
+		if(!jobs[i].ok) {
+			fprintf(out, "\n--- %s\n%s\n", jobs[i].file.c_str(), jobs[i].error.c_str());
+		}
+	}
+}
+
+/**
+ * Renders the frame range of every .glsl file in shaderDir to settings.outDir.
+ * All shaders are submitted to the compiler up front (within a window), so
+ * drivers with parallel shader compile build them concurrently while earlier
+ * ones render.  A shader that fails to build is reported and skipped.
+ */
+int ShadeApp::runBatch(const char* shaderDir, const ExportSettings& settings) {
+	std::vector<std::string> files = fwatch::listFiles(shaderDir, ".glsl");
+	if(files.empty()) {
+		fprintf(stderr, "No .glsl files in '%s'\n", shaderDir);
+		return EXIT_FAILURE;
+	}
+	if(!fwatch::makeDirectory(settings.outDir.c_str())) {
+		fprintf(stderr, "Couldn't create output directory '%s'\n", settings.outDir.c_str());
+		return EXIT_FAILURE;
+	}
+
+	RenderTarget target;
+	if(!target.create(_windowWidth, _windowHeight)) {
+		return EXIT_FAILURE;
+	}
+	target.setLabel("Batch");
+
+	std::vector<BatchJob> jobs(files.size());
+	for(size_t i = 0; i < jobs.size(); ++i) {
+		jobs[i].file = files[i];
+		jobs[i].shader = nullptr;
+		jobs[i].program = nullptr;
+		jobs[i].ok = false;
+		jobs[i].compileTime = 0.0;
+		jobs[i].renderTime = 0.0;
+	}
+
+	std::vector<uint8_t> pixels;
+	size_t nextToStart = 0;
+	for(size_t i = 0; i < jobs.size(); ++i) {
+		while(nextToStart < jobs.size() && nextToStart < i + MAX_COMPILES_IN_FLIGHT) {
+			startJob(jobs[nextToStart++], _builtinVertexShader);
+		}
+
+		BatchJob& job = jobs[i];
+		if(!job.program) continue;
+
+		// Blocks until the driver is done with this shader
+		double start = glfwGetTime();
+		if(!job.shader->checkCompileStatus(job.file.c_str())) {
+			job.error = job.shader->getInfoLog();
+		} else if(!job.program->checkLinkStatus()) {
+			job.error = job.program->getInfoLog();
+		} else {
+			job.ok = true;
+		}
+		job.compileTime += glfwGetTime() - start;
+		if(!job.ok) {
+			finishJob(job);
+			continue;
+		}
+
+		start = glfwGetTime();
+		BuiltinUniforms builtins;
+		builtins.locate(*job.program);
+		std::string stem = fileStem(job.file);
+		for(size_t f = 0; f < settings.frames.size(); ++f) {
+			FrameState frame = fixedStepFrameState(settings.frames[f], settings.fps, _windowWidth, _windowHeight);
+
+			target.bind();
+			glClear(GL_COLOR_BUFFER_BIT);
+			job.program->use();
+			builtins.set(frame);
+			drawQuad();
+
+			target.readPixels(pixels);
+			std::string path = frameFileName(settings.outDir, stem, settings.frames[f]);
+			if(!writePNG(path.c_str(), _windowWidth, _windowHeight, pixels)) {
+				job.ok = false;
+				job.error = "Couldn't write " + path;
+				break;
+			}
+		}
+		job.renderTime = glfwGetTime() - start;
+		finishJob(job);
+	}
+	RenderTarget::unbind();
+
+	writeReport(stdout, jobs, settings.frames.size());
+	std::string reportPath = settings.outDir + "/batch_report.txt";
+	FILE* report = fopen(reportPath.c_str(), "w");
+	if(report) {
+		writeReport(report, jobs, settings.frames.size());
+		fclose(report);
+	}
+
+	for(size_t i = 0; i < jobs.size(); ++i) {
+		if(!jobs[i].ok) return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
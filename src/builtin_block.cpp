@@ -0,0 +1,184 @@
+#include "builtin_block.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Every member of the block takes a 16 byte slot, padded as needed, so the
+ * layout is the same whichever type a shader declares a built-in with.
+ */
+struct BlockMember {
+	int slot;
+	const char* name;
+	const char* type;
+};
+
+static const BlockMember BLOCK_MEMBERS[] = {
+	{ 0, "iResolution", "vec2" },
+	{ 0, "iResolution", "vec3" },
+	{ 1, "iTime", "float" },
+	{ 2, "iTimeDelta", "float" },
+	{ 3, "iFrameRate", "float" },
+	{ 4, "iFrame", "int" },
+	// ShaderToy's iMouse, and Shade's cursor position
+	{ 5, "iMouse", "vec4" },
+	{ 6, "iMouse", "vec2" },
+	{ 7, "iDate", "vec4" },
+	{ 8, "iSampleRate", "float" }
+};
+static const int BLOCK_SLOTS = 9;
+
+static bool isIdentChar(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static std::string nextIdentifier(const std::string& line, size_t& pos) {
+	while(pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+	size_t start = pos;
+	while(pos < line.size() && isIdentChar(line[pos])) ++pos;
+	return line.substr(start, pos - start);
+}
+
+/* Matches "uniform [precision] type name;" with nothing but a comment after it */
+static const BlockMember* parseBuiltinDeclaration(const std::string& line) {
+	size_t pos = 0;
+	if(nextIdentifier(line, pos) != "uniform") return nullptr;
+	std::string type = nextIdentifier(line, pos);
+	if(type == "lowp" || type == "mediump" || type == "highp") {
+		type = nextIdentifier(line, pos);
+	}
+	std::string name = nextIdentifier(line, pos);
+	while(pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+	if(pos >= line.size() || line[pos] != ';') return nullptr;
+
+	for(size_t i = 0; i < sizeof(BLOCK_MEMBERS) / sizeof(BLOCK_MEMBERS[0]); ++i) {
+		if(name == BLOCK_MEMBERS[i].name && type == BLOCK_MEMBERS[i].type) return &BLOCK_MEMBERS[i];
+	}
+	return nullptr;
+}
+
+static int glslVersion(const std::string& source) {
+	size_t at = source.find("#version");
+	if(at == std::string::npos) return 110;
+	return atoi(source.c_str() + at + 8);
+}
+
+/* Declarations filling the rest of a slot after a member of the given type */
+static std::string slotPadding(int slot, const std::string& type) {
+	char padding[64];
+	if(type == "float" || type == "int") {
+		snprintf(padding, sizeof(padding), " float _shade%d_0, _shade%d_1, _shade%d_2;", slot, slot, slot);
+	} else if(type == "vec2") {
+		snprintf(padding, sizeof(padding), " vec2 _shade%d;", slot);
+	} else if(type == "vec3") {
+		snprintf(padding, sizeof(padding), " float _shade%d;", slot);
+	} else {
+		padding[0] = '\0';
+	}
+	return padding;
+}
+
+std::string moveBuiltinsToBlock(const std::string& source) {
+	if(glslVersion(source) < 140) return source;
+
+	// Find the declared built-ins first, the block goes where the first of them was
+	std::vector<std::string> lines;
+	std::vector<const BlockMember*> declared;
+	const BlockMember* slots[BLOCK_SLOTS] = { nullptr };
+	size_t lineStart = 0;
+	while(lineStart < source.size()) {
+		size_t lineEnd = source.find('\n', lineStart);
+		if(lineEnd == std::string::npos) lineEnd = source.size();
+		lines.push_back(source.substr(lineStart, lineEnd - lineStart));
+		const BlockMember* member = parseBuiltinDeclaration(lines.back());
+		// A second declaration for the same slot (eg. iMouse twice) is left to the compiler
+		if(member && slots[member->slot]) member = nullptr;
+		if(member) slots[member->slot] = member;
+		declared.push_back(member);
+		lineStart = lineEnd + 1;
+	}
+
+	std::string block = "layout(std140) uniform ShadeBuiltins {";
+	bool any = false;
+	for(int slot = 0; slot < BLOCK_SLOTS; ++slot) {
+		char unused[32];
+		if(slots[slot]) {
+			block += std::string(" ") + slots[slot]->type + " " + slots[slot]->name + ";" + slotPadding(slot, slots[slot]->type);
+			any = true;
+		} else {
+			snprintf(unused, sizeof(unused), " vec4 _shade%d;", slot);
+			block += unused;
+		}
+	}
+	block += " };";
+	if(!any) return source;
+
+	std::string rewritten;
+	rewritten.reserve(source.size() + block.size());
+	bool placed = false;
+	for(size_t i = 0; i < lines.size(); ++i) {
+		if(declared[i] && !placed) {
+			rewritten += block;
+			placed = true;
+		} else if(!declared[i]) {
+			rewritten += lines[i];
+		}
+		if(i + 1 < lines.size() || source[source.size() - 1] == '\n') rewritten += "\n";
+	}
+	return rewritten;
+}
+
+void bindBuiltinBlock(const Program& program) {
+	GLuint index = glGetUniformBlockIndex(program.getID(), "ShadeBuiltins");
+	if(index != GL_INVALID_INDEX) {
+		CHECK_GL(glUniformBlockBinding(program.getID(), index, BUILTIN_BLOCK_BINDING));
+	}
+}
+
+void BuiltinBlockBuffer::update(const std::vector<FrameState>& frames) {
+	if(_buffer == 0) {
+		CHECK_GL(glGenBuffers(1, &_buffer));
+		labelGLObject(GL_BUFFER, _buffer, "Built-in uniforms");
+		GLint alignment = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		size_t blockSize = BLOCK_SLOTS * 4 * sizeof(float);
+		_stride = (blockSize + alignment - 1) / alignment * alignment;
+	}
+
+	size_t floatsPerBlock = _stride / sizeof(float);
+	_data.assign(frames.size() * floatsPerBlock, 0.0f);
+	for(size_t i = 0; i < frames.size(); ++i) {
+		const FrameState& frame = frames[i];
+		float* slot = &_data[i * floatsPerBlock];
+		slot[0] = frame.resolution[0];
+		slot[1] = frame.resolution[1];
+		slot[2] = 1.0f;
+		slot[4] = (float)frame.time;
+		slot[8] = frame.timeDelta;
+		slot[12] = frame.timeDelta > 0.0f ? 1.0f / frame.timeDelta : 60.0f;
+		memcpy(&slot[16], &frame.frame, sizeof(frame.frame));
+		memcpy(&slot[20], frame.clickMouse, sizeof(frame.clickMouse));
+		memcpy(&slot[24], frame.mouse, sizeof(frame.mouse));
+		memcpy(&slot[28], frame.date, sizeof(frame.date));
+		slot[32] = 44100.0f;
+	}
+
+	_size = _data.size() * sizeof(float);
+	CHECK_GL(glBindBuffer(GL_UNIFORM_BUFFER, _buffer));
+	CHECK_GL(glBufferData(GL_UNIFORM_BUFFER, _size, _data.empty() ? NULL : &_data[0], GL_STREAM_DRAW));
+	CHECK_GL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+void BuiltinBlockBuffer::bind(size_t index) const {
+	if(_buffer == 0 || (index + 1) * _stride > _size) return;
+	CHECK_GL(glBindBufferRange(GL_UNIFORM_BUFFER, BUILTIN_BLOCK_BINDING, _buffer, index * _stride, BLOCK_SLOTS * 4 * sizeof(float)));
+}
+
+void BuiltinBlockBuffer::destroy() {
+	if(_buffer != 0) {
+		CHECK_GL(glDeleteBuffers(1, &_buffer));
+		_buffer = 0;
+	}
+	_stride = _size = 0;
+}
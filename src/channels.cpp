@@ -0,0 +1,329 @@
+#include "channels.h"
+#include "audio_channel.h"
+#include "video_channel.h"
+#include "sequence_channel.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+#include <loguru/loguru.hpp>
+
+int64_t channelFrameIndex(double time, double fps) {
+	int64_t index = (int64_t)floor(time * fps + 1e-6);
+	return index < 0 ? 0 : index;
+}
+
+int toBrowserKeyCode(int key) {
+	// Letters, digits and space share their codes
+	if((key >= GLFW_KEY_A && key <= GLFW_KEY_Z) || (key >= GLFW_KEY_0 && key <= GLFW_KEY_9) || key == GLFW_KEY_SPACE) {
+		return key;
+	}
+	if(key >= GLFW_KEY_F1 && key <= GLFW_KEY_F12) {
+		return 112 + (key - GLFW_KEY_F1);
+	}
+	if(key >= GLFW_KEY_KP_0 && key <= GLFW_KEY_KP_9) {
+		return 96 + (key - GLFW_KEY_KP_0);
+	}
+
+	switch(key) {
+	case GLFW_KEY_BACKSPACE: return 8;
+	case GLFW_KEY_TAB: return 9;
+	case GLFW_KEY_ENTER: case GLFW_KEY_KP_ENTER: return 13;
+	case GLFW_KEY_LEFT_SHIFT: case GLFW_KEY_RIGHT_SHIFT: return 16;
+	case GLFW_KEY_LEFT_CONTROL: case GLFW_KEY_RIGHT_CONTROL: return 17;
+	case GLFW_KEY_LEFT_ALT: case GLFW_KEY_RIGHT_ALT: return 18;
+	case GLFW_KEY_PAUSE: return 19;
+	case GLFW_KEY_CAPS_LOCK: return 20;
+	case GLFW_KEY_ESCAPE: return 27;
+	case GLFW_KEY_PAGE_UP: return 33;
+	case GLFW_KEY_PAGE_DOWN: return 34;
+	case GLFW_KEY_END: return 35;
+	case GLFW_KEY_HOME: return 36;
+	case GLFW_KEY_LEFT: return 37;
+	case GLFW_KEY_UP: return 38;
+	case GLFW_KEY_RIGHT: return 39;
+	case GLFW_KEY_DOWN: return 40;
+	case GLFW_KEY_INSERT: return 45;
+	case GLFW_KEY_DELETE: return 46;
+	case GLFW_KEY_KP_MULTIPLY: return 106;
+	case GLFW_KEY_KP_ADD: return 107;
+	case GLFW_KEY_KP_SUBTRACT: return 109;
+	case GLFW_KEY_KP_DECIMAL: return 110;
+	case GLFW_KEY_KP_DIVIDE: return 111;
+	case GLFW_KEY_SEMICOLON: return 186;
+	case GLFW_KEY_EQUAL: return 187;
+	case GLFW_KEY_COMMA: return 188;
+	case GLFW_KEY_MINUS: return 189;
+	case GLFW_KEY_PERIOD: return 190;
+	case GLFW_KEY_SLASH: return 191;
+	case GLFW_KEY_GRAVE_ACCENT: return 192;
+	case GLFW_KEY_LEFT_BRACKET: return 219;
+	case GLFW_KEY_BACKSLASH: return 220;
+	case GLFW_KEY_RIGHT_BRACKET: return 221;
+	case GLFW_KEY_APOSTROPHE: return 222;
+	}
+	return -1;
+}
+
+KeyboardChannel::KeyboardChannel():_texture(0), _dirty(true), _pressedThisFrame(false), _uploaded(false) {
+	memset(_state, 0, sizeof(_state));
+}
+
+KeyboardChannel::~KeyboardChannel() {
+	if(_texture) {
+		glDeleteTextures(1, &_texture);
+	}
+}
+
+bool KeyboardChannel::init() {
+	CHECK_GL(glGenTextures(1, &_texture));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, _texture));
+	CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, KEY_COUNT, 3, 0, GL_RED, GL_UNSIGNED_BYTE, _state));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+	labelGLObject(GL_TEXTURE, _texture, "Keyboard");
+	_dirty = false;
+	return true;
+}
+
+void KeyboardChannel::handleKey(int key, int action) {
+	int code = toBrowserKeyCode(key);
+	if(code < 0) return;
+
+	if(action == GLFW_PRESS) {
+		if(_state[0][code]) return;
+		_state[0][code] = 255;
+		_state[1][code] = 255;
+		_state[2][code] ^= 255;
+		_pressedThisFrame = true;
+	} else if(action == GLFW_RELEASE) {
+		if(!_state[0][code]) return;
+		_state[0][code] = 0;
+	} else {
+		return;
+	}
+	_dirty = true;
+}
+
+void KeyboardChannel::reset() {
+	memset(_state, 0, sizeof(_state));
+	_pressedThisFrame = false;
+	_dirty = true;
+}
+
+void KeyboardChannel::update(const FrameState&) {
+	// Most frames have no key events and upload nothing
+	_uploaded = _dirty;
+	if(!_dirty) return;
+
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, _texture));
+	CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	CHECK_GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, KEY_COUNT, 3, GL_RED, GL_UNSIGNED_BYTE, _state));
+	CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+	_dirty = false;
+
+	// Presses only last one frame, the next upload clears them
+	if(_pressedThisFrame) {
+		memset(_state[1], 0, KEY_COUNT);
+		_pressedThisFrame = false;
+		_dirty = true;
+	}
+}
+
+/* Loads an image as RGBA8, optionally bottom row first */
+static uint8_t* loadImage(const char* path, bool flip, int& width, int& height) {
+	int components;
+	uint8_t* pixels = stbi_load(path, &width, &height, &components, 4);
+	if(!pixels) {
+		LOG_F(ERROR, "Couldn't load image '%s': %s", path, stbi_failure_reason());
+		return NULL;
+	}
+	if(flip) {
+		size_t stride = (size_t)width * 4;
+		std::vector<uint8_t> row(stride);
+		for(int y = 0; y < height / 2; ++y) {
+			uint8_t* top = pixels + (size_t)y * stride;
+			uint8_t* bottom = pixels + (size_t)(height - 1 - y) * stride;
+			memcpy(&row[0], top, stride);
+			memcpy(top, bottom, stride);
+			memcpy(bottom, &row[0], stride);
+		}
+	}
+	return pixels;
+}
+
+ImageChannel::~ImageChannel() {
+	if(_texture) {
+		glDeleteTextures(1, &_texture);
+	}
+}
+
+bool ImageChannel::init(const char* path, bool flip, bool srgb) {
+	uint8_t* pixels = loadImage(path, flip, _width, _height);
+	if(!pixels) return false;
+
+	_target = GL_TEXTURE_2D;
+	CHECK_GL(glGenTextures(1, &_texture));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, _texture));
+	CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	CHECK_GL(glGenerateMipmap(GL_TEXTURE_2D));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+	labelGLObject(GL_TEXTURE, _texture, path);
+	stbi_image_free(pixels);
+	return true;
+}
+
+bool ImageChannel::initCubemap(const char* path, bool flip, bool srgb) {
+	std::string base = path, extension;
+	size_t dot = base.rfind('.');
+	if(dot != std::string::npos && base.find('/', dot) == std::string::npos) {
+		extension = base.substr(dot);
+		base.resize(dot);
+	}
+
+	_target = GL_TEXTURE_CUBE_MAP;
+	CHECK_GL(glGenTextures(1, &_texture));
+	CHECK_GL(glBindTexture(GL_TEXTURE_CUBE_MAP, _texture));
+	CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	bool ok = true;
+	for(int face = 0; face < 6 && ok; ++face) {
+		char suffix[8] = "";
+		if(face > 0) snprintf(suffix, sizeof(suffix), "_%d", face);
+		std::string facePath = base + suffix + extension;
+		uint8_t* pixels = loadImage(facePath.c_str(), flip, _width, _height);
+		if(!pixels) {
+			ok = false;
+			break;
+		}
+		CHECK_GL(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+		stbi_image_free(pixels);
+	}
+	CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	if(ok) {
+		CHECK_GL(glGenerateMipmap(GL_TEXTURE_CUBE_MAP));
+		CHECK_GL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+		CHECK_GL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	}
+	CHECK_GL(glBindTexture(GL_TEXTURE_CUBE_MAP, 0));
+	labelGLObject(GL_TEXTURE, _texture, path);
+	return ok;
+}
+
+bool StreamingTexture::create(int width, int height) {
+	destroy();
+	_width = width;
+	_height = height;
+
+	CHECK_GL(glGenTextures(1, &_texture));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, _texture));
+	CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+
+	CHECK_GL(glGenBuffers(2, _pbo));
+	for(int i = 0; i < 2; ++i) {
+		CHECK_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo[i]));
+		CHECK_GL(glBufferData(GL_PIXEL_UNPACK_BUFFER, (size_t)width * height * 4, NULL, GL_STREAM_DRAW));
+	}
+	CHECK_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+	return true;
+}
+
+void StreamingTexture::destroy() {
+	if(_texture) {
+		glDeleteTextures(1, &_texture);
+		glDeleteBuffers(2, _pbo);
+		_texture = 0;
+		_pbo[0] = _pbo[1] = 0;
+	}
+}
+
+void StreamingTexture::upload(const uint8_t* rgba) {
+	size_t size = (size_t)_width * _height * 4;
+	CHECK_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo[_next]));
+	// Orphan the storage so mapping doesn't wait for the transfer still using it
+	CHECK_GL(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW));
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if(mapped) {
+		memcpy(mapped, rgba, size);
+		CHECK_GL(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+		CHECK_GL(glBindTexture(GL_TEXTURE_2D, _texture));
+		CHECK_GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, 0));
+		CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+	} else {
+		LOG_F(ERROR, "Couldn't map texture upload buffer");
+	}
+	CHECK_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+	_next ^= 1;
+}
+
+ChannelInput* createChannelInput(const char* spec) {
+	if(strcmp(spec, "keyboard") == 0) {
+		KeyboardChannel* keyboard = new KeyboardChannel;
+		if(!keyboard->init()) {
+			delete keyboard;
+			return NULL;
+		}
+		return keyboard;
+	}
+
+	if(strncmp(spec, "image:", 6) == 0) {
+		ImageChannel* image = new ImageChannel;
+		if(!image->init(spec + 6)) {
+			delete image;
+			return NULL;
+		}
+		return image;
+	}
+
+	if(strncmp(spec, "audio:", 6) == 0) {
+		AudioChannel* audio = new AudioChannel;
+		if(!audio->init(spec + 6)) {
+			delete audio;
+			return NULL;
+		}
+		return audio;
+	}
+
+	if(strncmp(spec, "video:", 6) == 0) {
+		VideoChannel* video = new VideoChannel;
+		if(!video->init(spec + 6)) {
+			delete video;
+			return NULL;
+		}
+		return video;
+	}
+
+	if(strncmp(spec, "sequence:", 9) == 0) {
+		std::string pattern = spec + 9;
+		double fps = 60.0;
+		size_t at = pattern.rfind('@');
+		if(at != std::string::npos && at + 1 < pattern.size() && strspn(pattern.c_str() + at + 1, "0123456789.") == pattern.size() - at - 1) {
+			fps = atof(pattern.c_str() + at + 1);
+			pattern.resize(at);
+		}
+		ImageSequenceChannel* sequence = new ImageSequenceChannel;
+		if(!sequence->init(pattern.c_str(), fps)) {
+			delete sequence;
+			return NULL;
+		}
+		return sequence;
+	}
+
+	LOG_F(ERROR, "Unknown channel input '%s'", spec);
+	return NULL;
+}
@@ -0,0 +1,165 @@
+#include "app.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+bool parseFrameList(const char* spec, std::vector<int>& frames) {
+	frames.clear();
+	const char* p = spec;
+	while(*p) {
+		char* end;
+		long first = strtol(p, &end, 10);
+		if(end == p || first < 0) return false;
+		long last = first;
+		p = end;
+		if(*p == '-') {
+			++p;
+			last = strtol(p, &end, 10);
+			if(end == p || last < first) return false;
+			p = end;
+		}
+		for(long f = first; f <= last; ++f) {
+			frames.push_back((int)f);
+		}
+		if(*p == ',') {
+			++p;
+		} else if(*p) {
+			return false;
+		}
+	}
+	return !frames.empty();
+}
+
+std::string formatFrameList(const std::vector<int>& frames) {
+	std::string spec;
+	char buff[32];
+	size_t i = 0;
+	while(i < frames.size()) {
+		size_t j = i;
+		while(j + 1 < frames.size() && frames[j + 1] == frames[j] + 1) ++j;
+		if(j == i) {
+			snprintf(buff, sizeof(buff), "%d", frames[i]);
+		} else {
+			snprintf(buff, sizeof(buff), "%d-%d", frames[i], frames[j]);
+		}
+		if(!spec.empty()) spec += ",";
+		spec += buff;
+		i = j + 1;
+	}
+	return spec;
+}
+
+bool applyShard(const char* spec, bool contiguous, std::vector<int>& frames) {
+	int shard, count;
+	char trailing;
+	if(sscanf(spec, "%d/%d%c", &shard, &count, &trailing) != 2 || count <= 0 || shard < 0 || shard >= count) {
+		return false;
+	}
+
+	std::vector<int> selected;
+	size_t total = frames.size();
+	for(size_t i = 0; i < total; ++i) {
+		// Contiguous blocks differ in size by at most one frame
+		bool mine = contiguous ? (i * count / total) == (size_t)shard : (i % count) == (size_t)shard;
+		if(mine) selected.push_back(frames[i]);
+	}
+	frames.swap(selected);
+	return true;
+}
+
+std::string frameFileName(const std::string& outDir, const std::string& stem, int frame) {
+	char number[16];
+	snprintf(number, sizeof(number), "_%05d.png", frame);
+	return outDir + "/" + stem + number;
+}
+
+std::string fileStem(const std::string& path) {
+	size_t slash = path.find_last_of("/\\");
+	std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+	size_t dot = name.find_last_of('.');
+	return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+bool frameExists(const std::string& outDir, const std::string& stem, int frame) {
+	FILE* f = fopen(frameFileName(outDir, stem, frame).c_str(), "rb");
+	if(!f) return false;
+	fclose(f);
+	return true;
+}
+
+/* Draws an export frame into target */
+void ShadeApp::renderExportFrame(FrameState frame, RenderTarget& target) {
+	updateChannels(frame);
+	target.bind();
+	glClear(GL_COLOR_BUFFER_BIT);
+	renderGraph(frame, target.getFramebuffer(), _windowWidth, _windowHeight);
+}
+
+int ShadeApp::exportFrames(const ExportSettings& settings) {
+	if(!_program || _fragmentShader == _builtinErrorShader) {
+		fprintf(stderr, "Shader failed to build, nothing to export\n");
+		return EXIT_FAILURE;
+	}
+	if(!fwatch::makeDirectory(settings.outDir.c_str())) {
+		LOG_F(ERROR, "Couldn't create output directory '%s'", settings.outDir.c_str());
+		return EXIT_FAILURE;
+	}
+
+	RenderTarget target;
+	if(!target.create(_windowWidth, _windowHeight)) {
+		return EXIT_FAILURE;
+	}
+	target.setLabel("Export");
+
+	// Streaming inputs must deliver the exact frame, however long it takes
+	std::vector<ChannelInput*> channels = getChannelInputs();
+	for(size_t c = 0; c < channels.size(); ++c) {
+		channels[c]->setOffline(true);
+	}
+	// Buffer passes start from cleared targets, as when the project is opened
+	if(!_graph) {
+		buildShaderGraph();
+	}
+	_graph->resize(_windowWidth, _windowHeight);
+
+	std::string stem = _currentShaderFile ? fileStem(_currentShaderFile) : "default";
+	std::vector<uint8_t> pixels;
+	int failures = 0;
+
+	// Feedback buffers and passes on an interval hold what earlier frames drew: render the frames
+	// skipped by a sparse list or shard chunk too, so the output matches a full export from frame 0
+	bool carriesState = _graph->carriesState();
+	int nextFrame = 0;
+	if(carriesState && settings.frames[0] > 0) {
+		LOG_F(INFO, "The project keeps state between frames, rendering from frame 0");
+	}
+
+	for(size_t i = 0; i < settings.frames.size(); ++i) {
+		int frameNumber = settings.frames[i];
+
+		if(carriesState) {
+			if(frameNumber < nextFrame) {
+				_graph->resize(_windowWidth, _windowHeight);
+				nextFrame = 0;
+			}
+			for(; nextFrame < frameNumber; ++nextFrame) {
+				renderExportFrame(exportFrameState(nextFrame, settings.fps), target);
+			}
+			nextFrame = frameNumber + 1;
+		}
+		renderExportFrame(exportFrameState(frameNumber, settings.fps), target);
+
+		// The PNG needs the pixels now anyway, so the ring gets the same read rather than a second, asynchronous one
+		target.readPixels(pixels);
+		if(_shmOutput.isOpen()) {
+			_shmOutput.publish(&pixels[0], frameNumber);
+		}
+		std::string path = frameFileName(settings.outDir, stem, frameNumber);
+		if(!writePNG(path.c_str(), _windowWidth, _windowHeight, pixels)) {
+			++failures;
+		}
+	}
+	RenderTarget::unbind();
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
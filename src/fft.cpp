@@ -0,0 +1,82 @@
+#include "fft.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FFT_SSE
+#endif
+
+bool FFT::init(int size) {
+	if(size < 4 || (size & (size - 1)) != 0) return false;
+	_size = size;
+
+	int bits = 0;
+	while((1 << bits) < size) ++bits;
+	_bitReverse.resize(size);
+	for(int i = 0; i < size; ++i) {
+		uint32_t r = 0;
+		for(int b = 0; b < bits; ++b) {
+			if(i & (1 << b)) r |= 1 << (bits - 1 - b);
+		}
+		_bitReverse[i] = r;
+	}
+
+	_twiddleRe.resize(size - 1);
+	_twiddleIm.resize(size - 1);
+	for(int half = 1; half < size; half *= 2) {
+		for(int k = 0; k < half; ++k) {
+			double angle = -M_PI * k / half;
+			_twiddleRe[half - 1 + k] = (float)cos(angle);
+			_twiddleIm[half - 1 + k] = (float)sin(angle);
+		}
+	}
+	return true;
+}
+
+void FFT::transform(float* re, float* im) const {
+	for(int i = 0; i < _size; ++i) {
+		uint32_t j = _bitReverse[i];
+		if(j > (uint32_t)i) {
+			float t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+
+	for(int half = 1; half < _size; half *= 2) {
+		const float* wr = &_twiddleRe[half - 1];
+		const float* wi = &_twiddleIm[half - 1];
+		for(int block = 0; block < _size; block += 2 * half) {
+			float* ar = re + block;
+			float* ai = im + block;
+			float* br = ar + half;
+			float* bi = ai + half;
+			int k = 0;
+#ifdef FFT_SSE
+			for(; k + 4 <= half; k += 4) {
+				__m128 twr = _mm_loadu_ps(wr + k), twi = _mm_loadu_ps(wi + k);
+				__m128 xr = _mm_loadu_ps(br + k), xi = _mm_loadu_ps(bi + k);
+				__m128 tr = _mm_sub_ps(_mm_mul_ps(twr, xr), _mm_mul_ps(twi, xi));
+				__m128 ti = _mm_add_ps(_mm_mul_ps(twr, xi), _mm_mul_ps(twi, xr));
+				__m128 yr = _mm_loadu_ps(ar + k), yi = _mm_loadu_ps(ai + k);
+				_mm_storeu_ps(br + k, _mm_sub_ps(yr, tr));
+				_mm_storeu_ps(bi + k, _mm_sub_ps(yi, ti));
+				_mm_storeu_ps(ar + k, _mm_add_ps(yr, tr));
+				_mm_storeu_ps(ai + k, _mm_add_ps(yi, ti));
+			}
+#endif
+			for(; k < half; ++k) {
+				float tr = wr[k] * br[k] - wi[k] * bi[k];
+				float ti = wr[k] * bi[k] + wi[k] * br[k];
+				br[k] = ar[k] - tr;
+				bi[k] = ai[k] - ti;
+				ar[k] += tr;
+				ai[k] += ti;
+			}
+		}
+	}
+}
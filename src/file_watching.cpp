@@ -1,5 +1,13 @@
 #include "file_watching.h"
 
+#include <algorithm>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <errno.h>
+#endif
+
 namespace fwatch {
 
 #if defined(_WIN32)
@@ -18,6 +26,27 @@ bool checkFileModified(const char* path, Timestamp* lastTime) {
 	return modified;
 }
 
+std::vector<std::string> listFiles(const char* dir, const char* extension) {
+	std::vector<std::string> files;
+	WIN32_FIND_DATA data;
+	std::string pattern = std::string(dir) + "\\*" + extension;
+	HANDLE hFind = FindFirstFile(pattern.c_str(), &data);
+	if(hFind != INVALID_HANDLE_VALUE) {
+		do {
+			if(!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+				files.push_back(std::string(dir) + "\\" + data.cFileName);
+			}
+		} while(FindNextFile(hFind, &data));
+		FindClose(hFind);
+	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+bool makeDirectory(const char* dir) {
+	return CreateDirectory(dir, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
 #else
 
 bool checkFileModified(const char* path, Timestamp* lastTime) {
@@ -31,6 +60,32 @@ bool checkFileModified(const char* path, Timestamp* lastTime) {
 	return false;
 }
 
+std::vector<std::string> listFiles(const char* dir, const char* extension) {
+	std::vector<std::string> files;
+	DIR* d = opendir(dir);
+	if(!d) return files;
+
+	size_t extLength = strlen(extension);
+	struct dirent* entry;
+	while((entry = readdir(d)) != NULL) {
+		size_t length = strlen(entry->d_name);
+		if(length <= extLength || strcmp(entry->d_name + length - extLength, extension) != 0) continue;
+
+		std::string path = std::string(dir) + "/" + entry->d_name;
+		struct stat st;
+		if(stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+			files.push_back(path);
+		}
+	}
+	closedir(d);
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+bool makeDirectory(const char* dir) {
+	return mkdir(dir, 0755) == 0 || errno == EEXIST;
+}
+
 #endif
 
 };
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "frame_pacing.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <loguru/loguru.hpp>
+
+// At most this many frames are waited on for their fence
+static const size_t MAX_PENDING_FRAMES = 4;
+// Extra room kept before the vblank in LOW_LATENCY
+static const double LOW_LATENCY_SLACK = 0.001;
+
+FramePacer::FramePacer():_mode(VSYNC), _fpsCap(60.0), _refreshPeriod(1.0 / 60.0), _nextFrameTime(0.0), _inputTime(0.0),
+	_gpuInputTime(0), _timerQueries(false), _lastFlip(0.0), _workEstimate(0.0), _spinMargin(0.002), _latency(0.0), _maxLatency(0.0), _reportedMaxLatency(0.0),
+	_maxLatencyStart(0.0) {
+}
+
+void FramePacer::setMode(Mode mode, double fps) {
+	_mode = mode;
+	_fpsCap = fps > 0.0 ? fps : 60.0;
+}
+
+void FramePacer::reset() {
+	for(size_t i = 0; i < _pending.size(); ++i) {
+		if(_pending[i].fence) glDeleteSync(_pending[i].fence);
+		if(_pending[i].query) _freeQueries.push_back(_pending[i].query);
+	}
+	_pending.clear();
+	if(!_freeQueries.empty()) {
+		glDeleteQueries((GLsizei)_freeQueries.size(), &_freeQueries[0]);
+		_freeQueries.clear();
+	}
+	_lastFlip = 0.0;
+}
+
+void FramePacer::apply() {
+	reset();
+	glfwSwapInterval(_mode == VSYNC || _mode == LOW_LATENCY ? 1 : 0);
+
+	GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+	const GLFWvidmode* video = monitor ? glfwGetVideoMode(monitor) : NULL;
+	_refreshPeriod = 1.0 / (video && video->refreshRate > 0 ? video->refreshRate : 60);
+	_nextFrameTime = glfwGetTime();
+	_workEstimate = 0.0;
+	_latency = 0.0;
+	// GL_TIMESTAMP is core in 3.3, the context may be 3.2
+	_timerQueries = gl3wIsSupported(3, 3) != 0;
+
+	const char* names[] = { "vsync", "uncapped", "a frame rate cap", "low latency" };
+	LOG_F(INFO, "Presenting with %s on a %.1f Hz display", names[_mode], 1.0 / _refreshPeriod);
+	if(_mode == CAPPED) LOG_F(INFO, "Frame rate capped at %.1f fps", _fpsCap);
+}
+
+void FramePacer::sleepUntil(double time) {
+	double sleepEnd = time - _spinMargin;
+	double now = glfwGetTime();
+	if(sleepEnd > now) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(sleepEnd - now));
+		double oversleep = glfwGetTime() - sleepEnd;
+		// Follow the scheduler's wakeup jitter: jump up to what was seen, decay slowly
+		_spinMargin = oversleep * 1.5 > _spinMargin ? oversleep * 1.5 : _spinMargin * 0.99;
+		if(_spinMargin < 0.0002) _spinMargin = 0.0002;
+		if(_spinMargin > 0.02) _spinMargin = 0.02;
+	}
+	while(glfwGetTime() < time) {
+		// Spin for the remainder, sleeping can't be trusted to wake up in time
+	}
+}
+
+void FramePacer::beginFrame() {
+	collectPresented(false);
+
+	if(_mode == CAPPED) {
+		double period = 1.0 / _fpsCap;
+		_nextFrameTime += period;
+		double now = glfwGetTime();
+		// After a stall start over rather than rushing frames to catch up
+		if(_nextFrameTime < now - period) _nextFrameTime = now;
+		sleepUntil(_nextFrameTime);
+	} else if(_mode == LOW_LATENCY && _lastFlip > 0.0) {
+		double start = _lastFlip + _refreshPeriod - _workEstimate - LOW_LATENCY_SLACK;
+		if(start > glfwGetTime()) sleepUntil(start);
+	}
+}
+
+void FramePacer::markInputSampled() {
+	_inputTime = glfwGetTime();
+	if(_timerQueries && _mode != LOW_LATENCY) {
+		glGetInteger64v(GL_TIMESTAMP, &_gpuInputTime);
+	}
+}
+
+void FramePacer::present(GLFWwindow* window) {
+	if(_mode == LOW_LATENCY) {
+		// Nothing may queue up: wait for the GPU, then for the flip
+		glFinish();
+		double work = glfwGetTime() - _inputTime;
+		_workEstimate = work > _workEstimate ? work : _workEstimate * 0.98 + work * 0.02;
+		glfwSwapBuffers(window);
+		glFinish();
+		_lastFlip = glfwGetTime();
+		recordLatency(_lastFlip - _inputTime);
+		return;
+	}
+
+	glfwSwapBuffers(window);
+	PendingFrame frame;
+	frame.inputTime = _inputTime;
+	frame.gpuInputTime = _gpuInputTime;
+	frame.query = 0;
+	frame.fence = 0;
+	if(_timerQueries) {
+		if(_freeQueries.empty()) {
+			_freeQueries.push_back(0);
+			glGenQueries(1, &_freeQueries.back());
+		}
+		frame.query = _freeQueries.back();
+		_freeQueries.pop_back();
+		// Reached by the GPU once it's done with the frame and the swap
+		glQueryCounter(frame.query, GL_TIMESTAMP);
+	} else {
+		frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	_pending.push_back(frame);
+	// Don't let measuring hold up frames, but don't leak fences if they never get checked either
+	collectPresented(_pending.size() > MAX_PENDING_FRAMES);
+}
+
+void FramePacer::collectPresented(bool wait) {
+	while(!_pending.empty()) {
+		PendingFrame& frame = _pending.front();
+		if(frame.query) {
+			GLint available = 0;
+			if(!wait) glGetQueryObjectiv(frame.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if(!wait && !available) break;
+			// Both sides are GPU clock, so it doesn't matter how late the result is read
+			GLuint64 presented = 0;
+			glGetQueryObjectui64v(frame.query, GL_QUERY_RESULT, &presented);
+			if(presented > (GLuint64)frame.gpuInputTime) {
+				recordLatency((presented - frame.gpuInputTime) / 1e9);
+			}
+			_freeQueries.push_back(frame.query);
+		} else {
+			GLenum status = glClientWaitSync(frame.fence, 0, wait ? GL_TIMEOUT_IGNORED : 0);
+			if(status == GL_TIMEOUT_EXPIRED) break;
+			if(status != GL_WAIT_FAILED) {
+				recordLatency(glfwGetTime() - frame.inputTime);
+			}
+			glDeleteSync(frame.fence);
+		}
+		_pending.pop_front();
+		wait = false;
+	}
+}
+
+void FramePacer::recordLatency(double latency) {
+	_latency = _latency == 0.0 ? latency : _latency * 0.9 + latency * 0.1;
+	if(latency > _maxLatency) _maxLatency = latency;
+
+	double now = glfwGetTime();
+	if(now - _maxLatencyStart >= 1.0) {
+		_reportedMaxLatency = _maxLatency;
+		_maxLatency = 0.0;
+		_maxLatencyStart = now;
+	}
+}
+
+bool parsePresentMode(const char* spec, FramePacer::Mode& mode, double& fps) {
+	if(strcmp(spec, "vsync") == 0) {
+		mode = FramePacer::VSYNC;
+	} else if(strcmp(spec, "uncapped") == 0) {
+		mode = FramePacer::UNCAPPED;
+	} else if(strcmp(spec, "low-latency") == 0) {
+		mode = FramePacer::LOW_LATENCY;
+	} else {
+		char* end;
+		fps = strtod(spec, &end);
+		if(end == spec || *end != '\0' || fps <= 0.0) return false;
+		mode = FramePacer::CAPPED;
+	}
+	return true;
+}
@@ -0,0 +1,230 @@
+#include "frame_stats.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <GLFW/glfw3.h>
+
+// Frames whose GPU time isn't back yet before waiting for the oldest
+static const size_t MAX_PENDING_FRAMES = 8;
+
+void FrameTimeRing::push(const FrameSample& sample) {
+	uint64_t count = _count.load(std::memory_order_relaxed);
+	_samples[count % CAPACITY] = sample;
+	_count.store(count + 1, std::memory_order_release);
+}
+
+void FrameTimeRing::copy(std::vector<FrameSample>& out, size_t limit) const {
+	uint64_t end = _count.load(std::memory_order_acquire);
+	if(limit > CAPACITY) limit = CAPACITY;
+	uint64_t begin = end > limit ? end - limit : 0;
+	size_t first = out.size();
+	for(uint64_t i = begin; i < end; ++i) {
+		out.push_back(_samples[i % CAPACITY]);
+	}
+
+	// Sample i shares its slot with i + CAPACITY, which is being written once the count reaches it
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t now = _count.load(std::memory_order_relaxed);
+	if(now + 1 > begin + CAPACITY) {
+		uint64_t overwritten = now + 1 - CAPACITY - begin;
+		if(overwritten > end - begin) overwritten = end - begin;
+		out.erase(out.begin() + first, out.begin() + first + (size_t)overwritten);
+	}
+}
+
+void TimeHistogram::clear() {
+	memset(_counts, 0, sizeof(_counts));
+	_total = 0;
+	_maxMs = 0.0;
+}
+
+int TimeHistogram::bucketIndex(uint32_t us) {
+	if(us < SUB_BUCKETS * 2) return (int)us;
+	int msb = 0;
+	while((us >> msb) > 1) ++msb;
+	// Values in [32 << range, 64 << range)
+	int range = msb - 5;
+	if(range >= RANGES) return BUCKET_COUNT - 1;
+	int sub = (int)(us >> range) - SUB_BUCKETS;
+	return SUB_BUCKETS * 2 + (range - 1) * SUB_BUCKETS + sub;
+}
+
+uint32_t TimeHistogram::bucketHighest(int index) {
+	if(index < SUB_BUCKETS * 2) return (uint32_t)index;
+	int range = (index - SUB_BUCKETS * 2) / SUB_BUCKETS + 1;
+	uint32_t sub = (uint32_t)((index - SUB_BUCKETS * 2) % SUB_BUCKETS + SUB_BUCKETS);
+	return ((sub + 1) << range) - 1;
+}
+
+void TimeHistogram::record(double ms) {
+	if(ms < 0.0) return;
+	double us = ms * 1000.0;
+	++_counts[bucketIndex(us > 4e9 ? 4000000000u : (uint32_t)us)];
+	++_total;
+	if(ms > _maxMs) _maxMs = ms;
+}
+
+void TimeHistogram::add(const TimeHistogram& other) {
+	for(int i = 0; i < BUCKET_COUNT; ++i) {
+		_counts[i] += other._counts[i];
+	}
+	_total += other._total;
+	if(other._maxMs > _maxMs) _maxMs = other._maxMs;
+}
+
+double TimeHistogram::percentile(double p) const {
+	if(_total == 0) return 0.0;
+	uint64_t rank = (uint64_t)ceil(p / 100.0 * _total);
+	if(rank < 1) rank = 1;
+	uint64_t seen = 0;
+	for(int i = 0; i < BUCKET_COUNT; ++i) {
+		seen += _counts[i];
+		if(seen >= rank) {
+			double ms = bucketHighest(i) / 1000.0;
+			return ms < _maxMs ? ms : _maxMs;
+		}
+	}
+	return _maxMs;
+}
+
+FrameStats::FrameStats():_lastStart(0.0), _frame(0), _seconds(60 * SERIES_COUNT), _secondIndex(0), _secondStart(0.0) {
+	memset(&_current, 0, sizeof(_current));
+	memset(_percentiles, 0, sizeof(_percentiles));
+}
+
+void FrameStats::reset() {
+	for(size_t i = 0; i < _pending.size(); ++i) {
+		_freeQueries.push_back(_pending[i].query);
+	}
+	_pending.clear();
+	if(!_freeQueries.empty()) {
+		glDeleteQueries((GLsizei)_freeQueries.size(), &_freeQueries[0]);
+		_freeQueries.clear();
+	}
+}
+
+void FrameStats::beginFrame() {
+	double now = glfwGetTime();
+	if(_secondStart == 0.0) _secondStart = now;
+	collect(false);
+
+	_current.frame = _frame++;
+	_current.start = now;
+	_current.intervalMs = _lastStart > 0.0 ? (float)((now - _lastStart) * 1000.0) : -1.0f;
+	_lastStart = now;
+
+	GLuint query = 0;
+	// GL_TIME_ELAPSED is core in 3.3, the context may be 3.2
+	if(gl3wIsSupported(3, 3)) {
+		if(_freeQueries.empty()) {
+			glGenQueries(1, &query);
+		} else {
+			query = _freeQueries.back();
+			_freeQueries.pop_back();
+		}
+		glBeginQuery(GL_TIME_ELAPSED, query);
+	}
+	_pending.push_back(PendingFrame());
+	_pending.back().query = query;
+}
+
+void FrameStats::endFrame() {
+	PendingFrame& frame = _pending.back();
+	_current.cpuMs = (float)((glfwGetTime() - _current.start) * 1000.0);
+	_current.gpuMs = -1.0f;
+	frame.sample = _current;
+	if(frame.query) glEndQuery(GL_TIME_ELAPSED);
+	collect(_pending.size() > MAX_PENDING_FRAMES);
+}
+
+void FrameStats::collect(bool wait) {
+	while(!_pending.empty()) {
+		PendingFrame& frame = _pending.front();
+		// The frame being drawn isn't done before endFrame()
+		if(frame.sample.start == 0.0) break;
+		if(frame.query) {
+			GLint available = 0;
+			if(!wait) glGetQueryObjectiv(frame.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if(!wait && !available) break;
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(frame.query, GL_QUERY_RESULT, &elapsed);
+			frame.sample.gpuMs = (float)(elapsed / 1e6);
+			_freeQueries.push_back(frame.query);
+		}
+		record(frame.sample);
+		_pending.pop_front();
+		wait = false;
+	}
+}
+
+void FrameStats::record(const FrameSample& sample) {
+	_ring.push(sample);
+
+	double now = glfwGetTime();
+	while(now - _secondStart >= 1.0) {
+		rollSecond(now);
+	}
+
+	float values[SERIES_COUNT] = { sample.intervalMs, sample.cpuMs, sample.gpuMs };
+	for(int s = 0; s < SERIES_COUNT; ++s) {
+		_seconds[_secondIndex * SERIES_COUNT + s].record(values[s]);
+		_allTime[s].record(values[s]);
+	}
+}
+
+/* Closes the current second, updates the percentiles and starts the next */
+void FrameStats::rollSecond(double now) {
+	static const int windowSeconds[WINDOW_COUNT - 1] = { 1, 10, 60 };
+	for(int s = 0; s < SERIES_COUNT; ++s) {
+		TimeHistogram merged;
+		int merges = 0;
+		for(int w = 0; w < WINDOW_COUNT; ++w) {
+			const TimeHistogram* histogram = &_allTime[s];
+			if(w != ALL_TIME) {
+				for(; merges < windowSeconds[w]; ++merges) {
+					merged.add(_seconds[(_secondIndex + 60 - merges) % 60 * SERIES_COUNT + s]);
+				}
+				histogram = &merged;
+			}
+			FrameTimePercentiles& p = _percentiles[w][s];
+			p.p50 = histogram->percentile(50.0);
+			p.p95 = histogram->percentile(95.0);
+			p.p99 = histogram->percentile(99.0);
+			p.max = histogram->getMax();
+			p.count = histogram->getTotal();
+		}
+	}
+
+	_secondIndex = (_secondIndex + 1) % 60;
+	for(int s = 0; s < SERIES_COUNT; ++s) {
+		_seconds[_secondIndex * SERIES_COUNT + s].clear();
+	}
+	_secondStart += 1.0;
+	// After a long stall every second in the windows is empty, don't roll through them one by one
+	if(now - _secondStart > 60.0) {
+		for(size_t i = 0; i < _seconds.size(); ++i) {
+			_seconds[i].clear();
+		}
+		_secondStart = now - 1.0;
+	}
+}
+
+bool FrameStats::writeCSV(const char* path) const {
+	std::vector<FrameSample> samples;
+	_ring.copy(samples);
+
+	FILE* f = fopen(path, "w");
+	if(!f) {
+		LOG_F(ERROR, "Couldn't write frame times to '%s'", path);
+		return false;
+	}
+	fprintf(f, "frame,start_s,interval_ms,cpu_ms,gpu_ms\n");
+	for(size_t i = 0; i < samples.size(); ++i) {
+		const FrameSample& s = samples[i];
+		fprintf(f, "%llu,%.6f,%.3f,%.3f,%.3f\n", (unsigned long long)s.frame, s.start, s.intervalMs, s.cpuMs, s.gpuMs);
+	}
+	fclose(f);
+	LOG_F(INFO, "Wrote %d frame times to '%s'", (int)samples.size(), path);
+	return true;
+}
@@ -0,0 +1,107 @@
+#include "gl_debug.h"
+
+#include <string.h>
+#include <loguru/loguru.hpp>
+
+static bool debugSupported = false;
+static bool debugOutput = false;
+
+static const char* sourceName(GLenum source) {
+	switch(source) {
+		case GL_DEBUG_SOURCE_API: return "API";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+		case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+		case GL_DEBUG_SOURCE_APPLICATION: return "application";
+		default: return "other";
+	}
+}
+
+static const char* typeName(GLenum type) {
+	switch(type) {
+		case GL_DEBUG_TYPE_ERROR: return "error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+		case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+		case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+		default: return "message";
+	}
+}
+
+/* May be called from driver threads, loguru is thread safe */
+static void APIENTRY logDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                     const GLchar* message, const void* userParam) {
+	(void)userParam;
+	if(length < 0) length = (GLsizei)strlen(message);
+	int verbosity = loguru::Verbosity_INFO;
+	if(severity == GL_DEBUG_SEVERITY_HIGH || type == GL_DEBUG_TYPE_ERROR) {
+		verbosity = loguru::Verbosity_ERROR;
+	} else if(severity == GL_DEBUG_SEVERITY_MEDIUM) {
+		verbosity = loguru::Verbosity_WARNING;
+	}
+	VLOG_F(verbosity, "GL %s %s 0x%x: %.*s", sourceName(source), typeName(type), id, (int)length, message);
+}
+
+void initGLDebug() {
+	debugSupported = false;
+	debugOutput = false;
+
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for(GLint i = 0; i < count; ++i) {
+		if(strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), "GL_KHR_debug") == 0) {
+			debugSupported = true;
+			break;
+		}
+	}
+	// gl3w resolves the core names, KHR_debug in a core context uses the same ones
+	debugSupported = debugSupported && glDebugMessageCallback && glPushDebugGroup && glObjectLabel;
+	if(!debugSupported) {
+		LOG_F(INFO, "GL_KHR_debug isn't available, no debug output, groups or labels");
+		return;
+	}
+
+#if SHADE_GL_DEBUG
+	GLint flags = 0;
+	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+	if(!(flags & GL_CONTEXT_FLAG_DEBUG_BIT)) {
+		LOG_F(INFO, "Not a debug context, the driver may not report everything");
+	}
+
+	glDebugMessageCallback(logDebugMessage, NULL);
+	// Notifications are chatty (buffer placement, our own groups) and cost a call each
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
+	glEnable(GL_DEBUG_OUTPUT);
+#if CHECK_OPENGL
+	// Messages on the thread and in the call that caused them, as precise as glGetError, and as slow
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+	debugOutput = true;
+	LOG_F(INFO, "Logging GL debug output");
+#endif
+}
+
+bool isGLDebugSupported() {
+	return debugSupported;
+}
+
+bool isGLDebugOutputEnabled() {
+	return debugOutput;
+}
+
+void labelGLObject(GLenum identifier, GLuint name, const std::string& label) {
+	if(!debugSupported || name == 0) return;
+	glObjectLabel(identifier, name, (GLsizei)label.size(), label.c_str());
+}
+
+GLDebugGroup::GLDebugGroup(const char* name):_pushed(debugSupported) {
+	if(_pushed) glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+}
+
+GLDebugGroup::GLDebugGroup(const std::string& name):_pushed(debugSupported) {
+	if(_pushed) glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, (GLsizei)name.size(), name.c_str());
+}
+
+GLDebugGroup::~GLDebugGroup() {
+	if(_pushed) glPopDebugGroup();
+}
@@ -0,0 +1,64 @@
+#include "gl_objects.h"
+
+#include <map>
+#include <loguru/loguru.hpp>
+
+struct GLObjectSite {
+	const char* file;
+	int line;
+};
+
+static const char* typeNames[GL_OBJECT_TYPE_COUNT] = {
+	"shader", "program", "buffer", "texture", "framebuffer", "vertex array", "sampler"
+};
+
+// GL calls are made from the thread owning the context only, so no locking
+static std::map<GLuint, GLObjectSite> liveObjects[GL_OBJECT_TYPE_COUNT];
+static int staleDeletes = 0;
+
+const char* getGLObjectTypeName(GLObjectType type) {
+	return typeNames[type];
+}
+
+int getLiveGLObjects(GLObjectType type) {
+	return (int)liveObjects[type].size();
+}
+
+int getStaleGLDeletes() {
+	return staleDeletes;
+}
+
+void trackGLObjectsCreated(GLObjectType type, GLsizei count, const GLuint* names, const char* file, int line) {
+	for(GLsizei i = 0; i < count; ++i) {
+		GLObjectSite site = { file, line };
+		liveObjects[type][names[i]] = site;
+	}
+}
+
+void trackGLObjectsDeleted(GLObjectType type, GLsizei count, const GLuint* names, const char* file, int line) {
+	for(GLsizei i = 0; i < count; ++i) {
+		// Deleting 0 is a no-op in GL
+		if(names[i] == 0) continue;
+		if(liveObjects[type].erase(names[i]) == 0) {
+			++staleDeletes;
+			LOG_F(ERROR, "%s:%d deletes %s %u, which isn't live (deleted twice?)", file, line, typeNames[type], names[i]);
+		}
+	}
+}
+
+void logLiveGLObjects(bool details) {
+#if TRACK_GL_OBJECTS
+	LOG_F(INFO, "Live GL objects: %d shaders, %d programs, %d buffers, %d textures, %d framebuffers, %d vertex arrays, %d samplers",
+		getLiveGLObjects(GL_OBJECT_SHADER), getLiveGLObjects(GL_OBJECT_PROGRAM), getLiveGLObjects(GL_OBJECT_BUFFER),
+		getLiveGLObjects(GL_OBJECT_TEXTURE), getLiveGLObjects(GL_OBJECT_FRAMEBUFFER), getLiveGLObjects(GL_OBJECT_VERTEX_ARRAY),
+		getLiveGLObjects(GL_OBJECT_SAMPLER));
+	if(!details) return;
+
+	for(int type = 0; type < GL_OBJECT_TYPE_COUNT; ++type) {
+		std::map<GLuint, GLObjectSite>::const_iterator it;
+		for(it = liveObjects[type].begin(); it != liveObjects[type].end(); ++it) {
+			LOG_F(INFO, "    %s %u created at %s:%d", typeNames[type], it->first, it->second.file, it->second.line);
+		}
+	}
+#endif
+}
@@ -0,0 +1,101 @@
+#include "input_log.h"
+
+#include <string.h>
+#include <loguru/loguru.hpp>
+
+static const char INPUT_LOG_MAGIC[4] = { 'S', 'H', 'D', 'I' };
+static const uint32_t INPUT_LOG_VERSION = 1;
+
+bool InputRecorder::open(const char* path, int width, int height) {
+	close();
+	_file = fopen(path, "wb");
+	if(!_file) {
+		LOG_F(ERROR, "Couldn't open '%s' for recording", path);
+		return false;
+	}
+
+	uint32_t header[3] = { INPUT_LOG_VERSION, (uint32_t)width, (uint32_t)height };
+	fwrite(INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC), 1, _file);
+	fwrite(header, sizeof(header), 1, _file);
+	_frames = 0;
+	return true;
+}
+
+void InputRecorder::record(const InputFrame& frame) {
+	if(!_file) return;
+
+	// Fields are written one by one so the file has no struct padding
+	uint8_t keyCount = frame.keys.size() > 255 ? 255 : (uint8_t)frame.keys.size();
+	fwrite(&frame.time, sizeof(frame.time), 1, _file);
+	fwrite(frame.mouse, sizeof(frame.mouse), 1, _file);
+	fwrite(&frame.buttons, sizeof(frame.buttons), 1, _file);
+	fwrite(&keyCount, sizeof(keyCount), 1, _file);
+	for(uint8_t i = 0; i < keyCount; ++i) {
+		fwrite(&frame.keys[i].key, sizeof(frame.keys[i].key), 1, _file);
+		fwrite(&frame.keys[i].action, sizeof(frame.keys[i].action), 1, _file);
+	}
+	++_frames;
+}
+
+void InputRecorder::close() {
+	if(_file) {
+		fclose(_file);
+		_file = NULL;
+		LOG_F(INFO, "Recorded %d frames of input", (int)_frames);
+	}
+}
+
+bool InputLog::load(const char* path) {
+	_frames.clear();
+	FILE* f = fopen(path, "rb");
+	if(!f) {
+		LOG_F(ERROR, "Couldn't open input log '%s'", path);
+		return false;
+	}
+
+	char magic[4];
+	uint32_t header[3];
+	if(fread(magic, sizeof(magic), 1, f) != 1 || memcmp(magic, INPUT_LOG_MAGIC, sizeof(magic)) != 0 ||
+	   fread(header, sizeof(header), 1, f) != 1 || header[0] != INPUT_LOG_VERSION) {
+		LOG_F(ERROR, "'%s' isn't a Shade input log", path);
+		fclose(f);
+		return false;
+	}
+	_width = header[1];
+	_height = header[2];
+
+	InputFrame frame;
+	uint8_t keyCount;
+	while(fread(&frame.time, sizeof(frame.time), 1, f) == 1 &&
+	      fread(frame.mouse, sizeof(frame.mouse), 1, f) == 1 &&
+	      fread(&frame.buttons, sizeof(frame.buttons), 1, f) == 1 &&
+	      fread(&keyCount, sizeof(keyCount), 1, f) == 1) {
+		frame.keys.resize(keyCount);
+		bool complete = true;
+		for(uint8_t i = 0; i < keyCount && complete; ++i) {
+			complete = fread(&frame.keys[i].key, sizeof(frame.keys[i].key), 1, f) == 1 &&
+			           fread(&frame.keys[i].action, sizeof(frame.keys[i].action), 1, f) == 1;
+		}
+		// A session that was killed can end with a truncated frame
+		if(!complete) break;
+		_frames.push_back(frame);
+	}
+	fclose(f);
+
+	LOG_F(INFO, "Loaded %d frames of input from '%s'", (int)_frames.size(), path);
+	return !_frames.empty();
+}
+
+size_t InputLog::frameAt(double time) const {
+	if(_frames.empty()) return 0;
+	double target = _frames[0].time + time;
+
+	// Binary search for the last frame with frame.time <= target
+	size_t lo = 0, hi = _frames.size();
+	while(hi - lo > 1) {
+		size_t mid = (lo + hi) / 2;
+		if(_frames[mid].time <= target) lo = mid;
+		else hi = mid;
+	}
+	return lo;
+}
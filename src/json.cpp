@@ -0,0 +1,259 @@
+#include "json.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const JsonValue NULL_VALUE;
+
+size_t JsonValue::size() const {
+	if(_type == ARRAY) return _array.size();
+	if(_type == OBJECT) return _object.size();
+	return 0;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+	if(_type != ARRAY || index >= _array.size()) return NULL_VALUE;
+	return _array[index];
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const {
+	if(_type != OBJECT) return NULL_VALUE;
+	for(size_t i = 0; i < _object.size(); ++i) {
+		if(_object[i].first == key) return _object[i].second;
+	}
+	return NULL_VALUE;
+}
+
+std::string JsonValue::asString(const std::string& fallback) const {
+	if(_type == STRING) return _string;
+	if(_type == NUMBER) {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%.17g", _number);
+		return buffer;
+	}
+	return fallback;
+}
+
+double JsonValue::asNumber(double fallback) const {
+	if(_type == NUMBER) return _number;
+	if(_type == STRING && !_string.empty()) return atof(_string.c_str());
+	return fallback;
+}
+
+bool JsonValue::asBool(bool fallback) const {
+	if(_type == BOOLEAN) return _boolean;
+	// Some exporters write booleans as strings
+	if(_type == STRING) return _string == "true";
+	if(_type == NUMBER) return _number != 0.0;
+	return fallback;
+}
+
+/* Recursive descent parser over the whole text */
+class JsonParser {
+public:
+	JsonParser(const std::string& text):_text(text), _pos(0) {}
+
+	bool parseDocument(JsonValue& value, std::string& error) {
+		if(!parseValue(value, 0)) {
+			char message[64];
+			snprintf(message, sizeof(message), " at offset %d", (int)_pos);
+			error = _error + message;
+			return false;
+		}
+		skipWhitespace();
+		if(_pos != _text.size()) {
+			error = "Trailing characters after JSON value";
+			return false;
+		}
+		return true;
+	}
+
+private:
+	static const int MAX_DEPTH = 256;
+
+	void skipWhitespace() {
+		while(_pos < _text.size() && strchr(" \t\r\n", _text[_pos]) && _text[_pos] != '\0') ++_pos;
+	}
+
+	bool fail(const char* message) {
+		_error = message;
+		return false;
+	}
+
+	bool match(const char* literal) {
+		size_t length = strlen(literal);
+		if(_text.compare(_pos, length, literal) != 0) return false;
+		_pos += length;
+		return true;
+	}
+
+	bool parseValue(JsonValue& value, int depth) {
+		if(depth > MAX_DEPTH) return fail("Nesting too deep");
+		skipWhitespace();
+		if(_pos >= _text.size()) return fail("Unexpected end of input");
+
+		char c = _text[_pos];
+		if(c == '{') return parseObject(value, depth);
+		if(c == '[') return parseArray(value, depth);
+		if(c == '"') {
+			value._type = JsonValue::STRING;
+			return parseString(value._string);
+		}
+		if(match("true")) {
+			value._type = JsonValue::BOOLEAN;
+			value._boolean = true;
+			return true;
+		}
+		if(match("false")) {
+			value._type = JsonValue::BOOLEAN;
+			value._boolean = false;
+			return true;
+		}
+		if(match("null")) {
+			value._type = JsonValue::NUL;
+			return true;
+		}
+		if(c == '-' || (c >= '0' && c <= '9')) {
+			const char* start = _text.c_str() + _pos;
+			char* end;
+			value._type = JsonValue::NUMBER;
+			value._number = strtod(start, &end);
+			_pos += end - start;
+			return true;
+		}
+		return fail("Unexpected character");
+	}
+
+	bool parseObject(JsonValue& value, int depth) {
+		value._type = JsonValue::OBJECT;
+		++_pos;
+		skipWhitespace();
+		if(_pos < _text.size() && _text[_pos] == '}') {
+			++_pos;
+			return true;
+		}
+		while(true) {
+			skipWhitespace();
+			std::string key;
+			if(_pos >= _text.size() || _text[_pos] != '"' || !parseString(key)) return fail("Expected member name");
+			skipWhitespace();
+			if(_pos >= _text.size() || _text[_pos] != ':') return fail("Expected ':'");
+			++_pos;
+			value._object.push_back(std::make_pair(key, JsonValue()));
+			if(!parseValue(value._object.back().second, depth + 1)) return false;
+			skipWhitespace();
+			if(_pos < _text.size() && _text[_pos] == ',') {
+				++_pos;
+			} else if(_pos < _text.size() && _text[_pos] == '}') {
+				++_pos;
+				return true;
+			} else {
+				return fail("Expected ',' or '}'");
+			}
+		}
+	}
+
+	bool parseArray(JsonValue& value, int depth) {
+		value._type = JsonValue::ARRAY;
+		++_pos;
+		skipWhitespace();
+		if(_pos < _text.size() && _text[_pos] == ']') {
+			++_pos;
+			return true;
+		}
+		while(true) {
+			value._array.push_back(JsonValue());
+			if(!parseValue(value._array.back(), depth + 1)) return false;
+			skipWhitespace();
+			if(_pos < _text.size() && _text[_pos] == ',') {
+				++_pos;
+			} else if(_pos < _text.size() && _text[_pos] == ']') {
+				++_pos;
+				return true;
+			} else {
+				return fail("Expected ',' or ']'");
+			}
+		}
+	}
+
+	static void appendUTF8(std::string& out, unsigned code) {
+		if(code < 0x80) {
+			out += (char)code;
+		} else if(code < 0x800) {
+			out += (char)(0xC0 | (code >> 6));
+			out += (char)(0x80 | (code & 0x3F));
+		} else if(code < 0x10000) {
+			out += (char)(0xE0 | (code >> 12));
+			out += (char)(0x80 | ((code >> 6) & 0x3F));
+			out += (char)(0x80 | (code & 0x3F));
+		} else {
+			out += (char)(0xF0 | (code >> 18));
+			out += (char)(0x80 | ((code >> 12) & 0x3F));
+			out += (char)(0x80 | ((code >> 6) & 0x3F));
+			out += (char)(0x80 | (code & 0x3F));
+		}
+	}
+
+	bool parseHex4(unsigned& code) {
+		if(_pos + 4 > _text.size()) return false;
+		code = 0;
+		for(int i = 0; i < 4; ++i) {
+			char c = _text[_pos++];
+			code <<= 4;
+			if(c >= '0' && c <= '9') code |= c - '0';
+			else if(c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+			else if(c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+			else return false;
+		}
+		return true;
+	}
+
+	bool parseString(std::string& out) {
+		++_pos;
+		while(_pos < _text.size()) {
+			char c = _text[_pos++];
+			if(c == '"') return true;
+			if(c != '\\') {
+				out += c;
+				continue;
+			}
+			if(_pos >= _text.size()) break;
+			c = _text[_pos++];
+			switch(c) {
+			case '"': case '\\': case '/': out += c; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u': {
+				unsigned code;
+				if(!parseHex4(code)) return fail("Invalid \\u escape");
+				// Surrogate pair
+				if(code >= 0xD800 && code < 0xDC00 && _text.compare(_pos, 2, "\\u") == 0) {
+					_pos += 2;
+					unsigned low;
+					if(!parseHex4(low)) return fail("Invalid \\u escape");
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				}
+				appendUTF8(out, code);
+				break;
+			}
+			default:
+				return fail("Invalid escape");
+			}
+		}
+		return fail("Unterminated string");
+	}
+
+	const std::string& _text;
+	size_t _pos;
+	std::string _error;
+};
+
+bool JsonValue::parse(const std::string& text, JsonValue& value, std::string& error) {
+	value = JsonValue();
+	JsonParser parser(text);
+	return parser.parseDocument(value, error);
+}
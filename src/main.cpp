@@ -1,4 +1,5 @@
 #include "app.h"
+#include "shadertoy.h"
 #include <cli/cli.h>
 
 void printUsage();
@@ -12,10 +13,62 @@ int main(int argc, const char* argv[]) {
     int windowWidth = 800;
     int windowHeight = 600;
 
+    const char* batchDir = NULL;
+    const char* outDir = NULL;
+    const char* frames = NULL;
+    int fps = 60;
+    const char* shard = NULL;
+    bool contiguousShard = false;
+    int workers = 0;
+    const char* shmName = NULL;
+    const char* socketPath = NULL;
+    const char* recordFile = NULL;
+    const char* replayFile = NULL;
+    const char* replaySpeed = "1";
+    const char* channels[CHANNEL_COUNT] = { NULL, NULL, NULL, NULL };
+    const char* soundOut = NULL;
+    const char* duration = "60";
+    int sampleRate = 44100;
+    const char* present = "vsync";
+    const char* frameTimesFile = NULL;
+    const char* galleryDir = NULL;
+    const char* tileBudget = NULL;
+    const char* playlistFile = NULL;
+    const char* crossfade = NULL;
+    bool fullscreen = false;
+    int monitor = -1;
+
     cli::Parser parser = {
         cli::OptionFlag('v', "verbose", "output logging info", &verbose),
         cli::OptionInt('w', "width", "window width", false, &windowWidth),
-        cli::OptionInt('h', "height", "window height", false, &windowHeight)
+        cli::OptionInt('h', "height", "window height", false, &windowHeight),
+        cli::OptionString('P', "present", "vsync (default), uncapped, low-latency, or a frame rate cap such as 144", false, &present),
+        cli::OptionString('g', "gallery", "show every .glsl file in a directory side by side", false, &galleryDir),
+        cli::OptionString('B', "budget", "GPU milliseconds per frame for redrawing the tiles of the grid (default 8)", false, &tileBudget),
+        cli::OptionString('l', "playlist", "show the shaders of a playlist file in turn", false, &playlistFile),
+        cli::OptionString('X', "crossfade", "seconds of the crossfade between playlist entries (default 1.5)", false, &crossfade),
+        cli::OptionFlag('F', "fullscreen", "start fullscreen, F11 toggles", &fullscreen),
+        cli::OptionInt('M', "monitor", "monitor to go fullscreen on, 0 is the primary (default: the window's)", false, &monitor),
+        cli::OptionString('T', "frame-times", "write the time of every frame of the session to this CSV file", false, &frameTimesFile),
+        cli::OptionString('b', "batch", "render every .glsl file in a directory (requires --out)", false, &batchDir),
+        cli::OptionString('o', "out", "render frames headlessly to this directory", false, &outDir),
+        cli::OptionString('f', "frames", "frames to render, eg. 0-59 or 0,30,60 (default 0)", false, &frames),
+        cli::OptionInt('r', "fps", "frame rate used to compute time when rendering frames (default 60)", false, &fps),
+        cli::OptionString('s', "shard", "render only shard K/N of the frames (every Nth frame from K)", false, &shard),
+        cli::OptionFlag('c', "contiguous", "shards are contiguous blocks of frames instead of interleaved", &contiguousShard),
+        cli::OptionInt('j', "workers", "render the frames with this many worker processes, projects whose frames depend on earlier ones use one", false, &workers),
+        cli::OptionString('m', "shm", "publish rendered frames to a POSIX shared-memory ring with this name", false, &shmName),
+        cli::OptionString('S', "serve", "run a render server on this Unix domain socket", false, &socketPath),
+        cli::OptionString('R', "record", "record mouse, keyboard and time of every frame to a file", false, &recordFile),
+        cli::OptionString('p', "replay", "drive inputs from a recording instead of the live session", false, &replayFile),
+        cli::OptionString('x', "replay-speed", "replay speed, 0 renders each recorded frame once as fast as possible (default 1)", false, &replaySpeed),
+        cli::OptionString('0', "channel0", "texture input bound to iChannel0 (keyboard, audio:FILE.wav, video:FILE, sequence:PATTERN[@FPS])", false, &channels[0]),
+        cli::OptionString('1', "channel1", "texture input bound to iChannel1", false, &channels[1]),
+        cli::OptionString('2', "channel2", "texture input bound to iChannel2", false, &channels[2]),
+        cli::OptionString('3', "channel3", "texture input bound to iChannel3", false, &channels[3]),
+        cli::OptionString('a', "sound", "render a mainSound() shader to this WAV file, - for stdout", false, &soundOut),
+        cli::OptionString('d', "duration", "length of the rendered sound in seconds (default 60)", false, &duration),
+        cli::OptionInt('k', "sample-rate", "sample rate of the rendered sound (default 44100)", false, &sampleRate)
     };
 
     if(!parser.parse(argc, argv)) {
@@ -37,19 +90,135 @@ int main(int argc, const char* argv[]) {
         loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
     }
 
-    if(!app.init("Shade", windowWidth, windowHeight)) {
+    // Exports of a recording render every recorded frame by default
+    InputLog replayLog;
+    if(replayFile && !replayLog.load(replayFile)) {
+        return EXIT_FAILURE;
+    }
+    if(!frames) {
+        frames = "0";
+        if(replayFile) {
+            static char allFrames[32];
+            snprintf(allFrames, sizeof(allFrames), "0-%d", (int)replayLog.size() - 1);
+            frames = allFrames;
+        }
+    }
+
+    ExportSettings exportSettings;
+    if(outDir) {
+        exportSettings.outDir = outDir;
+        exportSettings.fps = fps;
+        if(fps <= 0 || !parseFrameList(frames, exportSettings.frames)) {
+            fprintf(stderr, "Invalid frame list '%s' or fps %d\n", frames, fps);
+            return EXIT_FAILURE;
+        }
+        if(shard && !applyShard(shard, contiguousShard, exportSettings.frames)) {
+            fprintf(stderr, "Invalid shard '%s', expected K/N with 0 <= K < N\n", shard);
+            return EXIT_FAILURE;
+        }
+    } else if(batchDir) {
+        fprintf(stderr, "--batch requires --out\n");
+        return EXIT_FAILURE;
+    }
+
+    if(workers > 0) {
+        if(!outDir || batchDir) {
+            fprintf(stderr, "--workers requires --out with a single shader\n");
+            return EXIT_FAILURE;
+        }
+        bool carriesState = shaderFile && isShaderToyProject(shaderFile) && shaderToyProjectCarriesState(shaderFile);
+        return runShardCoordinator(argc, argv, exportSettings, shaderFile ? fileStem(shaderFile) : "default", workers, carriesState);
+    }
+
+    FramePacer::Mode presentMode;
+    double fpsCap = 60.0;
+    if(!parsePresentMode(present, presentMode, fpsCap)) {
+        fprintf(stderr, "Invalid present mode '%s'\n", present);
+        return EXIT_FAILURE;
+    }
+    app.setPresentMode(presentMode, fpsCap);
+    if(frameTimesFile) {
+        app.setFrameTimesFile(frameTimesFile);
+    }
+    if(fullscreen) {
+        app.setFullscreen(true, monitor);
+    }
+
+    if(!app.init("Shade", windowWidth, windowHeight, outDir != NULL || socketPath != NULL || soundOut != NULL)) {
+        return EXIT_FAILURE;
+    }
+
+    if(soundOut) {
+        SoundSettings soundSettings;
+        soundSettings.output = soundOut;
+        soundSettings.duration = atof(duration);
+        soundSettings.sampleRate = sampleRate;
+        if(!shaderFile || soundSettings.duration <= 0.0 || sampleRate <= 0) {
+            fprintf(stderr, "--sound needs a shader file, a positive duration and sample rate\n");
+            return EXIT_FAILURE;
+        }
+        return app.renderSound(shaderFile, soundSettings);
+    }
+
+    if(socketPath) {
+        return app.runServer(socketPath);
+    }
+
+    if(shmName && !app.enableShmOutput(shmName)) {
+        return EXIT_FAILURE;
+    }
+
+    for(int i = 0; i < CHANNEL_COUNT; ++i) {
+        if(channels[i] && !app.setChannel(i, channels[i])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(recordFile && !app.startRecording(recordFile)) {
         return EXIT_FAILURE;
     }
 
+    if(replayFile) {
+        app.startReplay(replayLog, atof(replaySpeed));
+    }
+
+    if(batchDir) {
+        return app.runBatch(batchDir, exportSettings);
+    }
+
     if(shaderFile)
         app.loadFragmentShader(shaderFile);
 
+    if(outDir) {
+        return app.exportFrames(exportSettings);
+    }
+
+    // More than one shader are shown side by side, the first is the one shown alone
+    for(size_t i = 0; parser.getRemainingArgs().size() > 1 && i < parser.getRemainingArgs().size(); ++i) {
+        app.addView(parser.getRemainingArgs()[i]);
+    }
+    if(galleryDir && app.addGallery(galleryDir) == 0) {
+        return EXIT_FAILURE;
+    }
+    if(tileBudget) {
+        app.setTileBudget(atof(tileBudget));
+    }
+    if(playlistFile && !app.startPlaylist(playlistFile, crossfade ? atof(crossfade) : DEFAULT_CROSSFADE_TIME)) {
+        return EXIT_FAILURE;
+    }
+
     return app.runLoop();
 }
 
 
 void printUsage() {
     fprintf(stderr, 
-        "Usage: shade [options] [SHADER_FILE]\n\n"
-        "    Renders the shader in a window.\n\n");
+        "Usage: shade [options] [SHADER_FILE...]\n"
+        "       shade [options] --gallery DIR\n"
+        "       shade [options] --playlist FILE\n"
+        "       shade [options] --out DIR [SHADER_FILE]\n"
+        "       shade [options] --batch DIR --out DIR\n"
+        "       shade [options] --serve SOCKET\n"
+        "       shade [options] --sound FILE.wav SHADER_FILE\n\n"
+        "    Renders the shader in a window, or renders frames to image files.\n\n");
 }
\ No newline at end of file
@@ -0,0 +1,400 @@
+#include "parameters.h"
+
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Annotation {
+	bool hasRange;
+	float minValue;
+	float maxValue;
+	bool isColor;
+};
+
+static const char* builtinUniforms[] = {
+	"iTime", "iResolution", "iMouse",
+	"iChannel0", "iChannel1", "iChannel2", "iChannel3",
+	"iChannelResolution", "iChannelResolution[0]",
+	"iFrame", "iTimeDelta", "iFrameRate", "iDate", "iSampleRate", "iChannelTime", "iChannelTime[0]"
+};
+
+bool isBuiltinUniform(const std::string& name) {
+	for(size_t i = 0; i < sizeof(builtinUniforms) / sizeof(builtinUniforms[0]); ++i) {
+		if(name == builtinUniforms[i]) return true;
+	}
+	return false;
+}
+
+static bool isIdentChar(char c) {
+	return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+/* Reads the next identifier starting at pos, skipping leading whitespace */
+static std::string nextIdentifier(const std::string& line, size_t& pos) {
+	while(pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+	size_t start = pos;
+	while(pos < line.size() && isIdentChar(line[pos])) ++pos;
+	return line.substr(start, pos - start);
+}
+
+static void parseComment(const std::string& comment, Annotation& annotation) {
+	size_t range = comment.find("range(");
+	if(range != std::string::npos) {
+		const char* args = comment.c_str() + range + 6;
+		char* end = nullptr;
+		float minValue = strtof(args, &end);
+		if(end != args) {
+			while(*end == ' ' || *end == ',') ++end;
+			const char* second = end;
+			float maxValue = strtof(second, &end);
+			if(end != second && maxValue > minValue) {
+				annotation.hasRange = true;
+				annotation.minValue = minValue;
+				annotation.maxValue = maxValue;
+			}
+		}
+	}
+	if(comment.find("color") != std::string::npos) {
+		annotation.isColor = true;
+	}
+}
+
+/**
+ * Recognizes lines declaring a single uniform, eg. "uniform float speed = 1.0; // ..."
+ * Returns the uniform's name and the position of a trailing // comment, if any.
+ */
+static bool parseUniformDeclaration(const std::string& line, std::string& name, size_t& comment) {
+	comment = line.find("//");
+
+	size_t pos = 0;
+	if(nextIdentifier(line, pos) != "uniform") return false;
+	std::string token = nextIdentifier(line, pos);
+	if(token == "lowp" || token == "mediump" || token == "highp") {
+		token = nextIdentifier(line, pos);
+	}
+	name = nextIdentifier(line, pos);
+	if(token.empty() || name.empty() || pos > comment) return false;
+
+	// Skip declarations of several uniforms at once
+	size_t end = line.find(';', pos);
+	if(end == std::string::npos || end > comment || line.find(',', pos) < end) return false;
+	return true;
+}
+
+/* Calls fn(line) for each line of source, without the line terminator */
+template<typename Fn>
+static void forEachLine(const std::string& source, Fn fn) {
+	size_t lineStart = 0;
+	while(lineStart < source.size()) {
+		size_t lineEnd = source.find('\n', lineStart);
+		if(lineEnd == std::string::npos) lineEnd = source.size();
+		fn(source.substr(lineStart, lineEnd - lineStart));
+		lineStart = lineEnd + 1;
+	}
+}
+
+static std::map<std::string, Annotation> parseAnnotations(const std::string& source) {
+	std::map<std::string, Annotation> annotations;
+
+	forEachLine(source, [&](const std::string& line) {
+		std::string name;
+		size_t comment;
+		if(!parseUniformDeclaration(line, name, comment) || comment == std::string::npos) return;
+
+		Annotation annotation = {false, 0.0f, 1.0f, false};
+		parseComment(line.substr(comment + 2), annotation);
+		annotations[name] = annotation;
+	});
+
+	return annotations;
+}
+
+int ParameterTable::componentCount(GLenum type) {
+	switch(type) {
+		case GL_FLOAT: case GL_INT: case GL_BOOL: return 1;
+		case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_BOOL_VEC2: return 2;
+		case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_BOOL_VEC3: return 3;
+		case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_BOOL_VEC4: return 4;
+		default: return 0;
+	}
+}
+
+bool ParameterTable::isIntegerType(GLenum type) {
+	switch(type) {
+		case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+		case GL_BOOL: case GL_BOOL_VEC2: case GL_BOOL_VEC3: case GL_BOOL_VEC4:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void ParameterTable::reflect(const Program& program, const std::string& source) {
+	// Remember edited values so they survive reloads, including a detour through the error shader
+	for(size_t i = 0; i < _parameters.size(); ++i) {
+		if(_parameters[i].edited) _retained[_parameters[i].name] = _parameters[i];
+	}
+	_parameters.clear();
+	++_version;
+
+	std::map<std::string, Annotation> annotations = parseAnnotations(source);
+	std::vector<UniformInfo> uniforms = program.getActiveUniforms();
+
+	for(size_t i = 0; i < uniforms.size(); ++i) {
+		const UniformInfo& uniform = uniforms[i];
+		// Arrays are reported as "name[0]" and aren't exposed as parameters
+		if(uniform.size != 1 || uniform.name.find('[') != std::string::npos) continue;
+		if(isBuiltinUniform(uniform.name) || componentCount(uniform.type) == 0) continue;
+
+		ShaderParameter param;
+		param.name = uniform.name;
+		param.type = uniform.type;
+		param.location = uniform.location;
+		param.hasRange = false;
+		param.minValue = 0.0f;
+		param.maxValue = 1.0f;
+		param.isColor = false;
+		param.dirty = false;
+		param.edited = false;
+		memset(param.floatValue, 0, sizeof(param.floatValue));
+		memset(param.intValue, 0, sizeof(param.intValue));
+
+		std::map<std::string, Annotation>::const_iterator annotation = annotations.find(param.name);
+		if(annotation != annotations.end()) {
+			param.hasRange = annotation->second.hasRange;
+			param.minValue = annotation->second.minValue;
+			param.maxValue = annotation->second.maxValue;
+			param.isColor = annotation->second.isColor && !isIntegerType(param.type) && componentCount(param.type) >= 3;
+		}
+
+		// Start from the initializer in the shader source, or a value edited before the reload
+		if(isIntegerType(param.type)) {
+			CHECK_GL(glGetUniformiv(program.getID(), param.location, param.intValue));
+		} else {
+			CHECK_GL(glGetUniformfv(program.getID(), param.location, param.floatValue));
+		}
+		std::map<std::string, ShaderParameter>::const_iterator retained = _retained.find(param.name);
+		if(retained != _retained.end() && retained->second.type == param.type) {
+			memcpy(param.floatValue, retained->second.floatValue, sizeof(param.floatValue));
+			memcpy(param.intValue, retained->second.intValue, sizeof(param.intValue));
+			param.dirty = true;
+			param.edited = true;
+		}
+
+		_parameters.push_back(param);
+	}
+}
+
+void ParameterTable::apply() {
+	for(size_t i = 0; i < _parameters.size(); ++i) {
+		ShaderParameter& param = _parameters[i];
+		if(!param.dirty) continue;
+
+		switch(componentCount(param.type)) {
+			case 1:
+				if(isIntegerType(param.type)) glUniform1iv(param.location, 1, param.intValue);
+				else glUniform1fv(param.location, 1, param.floatValue);
+				break;
+			case 2:
+				if(isIntegerType(param.type)) glUniform2iv(param.location, 1, param.intValue);
+				else glUniform2fv(param.location, 1, param.floatValue);
+				break;
+			case 3:
+				if(isIntegerType(param.type)) glUniform3iv(param.location, 1, param.intValue);
+				else glUniform3fv(param.location, 1, param.floatValue);
+				break;
+			case 4:
+				if(isIntegerType(param.type)) glUniform4iv(param.location, 1, param.intValue);
+				else glUniform4fv(param.location, 1, param.floatValue);
+				break;
+		}
+		param.dirty = false;
+	}
+}
+
+void ParameterTable::copyValues(const ParameterTable& from) {
+	for(size_t i = 0; i < _parameters.size(); ++i) {
+		ShaderParameter& param = _parameters[i];
+		for(size_t j = 0; j < from._parameters.size(); ++j) {
+			const ShaderParameter& source = from._parameters[j];
+			if(source.name != param.name || source.type != param.type) continue;
+			if(memcmp(param.floatValue, source.floatValue, sizeof(param.floatValue)) != 0 ||
+					memcmp(param.intValue, source.intValue, sizeof(param.intValue)) != 0) {
+				memcpy(param.floatValue, source.floatValue, sizeof(param.floatValue));
+				memcpy(param.intValue, source.intValue, sizeof(param.intValue));
+				markChanged(param);
+			}
+			break;
+		}
+	}
+}
+
+/* Formats the current value of a parameter as a GLSL constructor, eg. "vec3(1, 0.5, 0)" */
+static std::string glslLiteral(const ShaderParameter& param) {
+	const char* constructor = "float";
+	switch(param.type) {
+		case GL_FLOAT_VEC2: constructor = "vec2"; break;
+		case GL_FLOAT_VEC3: constructor = "vec3"; break;
+		case GL_FLOAT_VEC4: constructor = "vec4"; break;
+		case GL_INT: constructor = "int"; break;
+		case GL_INT_VEC2: constructor = "ivec2"; break;
+		case GL_INT_VEC3: constructor = "ivec3"; break;
+		case GL_INT_VEC4: constructor = "ivec4"; break;
+		case GL_BOOL: constructor = "bool"; break;
+		case GL_BOOL_VEC2: constructor = "bvec2"; break;
+		case GL_BOOL_VEC3: constructor = "bvec3"; break;
+		case GL_BOOL_VEC4: constructor = "bvec4"; break;
+	}
+
+	std::string literal = constructor;
+	literal += "(";
+	char buff[32];
+	int components = ParameterTable::componentCount(param.type);
+	for(int c = 0; c < components; ++c) {
+		if(ParameterTable::isIntegerType(param.type)) {
+			snprintf(buff, sizeof(buff), "%d", param.intValue[c]);
+		} else {
+			// %.9g round-trips a float exactly
+			snprintf(buff, sizeof(buff), "%.9g", param.floatValue[c]);
+		}
+		if(c > 0) literal += ", ";
+		literal += buff;
+	}
+	literal += ")";
+	return literal;
+}
+
+std::string ParameterTable::bakeSource(const std::string& source, std::string& defines) const {
+	std::string baked;
+	baked.reserve(source.size());
+	defines.clear();
+
+	forEachLine(source, [&](const std::string& line) {
+		std::string name;
+		size_t comment;
+		const ShaderParameter* param = nullptr;
+		if(parseUniformDeclaration(line, name, comment)) {
+			for(size_t i = 0; i < _parameters.size(); ++i) {
+				if(_parameters[i].name == name) {
+					param = &_parameters[i];
+					break;
+				}
+			}
+		}
+
+		if(param) {
+			// Replace the declaration in place so line numbers in compile errors still match the file
+			std::string define = "#define " + name + " " + glslLiteral(*param);
+			defines += define + "\n";
+			baked += define;
+		} else {
+			baked += line;
+		}
+		baked += "\n";
+	});
+
+	return baked;
+}
+
+FrameState fixedStepFrameState(int frameNumber, int fps, int width, int height) {
+	FrameState frame;
+	frame.time = (double)frameNumber / fps;
+	frame.resolution[0] = (float)width;
+	frame.resolution[1] = (float)height;
+	frame.frame = frameNumber;
+	frame.timeDelta = 1.0f / fps;
+	frame.date[0] = 2000.0f;
+	frame.date[1] = 0.0f;
+	frame.date[2] = 1.0f;
+	frame.date[3] = (float)frame.time;
+	return frame;
+}
+
+BuiltinUniforms::BuiltinUniforms() {
+	time = resolution = mouse = channelResolution = -1;
+	for(int i = 0; i < CHANNEL_COUNT; ++i) {
+		channel[i] = -1;
+	}
+	resolutionComponents = 2;
+	mouseComponents = 2;
+	frameNumber = timeDelta = frameRate = date = sampleRate = channelTime = -1;
+}
+
+void BuiltinUniforms::locate(const Program& program) {
+	time = glGetUniformLocation(program.getID(), "iTime");
+	resolution = glGetUniformLocation(program.getID(), "iResolution");
+	mouse = glGetUniformLocation(program.getID(), "iMouse");
+	for(int i = 0; i < CHANNEL_COUNT; ++i) {
+		char name[16];
+		snprintf(name, sizeof(name), "iChannel%d", i);
+		channel[i] = glGetUniformLocation(program.getID(), name);
+	}
+	channelResolution = glGetUniformLocation(program.getID(), "iChannelResolution");
+	frameNumber = glGetUniformLocation(program.getID(), "iFrame");
+	timeDelta = glGetUniformLocation(program.getID(), "iTimeDelta");
+	frameRate = glGetUniformLocation(program.getID(), "iFrameRate");
+	date = glGetUniformLocation(program.getID(), "iDate");
+	sampleRate = glGetUniformLocation(program.getID(), "iSampleRate");
+	channelTime = glGetUniformLocation(program.getID(), "iChannelTime");
+
+	resolutionComponents = 2;
+	mouseComponents = 2;
+	if(resolution != -1 || mouse != -1) {
+		std::vector<UniformInfo> uniforms = program.getActiveUniforms();
+		for(size_t i = 0; i < uniforms.size(); ++i) {
+			if(uniforms[i].name == "iResolution" && uniforms[i].type == GL_FLOAT_VEC3) resolutionComponents = 3;
+			if(uniforms[i].name == "iMouse" && uniforms[i].type == GL_FLOAT_VEC4) mouseComponents = 4;
+		}
+	}
+}
+
+void BuiltinUniforms::set(const FrameState& frame) const {
+	if(time != -1) {
+		glUniform1f(time, (float)frame.time);
+	}
+	if(resolution != -1) {
+		if(resolutionComponents == 3) {
+			glUniform3f(resolution, frame.resolution[0], frame.resolution[1], 1.0f);
+		} else {
+			glUniform2fv(resolution, 1, frame.resolution);
+		}
+	}
+	if(mouse != -1) {
+		if(mouseComponents == 4) {
+			glUniform4fv(mouse, 1, frame.clickMouse);
+		} else {
+			glUniform2fv(mouse, 1, frame.mouse);
+		}
+	}
+	for(int i = 0; i < CHANNEL_COUNT; ++i) {
+		if(channel[i] != -1) {
+			glUniform1i(channel[i], i);
+		}
+	}
+	if(channelResolution != -1) {
+		glUniform3fv(channelResolution, CHANNEL_COUNT, &frame.channelResolution[0][0]);
+	}
+	if(frameNumber != -1) {
+		glUniform1i(frameNumber, frame.frame);
+	}
+	if(timeDelta != -1) {
+		glUniform1f(timeDelta, frame.timeDelta);
+	}
+	if(frameRate != -1) {
+		glUniform1f(frameRate, frame.timeDelta > 0.0f ? 1.0f / frame.timeDelta : 60.0f);
+	}
+	if(date != -1) {
+		glUniform4fv(date, 1, frame.date);
+	}
+	if(sampleRate != -1) {
+		glUniform1f(sampleRate, 44100.0f);
+	}
+	if(channelTime != -1) {
+		float times[CHANNEL_COUNT];
+		for(int i = 0; i < CHANNEL_COUNT; ++i) {
+			times[i] = (float)frame.time;
+		}
+		glUniform1fv(channelTime, CHANNEL_COUNT, times);
+	}
+}
@@ -0,0 +1,88 @@
+#include "permutations.h"
+
+static void destroyPermutation(Permutation& permutation) {
+	delete permutation.program;
+	delete permutation.fragmentShader;
+	permutation.program = nullptr;
+	permutation.fragmentShader = nullptr;
+}
+
+Permutation* PermutationCache::request(const std::string& key, const Shader* vertexShader, const std::string& source) {
+	std::map<std::string, Permutation>::iterator it = _permutations.find(key);
+	if(it != _permutations.end()) {
+		it->second.lastUsed = ++_useCounter;
+		return &it->second;
+	}
+
+	evict();
+
+	Permutation permutation;
+	permutation.fragmentShader = new Shader;
+	permutation.fragmentShader->startCompile(GL_FRAGMENT_SHADER, (GLint)source.size(), source.c_str());
+	permutation.program = new Program(vertexShader, permutation.fragmentShader);
+	permutation.program->bindAttribLocation(0, "Pos");
+	permutation.program->bindAttribLocation(1, "UV");
+	permutation.program->startLink();
+	permutation.state = Permutation::COMPILING;
+	permutation.lastUsed = ++_useCounter;
+	permutation.pins = 0;
+
+	LOG_F(INFO, "Building shader variant %d", (int)_useCounter);
+	return &(_permutations[key] = permutation);
+}
+
+static void finishBuild(Permutation& permutation) {
+	if(!permutation.fragmentShader->checkCompileStatus("<shader variant>")) {
+		permutation.error = permutation.fragmentShader->getInfoLog();
+	} else if(!permutation.program->checkLinkStatus()) {
+		permutation.error = permutation.program->getInfoLog();
+	} else {
+		labelGLObject(GL_PROGRAM, permutation.program->getID(), "<shader variant>");
+		permutation.builtins.locate(*permutation.program);
+		permutation.parameters.reflect(*permutation.program, permutation.fragmentShader->getSource());
+		permutation.state = Permutation::READY;
+		return;
+	}
+
+	// Keep the failed entry so the same variant isn't rebuilt over and over
+	destroyPermutation(permutation);
+	permutation.state = Permutation::FAILED;
+}
+
+void PermutationCache::poll() {
+	std::map<std::string, Permutation>::iterator it;
+	for(it = _permutations.begin(); it != _permutations.end(); ++it) {
+		Permutation& permutation = it->second;
+		if(permutation.state == Permutation::COMPILING && permutation.program->isLinkComplete()) {
+			finishBuild(permutation);
+		}
+	}
+}
+
+void PermutationCache::wait(Permutation* permutation) {
+	if(permutation->state == Permutation::COMPILING) {
+		finishBuild(*permutation);
+	}
+}
+
+void PermutationCache::evict() {
+	while(_permutations.size() >= _capacity) {
+		std::map<std::string, Permutation>::iterator oldest = _permutations.end();
+		std::map<std::string, Permutation>::iterator it;
+		for(it = _permutations.begin(); it != _permutations.end(); ++it) {
+			if(it->second.pins > 0) continue;
+			if(oldest == _permutations.end() || it->second.lastUsed < oldest->second.lastUsed) oldest = it;
+		}
+		if(oldest == _permutations.end()) break;
+		destroyPermutation(oldest->second);
+		_permutations.erase(oldest);
+	}
+}
+
+void PermutationCache::clear() {
+	std::map<std::string, Permutation>::iterator it;
+	for(it = _permutations.begin(); it != _permutations.end(); ++it) {
+		destroyPermutation(it->second);
+	}
+	_permutations.clear();
+}
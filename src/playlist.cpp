@@ -0,0 +1,242 @@
+#include "app.h"
+#include "playlist.h"
+
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+
+/* Offscreen frames drawn with a new program before it's shown */
+static const int WARMUP_FRAMES = 3;
+
+static const char* CROSSFADE_SHADER =
+	"#version 330\n"
+	"uniform sampler2D iChannel0;\n"
+	"uniform sampler2D iChannel1;\n"
+	"uniform float fade;\n"
+	"in vec2 Frag_UV;\n"
+	"layout(location = 0) out vec4 Out_Color;\n"
+	"void main() {\n"
+	"	Out_Color = mix(texture(iChannel0, Frag_UV), texture(iChannel1, Frag_UV), fade);\n"
+	"}\n";
+
+static std::string trim(const std::string& s) {
+	size_t start = s.find_first_not_of(" \t\r");
+	if(start == std::string::npos) return "";
+	size_t end = s.find_last_not_of(" \t\r");
+	return s.substr(start, end - start + 1);
+}
+
+bool loadPlaylist(const char* path, std::vector<PlaylistEntry>& entries) {
+	entries.clear();
+	std::ifstream in(path);
+	if(!in) {
+		LOG_F(ERROR, "Couldn't open playlist '%s'", path);
+		return false;
+	}
+
+	std::string dir = path;
+	size_t slash = dir.rfind('/');
+	dir = slash == std::string::npos ? "" : dir.substr(0, slash + 1);
+
+	std::string line;
+	int lineNumber = 0;
+	while(std::getline(in, line)) {
+		++lineNumber;
+		line = trim(line);
+		if(line.empty() || line[0] == '#') continue;
+
+		// The duration is the last word if it's a number, file names can have spaces
+		PlaylistEntry entry;
+		entry.path = line;
+		entry.duration = DEFAULT_PLAYLIST_DURATION;
+		size_t space = line.find_last_of(" \t");
+		if(space != std::string::npos) {
+			char* end;
+			double duration = strtod(line.c_str() + space + 1, &end);
+			if(*end == '\0') {
+				if(duration <= 0.0) {
+					LOG_F(ERROR, "%s:%d: invalid duration", path, lineNumber);
+					return false;
+				}
+				entry.duration = duration;
+				entry.path = trim(line.substr(0, space));
+			}
+		}
+		if(entry.path[0] != '/') entry.path = dir + entry.path;
+		entries.push_back(entry);
+	}
+
+	if(entries.empty()) {
+		LOG_F(ERROR, "Playlist '%s' is empty", path);
+		return false;
+	}
+	return true;
+}
+
+bool ShadeApp::startPlaylist(const char* path, double crossfade) {
+	if(!loadPlaylist(path, _playlist)) return false;
+	_crossfadeTime = crossfade;
+	_playlistCurrent = 0;
+	_fadeStart = -1.0;
+
+	// The first entry that builds is shown right away, waiting for it is fine before anything is on screen
+	PlaylistSlot& first = _playlistSlots[0];
+	for(size_t entry = 0; entry < _playlist.size(); ++entry) {
+		preparePlaylistSlot(first, entry);
+		// Wrapped around past the unreadable files at the end
+		if(first.permutation && first.entry < entry) first.permutation = nullptr;
+		if(!first.permutation) break;
+		_viewPrograms.wait(first.permutation);
+		if(first.permutation->state == Permutation::READY) break;
+		LOG_F(ERROR, "%s: %s", _playlist[first.entry].path.c_str(), first.permutation->error.c_str());
+		entry = first.entry;
+		first.permutation = nullptr;
+	}
+	if(!first.permutation) {
+		LOG_F(ERROR, "No shader of the playlist builds");
+		_playlist.clear();
+		return false;
+	}
+
+	if(_playlist.size() > 1) {
+		preparePlaylistSlot(_playlistSlots[1], (first.entry + 1) % _playlist.size());
+	}
+	LOG_F(INFO, "Playing %d shaders from '%s'", (int)_playlist.size(), path);
+	return true;
+}
+
+/* Starts a background build of an entry, or of the first one after it that can be read */
+void ShadeApp::preparePlaylistSlot(PlaylistSlot& slot, size_t entry) {
+	slot.permutation = nullptr;
+	slot.warmupFrames = 0;
+	slot.startTime = -1.0;
+	slot.frameCount = 0;
+	for(size_t attempt = 0; attempt < _playlist.size(); ++attempt, entry = (entry + 1) % _playlist.size()) {
+		std::ifstream in(_playlist[entry].path.c_str(), std::ios::binary);
+		if(!in) {
+			LOG_F(ERROR, "Couldn't open '%s'", _playlist[entry].path.c_str());
+			continue;
+		}
+		std::ostringstream contents;
+		contents << in.rdbuf();
+		slot.entry = entry;
+		slot.permutation = _viewPrograms.request(contents.str(), _builtinVertexShader, contents.str());
+		return;
+	}
+}
+
+/* Draws an entry into the bound framebuffer, with time in seconds since it started showing */
+void ShadeApp::drawPlaylistSlot(PlaylistSlot& slot, const FrameState& frame, double time) {
+	FrameState slotFrame = frame;
+	slotFrame.time = time;
+	slotFrame.frame = slot.frameCount++;
+	GLDebugGroup group(_playlist[slot.entry].path);
+	bindChannels();
+	slot.permutation->program->use();
+	slot.permutation->builtins.set(slotFrame);
+	drawQuad();
+}
+
+void ShadeApp::drawPlaylist(const FrameState& frame) {
+	_viewPrograms.poll();
+	PlaylistSlot& current = _playlistSlots[_playlistCurrent];
+	PlaylistSlot& next = _playlistSlots[_playlistCurrent ^ 1];
+	_viewPrograms.touch(current.permutation);
+	if(current.startTime < 0.0) current.startTime = frame.time;
+
+	bool hasNext = _playlist.size() > 1 && next.permutation;
+	if(hasNext) {
+		_viewPrograms.touch(next.permutation);
+		if(next.permutation->state == Permutation::FAILED) {
+			LOG_F(ERROR, "%s: %s", _playlist[next.entry].path.c_str(), next.permutation->error.c_str());
+			preparePlaylistSlot(next, (next.entry + 1) % _playlist.size());
+			hasNext = false;
+		}
+	}
+
+	// Once built, draw a few frames offscreen at the size it will be shown, one per frame to spread the cost
+	bool nextReady = hasNext && next.permutation->state == Permutation::READY;
+	if(nextReady && next.warmupFrames < WARMUP_FRAMES) {
+		if(next.target.getWidth() != _windowWidth || next.target.getHeight() != _windowHeight) {
+			next.target.create(_windowWidth, _windowHeight);
+			next.target.setLabel("Playlist next");
+		}
+		next.target.bind();
+		drawPlaylistSlot(next, frame, 0.0);
+		++next.warmupFrames;
+		next.frameCount = 0;
+		nextReady = false;
+	}
+
+	// A next entry still building keeps the current one on screen past its duration
+	double shown = frame.time - current.startTime;
+	if(_fadeStart < 0.0 && nextReady && shown >= _playlist[current.entry].duration - _crossfadeTime) {
+		_fadeStart = frame.time;
+		next.startTime = frame.time;
+	}
+
+	double fade = 0.0;
+	if(_fadeStart >= 0.0) fade = _crossfadeTime > 0.0 ? (frame.time - _fadeStart) / _crossfadeTime : 1.0;
+	if(fade >= 1.0) {
+		_playlistCurrent ^= 1;
+		_fadeStart = -1.0;
+		LOG_F(INFO, "Showing '%s'", _playlist[next.entry].path.c_str());
+		preparePlaylistSlot(current, (next.entry + 1) % _playlist.size());
+		CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+		CHECK_GL(glViewport(0, 0, _windowWidth, _windowHeight));
+		drawPlaylistSlot(next, frame, frame.time - next.startTime);
+		return;
+	}
+
+	if(_fadeStart < 0.0) {
+		CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+		CHECK_GL(glViewport(0, 0, _windowWidth, _windowHeight));
+		drawPlaylistSlot(current, frame, shown);
+		return;
+	}
+
+	// Both entries render offscreen, then blend into the window
+	PlaylistSlot* slots[2] = { &current, &next };
+	for(int i = 0; i < 2; ++i) {
+		PlaylistSlot& slot = *slots[i];
+		if(slot.target.getWidth() != _windowWidth || slot.target.getHeight() != _windowHeight) {
+			slot.target.create(_windowWidth, _windowHeight);
+			slot.target.setLabel(i == 0 ? "Playlist current" : "Playlist next");
+		}
+		slot.target.bind();
+		drawPlaylistSlot(slot, frame, frame.time - slot.startTime);
+	}
+
+	Permutation* crossfade = _viewPrograms.request(CROSSFADE_SHADER, _builtinVertexShader, CROSSFADE_SHADER);
+	_viewPrograms.wait(crossfade);
+	if(crossfade->state != Permutation::READY) return;
+	CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	CHECK_GL(glViewport(0, 0, _windowWidth, _windowHeight));
+	CHECK_GL(glActiveTexture(GL_TEXTURE0));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, current.target.getTexture()));
+	CHECK_GL(glActiveTexture(GL_TEXTURE1));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, next.target.getTexture()));
+	CHECK_GL(glActiveTexture(GL_TEXTURE0));
+	crossfade->program->use();
+	crossfade->builtins.set(frame);
+	// Smoothstep, so neither end of the fade starts abruptly
+	float t = (float)fade;
+	CHECK_GL(glUniform1f(glGetUniformLocation(crossfade->program->getID(), "fade"), t * t * (3.0f - 2.0f * t)));
+	{
+		GLDebugGroup group("Crossfade");
+		drawQuad();
+	}
+	CHECK_GL(glActiveTexture(GL_TEXTURE1));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+	CHECK_GL(glActiveTexture(GL_TEXTURE0));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+void ShadeApp::stopPlaylist() {
+	for(int i = 0; i < 2; ++i) {
+		_playlistSlots[i].target.destroy();
+		_playlistSlots[i].permutation = nullptr;
+	}
+	_playlist.clear();
+	_fadeStart = -1.0;
+}
@@ -0,0 +1,106 @@
+#include "readback.h"
+
+static int bytesPerPixel(GLenum format, GLenum type) {
+	int components = 4;
+	switch(format) {
+		case GL_RED: components = 1; break;
+		case GL_RG: components = 2; break;
+		case GL_RGB: case GL_BGR: components = 3; break;
+	}
+	return components * (type == GL_FLOAT ? 4 : 1);
+}
+
+bool AsyncReadback::init(int width, int height, GLenum format, GLenum type, int depth) {
+	destroy();
+
+	_width = width;
+	_height = height;
+	_format = format;
+	_type = type;
+	_bytesPerPixel = bytesPerPixel(format, type);
+
+	_slots.resize(depth);
+	for(int i = 0; i < depth; ++i) {
+		_slots[i].fence = 0;
+		_slots[i].tag = 0;
+		CHECK_GL(glGenBuffers(1, &_slots[i].pbo));
+		CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, _slots[i].pbo));
+		CHECK_GL(glBufferData(GL_PIXEL_PACK_BUFFER, frameSize(), NULL, GL_STREAM_READ));
+		labelGLObject(GL_BUFFER, _slots[i].pbo, "Readback");
+	}
+	CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	return true;
+}
+
+void AsyncReadback::destroy() {
+	unmap();
+	for(size_t i = 0; i < _slots.size(); ++i) {
+		if(_slots[i].fence) glDeleteSync(_slots[i].fence);
+		CHECK_GL(glDeleteBuffers(1, &_slots[i].pbo));
+	}
+	_slots.clear();
+	_head = 0;
+	_pending = 0;
+}
+
+bool AsyncReadback::start(const RenderTarget& target, uint64_t tag) {
+	if(_slots.empty() || _pending == (int)_slots.size()) {
+		return false;
+	}
+
+	Slot& slot = _slots[(_head + _pending) % _slots.size()];
+	CHECK_GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, target.getFramebuffer()));
+	CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo));
+	CHECK_GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	CHECK_GL(glReadPixels(0, 0, _width, _height, _format, _type, 0));
+	CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	CHECK_GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.tag = tag;
+	++_pending;
+	return true;
+}
+
+const uint8_t* AsyncReadback::map(uint64_t& tag, bool wait) {
+	if(_pending == 0 || _mapped != -1) {
+		return NULL;
+	}
+
+	Slot& slot = _slots[_head];
+	GLenum result;
+	do {
+		result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 100000000 : 0);
+	} while(wait && result == GL_TIMEOUT_EXPIRED);
+	if(result == GL_TIMEOUT_EXPIRED) {
+		return NULL;
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+
+	CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo));
+	const uint8_t* pixels = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize(), GL_MAP_READ_BIT);
+	CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	if(!pixels) {
+		LOG_F(ERROR, "Couldn't map readback buffer");
+		_head = (_head + 1) % _slots.size();
+		--_pending;
+		return NULL;
+	}
+
+	tag = slot.tag;
+	_mapped = _head;
+	return pixels;
+}
+
+void AsyncReadback::unmap() {
+	if(_mapped == -1) {
+		return;
+	}
+	CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, _slots[_mapped].pbo));
+	CHECK_GL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	CHECK_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	_mapped = -1;
+	_head = (_head + 1) % _slots.size();
+	--_pending;
+}
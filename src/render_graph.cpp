@@ -0,0 +1,573 @@
+#include "app.h"
+#include "render_graph.h"
+
+RenderPass::RenderPass():type(OUTPUT), external(false), scale(1.0f), updateInterval(1), fragmentShader(NULL), program(NULL), cubeFace(-1),
+	order(-1), varyingUniforms(true), timeVarying(true), history(false), transient(false), slot(-1), mipmaps(false),
+	width(0), height(0), cubeFramebuffer(0), current(0), lastDrawn(0), previousDrawn(0), drawCount(0), skipCount(0) {
+	targets[0] = targets[1] = NULL;
+	cubeTextures[0] = cubeTextures[1] = 0;
+}
+
+GLuint RenderPass::getOutputTexture() const {
+	switch(type) {
+	case BUFFER: return targets[current] ? targets[current]->getTexture() : 0;
+	case CUBEMAP: return cubeTextures[current];
+	default: return 0;
+	}
+}
+
+static void destroyCubeTextures(RenderPass* pass) {
+	if(!pass->cubeTextures[0]) return;
+	glDeleteTextures(pass->cubeTextures[1] != pass->cubeTextures[0] ? 2 : 1, pass->cubeTextures);
+	glDeleteFramebuffers(1, &pass->cubeFramebuffer);
+	pass->cubeTextures[0] = pass->cubeTextures[1] = 0;
+	pass->cubeFramebuffer = 0;
+}
+
+static void destroyPass(RenderPass* pass) {
+	for(int i = 0; i < CHANNEL_COUNT; ++i) {
+		if(pass->inputs[i].samplerObject) {
+			glDeleteSamplers(1, &pass->inputs[i].samplerObject);
+		}
+	}
+	destroyCubeTextures(pass);
+	delete pass->program;
+	delete pass->fragmentShader;
+	delete pass;
+}
+
+RenderGraph::~RenderGraph() {
+	destroyTargets();
+	for(size_t i = 0; i < _passes.size(); ++i) {
+		destroyPass(_passes[i]);
+	}
+	for(size_t i = 0; i < _channels.size(); ++i) {
+		delete _channels[i];
+	}
+}
+
+void RenderGraph::destroyTargets() {
+	for(size_t i = 0; i < _targets.size(); ++i) {
+		delete _targets[i];
+	}
+	_targets.clear();
+	for(size_t i = 0; i < _passes.size(); ++i) {
+		_passes[i]->targets[0] = _passes[i]->targets[1] = NULL;
+	}
+}
+
+RenderPass* RenderGraph::addPass(const std::string& name, RenderPass::Type type) {
+	RenderPass* pass = new RenderPass;
+	pass->name = name;
+	pass->type = type;
+	_passes.push_back(pass);
+	return pass;
+}
+
+ChannelInput* RenderGraph::addChannel(ChannelInput* channel) {
+	_channels.push_back(channel);
+	return channel;
+}
+
+static GLuint createSampler(const SamplerSettings& settings) {
+	GLuint sampler;
+	CHECK_GL(glGenSamplers(1, &sampler));
+	GLint minFilter = settings.filter == SamplerSettings::NEAREST ? GL_NEAREST :
+	                  (settings.filter == SamplerSettings::MIPMAP ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	GLint magFilter = settings.filter == SamplerSettings::NEAREST ? GL_NEAREST : GL_LINEAR;
+	GLint wrap = settings.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+	CHECK_GL(glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter));
+	CHECK_GL(glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter));
+	CHECK_GL(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrap));
+	CHECK_GL(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrap));
+	CHECK_GL(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, wrap));
+	return sampler;
+}
+
+/* Whether a linked pass reads uniforms that change from frame to frame */
+static bool readsVaryingUniforms(const BuiltinUniforms& builtins) {
+	return builtins.time != -1 || builtins.mouse != -1 || builtins.frameNumber != -1 || builtins.timeDelta != -1 ||
+	       builtins.frameRate != -1 || builtins.date != -1 || builtins.channelTime != -1;
+}
+
+bool RenderGraph::build(const Shader* vertexShader, std::string& error) {
+	// Submit everything before waiting on any of it
+	for(size_t i = 0; i < _passes.size(); ++i) {
+		RenderPass* pass = _passes[i];
+		if(pass->external) continue;
+		pass->fragmentShader = new Shader;
+		pass->fragmentShader->startCompile(GL_FRAGMENT_SHADER, (GLint)pass->source.size(), pass->source.c_str());
+		pass->program = new Program(vertexShader, pass->fragmentShader);
+		pass->program->bindAttribLocation(0, "Pos");
+		pass->program->bindAttribLocation(1, "UV");
+		pass->program->startLink();
+	}
+
+	bool ok = true;
+	for(size_t i = 0; i < _passes.size(); ++i) {
+		RenderPass* pass = _passes[i];
+		// External passes sample with the parameters of the channel textures
+		if(pass->external) continue;
+
+		if(!pass->fragmentShader->checkCompileStatus(pass->name.c_str())) {
+			error += pass->name + ":\n" + pass->fragmentShader->getInfoLog() + "\n";
+			ok = false;
+		} else if(!pass->program->checkLinkStatus()) {
+			error += pass->name + ":\n" + pass->program->getInfoLog() + "\n";
+			ok = false;
+		} else {
+			labelGLObject(GL_PROGRAM, pass->program->getID(), pass->name);
+			pass->builtins.locate(*pass->program);
+			pass->cubeFace = glGetUniformLocation(pass->program->getID(), "iCubeFace");
+			pass->varyingUniforms = readsVaryingUniforms(pass->builtins);
+		}
+
+		for(int c = 0; c < CHANNEL_COUNT; ++c) {
+			PassInput& input = pass->inputs[c];
+			if(input.source == PassInput::NONE) continue;
+			input.samplerObject = createSampler(input.sampler);
+			char label[16];
+			snprintf(label, sizeof(label), " iChannel%d", c);
+			labelGLObject(GL_SAMPLER, input.samplerObject, pass->name + label);
+			if(input.source == PassInput::PASS && input.sampler.filter == SamplerSettings::MIPMAP) {
+				_passes[input.pass]->mipmaps = true;
+			}
+		}
+	}
+	return ok && schedule(error);
+}
+
+bool RenderGraph::schedule(std::string& error) {
+	size_t count = _passes.size();
+
+	// Passes the output depends on, through reads of either frame
+	std::vector<bool> live(count, false);
+	std::vector<size_t> stack;
+	for(size_t i = 0; i < count; ++i) {
+		if(_passes[i]->type == RenderPass::OUTPUT) {
+			live[i] = true;
+			stack.push_back(i);
+		}
+	}
+	while(!stack.empty()) {
+		RenderPass* pass = _passes[stack.back()];
+		stack.pop_back();
+		for(int c = 0; c < CHANNEL_COUNT; ++c) {
+			const PassInput& input = pass->inputs[c];
+			if(input.source == PassInput::PASS && !live[input.pass]) {
+				live[input.pass] = true;
+				stack.push_back(input.pass);
+			}
+		}
+	}
+
+	// Kahn's algorithm, taking the earliest added pass whose same-frame inputs are drawn
+	std::vector<bool> scheduled(count, false);
+	size_t liveCount = 0;
+	for(size_t i = 0; i < count; ++i) {
+		_passes[i]->order = -1;
+		if(live[i]) ++liveCount;
+		else LOG_F(INFO, "Skipping pass '%s', nothing drawn reads it", _passes[i]->name.c_str());
+	}
+	_schedule.clear();
+	while(_schedule.size() < liveCount) {
+		int next = -1;
+		for(size_t i = 0; i < count && next < 0; ++i) {
+			if(!live[i] || scheduled[i]) continue;
+			bool ready = true;
+			for(int c = 0; c < CHANNEL_COUNT; ++c) {
+				const PassInput& input = _passes[i]->inputs[c];
+				if(input.source == PassInput::PASS && !input.previousFrame && !scheduled[input.pass]) ready = false;
+			}
+			if(ready) next = (int)i;
+		}
+		if(next < 0) {
+			error += "Passes read each other's output within a frame:";
+			for(size_t i = 0; i < count; ++i) {
+				if(live[i] && !scheduled[i]) error += " '" + _passes[i]->name + "'";
+			}
+			error += "\n";
+			return false;
+		}
+		scheduled[next] = true;
+		_passes[next]->order = (int)_schedule.size();
+		_schedule.push_back(_passes[next]);
+	}
+
+	for(size_t i = 0; i < _schedule.size(); ++i) {
+		RenderPass* pass = _schedule[i];
+		pass->history = false;
+		pass->timeVarying = pass->varyingUniforms && pass->updateInterval == 1;
+		// Only buffers and cubemaps have a size of their own
+		if(pass->type == RenderPass::OUTPUT) pass->scale = 1.0f;
+		if(pass->updateInterval < 0) pass->updateInterval = 1;
+	}
+
+	// Passes reading varying passes vary too; feedback reads can point backwards, so iterate to a fixed point
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(size_t i = 0; i < _schedule.size(); ++i) {
+			RenderPass* pass = _schedule[i];
+			for(int c = 0; c < CHANNEL_COUNT && !pass->timeVarying && pass->updateInterval == 1; ++c) {
+				const PassInput& input = pass->inputs[c];
+				if(input.source == PassInput::PASS && _passes[input.pass]->timeVarying) {
+					pass->timeVarying = true;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	for(size_t i = 0; i < _schedule.size(); ++i) {
+		for(int c = 0; c < CHANNEL_COUNT; ++c) {
+			const PassInput& input = _schedule[i]->inputs[c];
+			if(input.source == PassInput::PASS && input.previousFrame) _passes[input.pass]->history = true;
+		}
+	}
+
+	// Share textures between transient passes of the same size whose lifetimes (draw to last read) don't overlap
+	std::vector<int> slotEnd;
+	_slotScales.clear();
+	for(size_t i = 0; i < _schedule.size(); ++i) {
+		RenderPass* pass = _schedule[i];
+		pass->transient = pass->type == RenderPass::BUFFER && pass->timeVarying && !pass->history;
+		if(!pass->transient) continue;
+
+		int end = (int)i;
+		for(size_t r = i + 1; r < _schedule.size(); ++r) {
+			for(int c = 0; c < CHANNEL_COUNT; ++c) {
+				const PassInput& input = _schedule[r]->inputs[c];
+				if(input.source == PassInput::PASS && _passes[input.pass] == pass) end = (int)r;
+			}
+		}
+
+		pass->slot = -1;
+		for(size_t s = 0; s < slotEnd.size() && pass->slot < 0; ++s) {
+			if(slotEnd[s] < (int)i && _slotScales[s] == pass->scale) pass->slot = (int)s;
+		}
+		if(pass->slot < 0) {
+			pass->slot = (int)slotEnd.size();
+			slotEnd.push_back(end);
+			_slotScales.push_back(pass->scale);
+		}
+		slotEnd[pass->slot] = end;
+	}
+
+	// Channels are checked for changes once per frame, however many passes read them
+	_channelChanges.clear();
+	for(size_t i = 0; i < _schedule.size(); ++i) {
+		for(int c = 0; c < CHANNEL_COUNT; ++c) {
+			const PassInput& input = _schedule[i]->inputs[c];
+			if(input.source != PassInput::CHANNEL) continue;
+			bool known = false;
+			for(size_t k = 0; k < _channelChanges.size(); ++k) {
+				if(_channelChanges[k].first == input.channel) known = true;
+			}
+			if(!known) _channelChanges.push_back(std::make_pair(input.channel, (uint64_t)0));
+		}
+	}
+	return true;
+}
+
+size_t RenderGraph::countCubeTextures() const {
+	size_t count = 0;
+	for(size_t i = 0; i < _passes.size(); ++i) {
+		const RenderPass* pass = _passes[i];
+		if(pass->cubeTextures[0]) count += pass->cubeTextures[1] != pass->cubeTextures[0] ? 2 : 1;
+	}
+	return count;
+}
+
+static RenderTarget* createBufferTarget(int width, int height) {
+	RenderTarget* target = new RenderTarget;
+	if(!target->create(width, height, GL_RGBA32F)) {
+		delete target;
+		return NULL;
+	}
+	return target;
+}
+
+/* A size scaled down, never below one pixel */
+static int scaleSize(int size, float scale) {
+	int scaled = (int)(size * scale + 0.5f);
+	return scaled < 1 ? 1 : scaled;
+}
+
+bool RenderGraph::resize(int width, int height) {
+	destroyTargets();
+	_width = width;
+	_height = height;
+
+	std::vector<RenderTarget*> slots;
+	for(size_t s = 0; s < _slotScales.size(); ++s) {
+		RenderTarget* target = createBufferTarget(scaleSize(width, _slotScales[s]), scaleSize(height, _slotScales[s]));
+		if(!target) return false;
+		char label[32];
+		snprintf(label, sizeof(label), "Transient slot %d", (int)s);
+		target->setLabel(label);
+		_targets.push_back(target);
+		slots.push_back(target);
+	}
+
+	_textureBytes = 0;
+	for(size_t i = 0; i < _schedule.size(); ++i) {
+		RenderPass* pass = _schedule[i];
+		pass->current = 0;
+		pass->lastDrawn = pass->previousDrawn = 0;
+		// Cubemaps keep the size of their textures, compared below
+		if(pass->type != RenderPass::CUBEMAP) {
+			pass->width = width;
+			pass->height = height;
+		}
+
+		if(pass->type == RenderPass::BUFFER) {
+			pass->width = scaleSize(width, pass->scale);
+			pass->height = scaleSize(height, pass->scale);
+			if(pass->transient) {
+				pass->targets[0] = pass->targets[1] = slots[pass->slot];
+				continue;
+			}
+			for(int t = 0; t < (pass->history ? 2 : 1); ++t) {
+				pass->targets[t] = createBufferTarget(pass->width, pass->height);
+				if(!pass->targets[t]) return false;
+				pass->targets[t]->setLabel(pass->history ? pass->name + (t == 0 ? " (0)" : " (1)") : pass->name);
+				_targets.push_back(pass->targets[t]);
+			}
+			if(!pass->history) pass->targets[1] = pass->targets[0];
+		} else if(pass->type == RenderPass::CUBEMAP) {
+			// Cubemaps don't follow the output size, keep them unless their settings changed
+			int size = scaleSize(CUBEMAP_PASS_SIZE, pass->scale);
+			int count = pass->history ? 2 : 1;
+			bool doubled = pass->cubeTextures[1] != pass->cubeTextures[0];
+			if(pass->cubeTextures[0] && (size != pass->width || doubled != pass->history)) {
+				destroyCubeTextures(pass);
+			}
+			pass->width = pass->height = size;
+			if(pass->cubeTextures[0]) continue;
+
+			CHECK_GL(glGenTextures(count, pass->cubeTextures));
+			if(count == 1) pass->cubeTextures[1] = pass->cubeTextures[0];
+			CHECK_GL(glGenFramebuffers(1, &pass->cubeFramebuffer));
+			for(int t = 0; t < count; ++t) {
+				CHECK_GL(glBindTexture(GL_TEXTURE_CUBE_MAP, pass->cubeTextures[t]));
+				for(int face = 0; face < 6; ++face) {
+					CHECK_GL(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA32F, size, size, 0, GL_RGBA, GL_FLOAT, NULL));
+				}
+				labelGLObject(GL_TEXTURE, pass->cubeTextures[t], pass->history ? pass->name + (t == 0 ? " (0)" : " (1)") : pass->name);
+			}
+			CHECK_GL(glBindTexture(GL_TEXTURE_CUBE_MAP, 0));
+		}
+	}
+
+	_frame = 0;
+	for(size_t k = 0; k < _channelChanges.size(); ++k) {
+		_channelChanges[k].second = 0;
+	}
+
+	// Everything starts cleared, like on a fresh load
+	static const GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for(size_t i = 0; i < _targets.size(); ++i) {
+		_targets[i]->bind();
+		CHECK_GL(glClearBufferfv(GL_COLOR, 0, zero));
+		// RGBA32F, not counting mipmaps
+		_textureBytes += (size_t)_targets[i]->getWidth() * _targets[i]->getHeight() * 16;
+	}
+	for(size_t i = 0; i < _schedule.size(); ++i) {
+		RenderPass* pass = _schedule[i];
+		if(!pass->cubeTextures[0]) continue;
+		CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, pass->cubeFramebuffer));
+		labelGLObject(GL_FRAMEBUFFER, pass->cubeFramebuffer, pass->name);
+		int count = pass->cubeTextures[1] != pass->cubeTextures[0] ? 2 : 1;
+		for(int t = 0; t < count; ++t) {
+			for(int face = 0; face < 6; ++face) {
+				CHECK_GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, pass->cubeTextures[t], 0));
+				CHECK_GL(glClearBufferfv(GL_COLOR, 0, zero));
+			}
+		}
+		_textureBytes += count * 6 * (size_t)pass->width * pass->height * 16;
+	}
+	RenderTarget::unbind();
+	return true;
+}
+
+bool RenderGraph::carriesState() const {
+	for(size_t i = 0; i < _schedule.size(); ++i) {
+		if(_schedule[i]->history || _schedule[i]->updateInterval != 1) return true;
+	}
+	return false;
+}
+
+void RenderGraph::beginFrame() {
+	++_frame;
+	for(size_t k = 0; k < _channelChanges.size(); ++k) {
+		if(_channelChanges[k].first->changed()) _channelChanges[k].second = _frame;
+	}
+}
+
+uint64_t RenderGraph::lastChanged(const ChannelInput* channel) const {
+	for(size_t k = 0; k < _channelChanges.size(); ++k) {
+		if(_channelChanges[k].first == channel) return _channelChanges[k].second;
+	}
+	return _frame;
+}
+
+bool RenderGraph::needsDraw(const RenderPass& pass) const {
+	if(pass.type == RenderPass::OUTPUT || pass.lastDrawn == 0) {
+		return true;
+	}
+	// Passes on the same interval take turns
+	if(pass.updateInterval > 1 && (_frame + pass.order) % pass.updateInterval != 0) {
+		return false;
+	}
+	if(pass.updateInterval != 0 && pass.varyingUniforms) {
+		return true;
+	}
+
+	// Anything drawn since this pass last read it, which may be several frames ago
+	for(int c = 0; c < CHANNEL_COUNT; ++c) {
+		const PassInput& input = pass.inputs[c];
+		if(input.source == PassInput::CHANNEL && lastChanged(input.channel) > pass.lastDrawn) {
+			return true;
+		}
+		if(input.source == PassInput::PASS) {
+			const RenderPass& producer = *_passes[input.pass];
+			if(!input.previousFrame) {
+				if(producer.lastDrawn > pass.lastDrawn) return true;
+			} else {
+				// The previous frame's output is the last draw before this frame
+				uint64_t drawn = producer.lastDrawn == _frame ? producer.previousDrawn : producer.lastDrawn;
+				if(drawn >= pass.lastDrawn) return true;
+			}
+		}
+	}
+	return false;
+}
+
+void RenderGraph::markDrawn(RenderPass& pass) {
+	// Passes without history have the same texture on both sides
+	pass.current ^= 1;
+	pass.previousDrawn = pass.lastDrawn;
+	pass.lastDrawn = _frame;
+	++pass.drawCount;
+}
+
+void RenderGraph::markSkipped(RenderPass& pass) {
+	++pass.skipCount;
+}
+
+GLuint RenderGraph::getInputTexture(const PassInput& input) const {
+	const RenderPass& producer = *_passes[input.pass];
+	// Drawn already this frame: the previous output is in the other texture
+	if(input.previousFrame && producer.lastDrawn == _frame) {
+		return producer.type == RenderPass::CUBEMAP ? producer.cubeTextures[producer.current ^ 1] : producer.targets[producer.current ^ 1]->getTexture();
+	}
+	return producer.getOutputTexture();
+}
+
+void RenderGraph::getInputSize(const PassInput& input, int& width, int& height) const {
+	width = height = 0;
+	if(input.source == PassInput::CHANNEL) {
+		width = input.channel->getWidth();
+		height = input.channel->getHeight();
+	} else if(input.source == PassInput::PASS) {
+		width = _passes[input.pass]->width;
+		height = _passes[input.pass]->height;
+	}
+}
+
+/* Binds the inputs of a pass to its texture units and reports their sizes to the frame */
+static void bindPassInputs(RenderGraph& graph, const RenderPass& pass, FrameState& frame) {
+	std::vector<RenderPass*>& passes = graph.getPasses();
+	for(int c = 0; c < CHANNEL_COUNT; ++c) {
+		const PassInput& input = pass.inputs[c];
+		GLenum target = GL_TEXTURE_2D;
+		GLuint texture = 0;
+		int width, height;
+		graph.getInputSize(input, width, height);
+
+		if(input.source == PassInput::CHANNEL) {
+			target = input.channel->getTarget();
+			texture = input.channel->getTexture();
+		} else if(input.source == PassInput::PASS) {
+			target = passes[input.pass]->getOutputTarget();
+			texture = graph.getInputTexture(input);
+		}
+
+		frame.channelResolution[c][0] = (float)width;
+		frame.channelResolution[c][1] = (float)height;
+		frame.channelResolution[c][2] = texture ? 1.0f : 0.0f;
+
+		CHECK_GL(glActiveTexture(GL_TEXTURE0 + c));
+		CHECK_GL(glBindTexture(target, texture));
+		CHECK_GL(glBindSampler(c, input.samplerObject));
+	}
+	CHECK_GL(glActiveTexture(GL_TEXTURE0));
+}
+
+/* Unbinds the sampler objects so other draws (eg. ImGui) use texture parameters again */
+static void unbindSamplers() {
+	for(int c = 0; c < CHANNEL_COUNT; ++c) {
+		CHECK_GL(glBindSampler(c, 0));
+	}
+}
+
+/**
+ * Draws the passes of the graph that need it for a frame, the output pass
+ * into framebuffer (width x height).  Buffers follow the output size.
+ */
+void ShadeApp::renderGraph(const FrameState& frame, GLuint framebuffer, int width, int height) {
+	if(_graph->getWidth() != width || _graph->getHeight() != height) {
+		_graph->resize(width, height);
+	}
+
+	_graph->beginFrame();
+	const std::vector<RenderPass*>& schedule = _graph->getSchedule();
+	for(size_t i = 0; i < schedule.size(); ++i) {
+		RenderPass& pass = *schedule[i];
+		if(!_graph->needsDraw(pass)) {
+			_graph->markSkipped(pass);
+			continue;
+		}
+
+		GLDebugGroup group(pass.name);
+		FrameState passFrame = frame;
+		passFrame.resolution[0] = (float)pass.width;
+		passFrame.resolution[1] = (float)pass.height;
+		bindPassInputs(*_graph, pass, passFrame);
+		if(pass.external) {
+			useProgram(passFrame);
+		} else {
+			pass.program->use();
+			pass.builtins.set(passFrame);
+		}
+
+		int next = pass.current ^ 1;
+		if(pass.type == RenderPass::CUBEMAP) {
+			CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, pass.cubeFramebuffer));
+			CHECK_GL(glViewport(0, 0, pass.width, pass.height));
+			for(int face = 0; face < 6; ++face) {
+				CHECK_GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, pass.cubeTextures[next], 0));
+				glUniform1i(pass.cubeFace, face);
+				drawQuad();
+			}
+		} else {
+			if(pass.type == RenderPass::BUFFER) {
+				pass.targets[next]->bind();
+			} else {
+				CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+				CHECK_GL(glViewport(0, 0, width, height));
+			}
+			drawQuad();
+		}
+		_graph->markDrawn(pass);
+
+		if(pass.mipmaps) {
+			CHECK_GL(glBindTexture(pass.getOutputTarget(), pass.getOutputTexture()));
+			CHECK_GL(glGenerateMipmap(pass.getOutputTarget()));
+			CHECK_GL(glBindTexture(pass.getOutputTarget(), 0));
+		}
+	}
+	unbindSamplers();
+	CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+}
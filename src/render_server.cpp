@@ -0,0 +1,333 @@
+#include "app.h"
+#include "render_server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool RenderJobQueue::pop(RenderJob& job, double now) {
+	if(_jobs.empty()) {
+		return false;
+	}
+
+	std::deque<RenderJob>::iterator next = _jobs.begin();
+	if(now - next->queuedTime < _maxWait) {
+		// Nobody has waited too long: shortest job first
+		double nextCost = 0.0;
+		std::deque<RenderJob>::iterator it;
+		for(it = _jobs.begin(); it != _jobs.end(); ++it) {
+			double cost = (double)it->width * it->height * it->settings.frames.size();
+			if(it == _jobs.begin() || cost < nextCost) {
+				next = it;
+				nextCost = cost;
+			}
+		}
+	}
+
+	job = *next;
+	_jobs.erase(next);
+	return true;
+}
+
+#if defined(_WIN32)
+
+bool readRenderJob(int, RenderJob&, std::string& error) {
+	error = "Not supported on this platform";
+	return false;
+}
+
+int ShadeApp::runServer(const char* socketPath) {
+	fprintf(stderr, "--serve isn't supported on this platform\n");
+	return EXIT_FAILURE;
+}
+
+#else
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t g_stopServer = 0;
+
+static void stopServer(int) {
+	g_stopServer = 1;
+}
+
+/* Reads a line terminated by \n, without the terminator */
+static bool readLine(int fd, std::string& line) {
+	line.clear();
+	char c;
+	while(true) {
+		ssize_t n = read(fd, &c, 1);
+		if(n <= 0) return false;
+		if(c == '\n') return true;
+		line += c;
+		// Header lines are short, anything else is garbage
+		if(line.size() > 4096) return false;
+	}
+}
+
+static bool readAll(int fd, std::string& data, size_t size) {
+	data.resize(size);
+	size_t done = 0;
+	while(done < size) {
+		ssize_t n = read(fd, &data[done], size - done);
+		if(n <= 0) return false;
+		done += n;
+	}
+	return true;
+}
+
+static bool writeAll(int fd, const void* data, size_t size) {
+	const char* p = (const char*)data;
+	while(size > 0) {
+		ssize_t n = write(fd, p, size);
+		if(n <= 0) return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool writeString(int fd, const std::string& s) {
+	return writeAll(fd, s.data(), s.size());
+}
+
+static void sendError(int client, const std::string& message) {
+	char header[64];
+	snprintf(header, sizeof(header), "ERROR %d\n", (int)message.size());
+	writeString(client, header);
+	writeString(client, message);
+}
+
+bool readRenderJob(int client, RenderJob& job, std::string& error) {
+	job.client = client;
+	job.width = 256;
+	job.height = 256;
+	job.settings.fps = 60;
+	job.settings.frames.assign(1, 0);
+	job.png = true;
+
+	std::string line;
+	if(!readLine(client, line) || line != "SHADE 1") {
+		error = "Expected 'SHADE 1'";
+		return false;
+	}
+
+	while(readLine(client, line)) {
+		char key[32];
+		int consumed = 0;
+		if(sscanf(line.c_str(), "%31s %n", key, &consumed) < 1) continue;
+		const char* value = line.c_str() + consumed;
+
+		if(strcmp(key, "width") == 0) {
+			job.width = atoi(value);
+		} else if(strcmp(key, "height") == 0) {
+			job.height = atoi(value);
+		} else if(strcmp(key, "fps") == 0) {
+			job.settings.fps = atoi(value);
+		} else if(strcmp(key, "frames") == 0) {
+			if(!parseFrameList(value, job.settings.frames)) {
+				error = "Invalid frame list";
+				return false;
+			}
+		} else if(strcmp(key, "format") == 0) {
+			job.png = strcmp(value, "rgba") != 0;
+		} else if(strcmp(key, "uniform") == 0) {
+			char name[128];
+			float v[4];
+			int count = sscanf(value, "%127s %f %f %f %f", name, &v[0], &v[1], &v[2], &v[3]);
+			if(count < 2) {
+				error = "Invalid uniform '" + line + "'";
+				return false;
+			}
+			job.uniforms.push_back(std::make_pair(std::string(name), std::vector<float>(v, v + count - 1)));
+		} else if(strcmp(key, "source") == 0) {
+			long size = atol(value);
+			if(size <= 0 || size > 16 * 1024 * 1024 || !readAll(client, job.source, size)) {
+				error = "Couldn't read source";
+				return false;
+			}
+			if(job.width <= 0 || job.height <= 0 || job.width > 16384 || job.height > 16384 || job.settings.fps <= 0) {
+				error = "Invalid resolution or fps";
+				return false;
+			}
+			return true;
+		} else {
+			error = "Unknown key '" + std::string(key) + "'";
+			return false;
+		}
+	}
+
+	error = "Request ended before 'source'";
+	return false;
+}
+
+struct ServerState {
+	std::mutex mutex;
+	std::condition_variable wake;
+	RenderJobQueue queue;
+};
+
+/* Reads a request on its own thread so slow clients don't hold up others */
+static void receiveJob(ServerState* state, int client) {
+	RenderJob job;
+	std::string error;
+	if(!readRenderJob(client, job, error)) {
+		sendError(client, error);
+		close(client);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(state->mutex);
+	job.queuedTime = glfwGetTime();
+	state->queue.push(job);
+	state->wake.notify_one();
+}
+
+static void acceptClients(ServerState* state, int listener) {
+	while(!g_stopServer) {
+		int client = accept(listener, NULL, NULL);
+		if(client < 0) {
+			if(g_stopServer) break;
+			continue;
+		}
+		std::thread(receiveJob, state, client).detach();
+	}
+}
+
+/* Applies job uniforms over the values the program was linked with */
+static void applyJobUniforms(Permutation* permutation, const RenderJob& job) {
+	// The program is shared between jobs, so restore every parameter, not just the overridden ones
+	ParameterTable parameters = permutation->parameters;
+	std::vector<ShaderParameter>& params = parameters.getParameters();
+	for(size_t u = 0; u < job.uniforms.size(); ++u) {
+		for(size_t i = 0; i < params.size(); ++i) {
+			if(params[i].name != job.uniforms[u].first) continue;
+			const std::vector<float>& values = job.uniforms[u].second;
+			for(size_t c = 0; c < values.size() && c < 4; ++c) {
+				params[i].floatValue[c] = values[c];
+				params[i].intValue[c] = (GLint)values[c];
+			}
+		}
+	}
+	parameters.markAllChanged();
+	parameters.apply();
+}
+
+void ShadeApp::renderJob(PermutationCache& programs, RenderTarget& target, const RenderJob& job) {
+	Permutation* permutation = programs.request(job.source, _builtinVertexShader, job.source);
+	programs.wait(permutation);
+	if(permutation->state != Permutation::READY) {
+		sendError(job.client, permutation->error);
+		return;
+	}
+
+	if(target.getWidth() != job.width || target.getHeight() != job.height) {
+		if(!target.create(job.width, job.height)) {
+			sendError(job.client, "Couldn't allocate render target");
+			return;
+		}
+	}
+
+	char header[128];
+	snprintf(header, sizeof(header), "OK %d\n", (int)job.settings.frames.size());
+	if(!writeString(job.client, header)) return;
+
+	std::vector<uint8_t> pixels, png;
+	for(size_t i = 0; i < job.settings.frames.size(); ++i) {
+		int frameNumber = job.settings.frames[i];
+		FrameState frame = fixedStepFrameState(frameNumber, job.settings.fps, job.width, job.height);
+
+		target.bind();
+		glClear(GL_COLOR_BUFFER_BIT);
+		permutation->program->use();
+		if(i == 0) applyJobUniforms(permutation, job);
+		permutation->builtins.set(frame);
+		drawQuad();
+		target.readPixels(pixels);
+
+		const std::vector<uint8_t>* data = &pixels;
+		if(job.png) {
+			encodePNG(job.width, job.height, pixels, png);
+			data = &png;
+		}
+		snprintf(header, sizeof(header), "FRAME %d %d %d %d\n", frameNumber, job.width, job.height, (int)data->size());
+		if(!writeString(job.client, header) || !writeAll(job.client, &(*data)[0], data->size())) {
+			// Client went away, don't bother with the rest
+			break;
+		}
+	}
+	RenderTarget::unbind();
+	writeString(job.client, "DONE\n");
+}
+
+int ShadeApp::runServer(const char* socketPath) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if(strlen(socketPath) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "Socket path '%s' is too long\n", socketPath);
+		return EXIT_FAILURE;
+	}
+	strcpy(address.sun_path, socketPath);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socketPath);
+	if(listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+		fprintf(stderr, "Couldn't listen on '%s'\n", socketPath);
+		if(listener >= 0) close(listener);
+		return EXIT_FAILURE;
+	}
+
+	// Clients disconnecting mid-response shouldn't kill the server
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGINT, stopServer);
+	signal(SIGTERM, stopServer);
+
+	// Static since detached reader threads may still touch it while shutting down
+	static ServerState state;
+	std::thread acceptor(acceptClients, &state, listener);
+	LOG_F(INFO, "Serving render jobs on '%s'", socketPath);
+
+	PermutationCache programs(64);
+	RenderTarget target;
+	while(!g_stopServer) {
+		RenderJob job;
+		{
+			std::unique_lock<std::mutex> lock(state.mutex);
+			if(state.queue.empty()) {
+				state.wake.wait_for(lock, std::chrono::milliseconds(100));
+			}
+			if(!state.queue.pop(job, glfwGetTime())) continue;
+		}
+
+		double start = glfwGetTime();
+		renderJob(programs, target, job);
+		close(job.client);
+		LOG_F(INFO, "Job %dx%d x%d frames: %.1f ms queued, %.1f ms rendering", job.width, job.height,
+			(int)job.settings.frames.size(), (start - job.queuedTime) * 1000.0, (glfwGetTime() - start) * 1000.0);
+	}
+
+	// Unblock accept() so the acceptor thread can exit
+	shutdown(listener, SHUT_RDWR);
+	close(listener);
+	acceptor.join();
+	unlink(socketPath);
+
+	std::lock_guard<std::mutex> lock(state.mutex);
+	RenderJob job;
+	while(state.queue.pop(job, 0.0)) {
+		sendError(job.client, "Server shutting down");
+		close(job.client);
+	}
+	return EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "render_target.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <stb/stb_image_write.h>
+
+/* Picks the pixel transfer format/type matching an internal format */
+static void transferFormat(GLenum internalFormat, GLenum& format, GLenum& type) {
+	switch(internalFormat) {
+		case GL_RGBA32F: case GL_RGBA16F: format = GL_RGBA; type = GL_FLOAT; break;
+		case GL_RG32F: case GL_RG16F: format = GL_RG; type = GL_FLOAT; break;
+		case GL_R32F: case GL_R16F: format = GL_RED; type = GL_FLOAT; break;
+		default: format = GL_RGBA; type = GL_UNSIGNED_BYTE; break;
+	}
+}
+
+bool RenderTarget::create(int width, int height, GLenum internalFormat) {
+	destroy();
+
+	_width = width;
+	_height = height;
+	_internalFormat = internalFormat;
+
+	GLenum format, type;
+	transferFormat(internalFormat, format, type);
+
+	CHECK_GL(glGenTextures(1, &_texture));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, _texture));
+	CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
+
+	CHECK_GL(glGenFramebuffers(1, &_fbo));
+	CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, _fbo));
+	CHECK_GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _texture, 0));
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+
+	if(status != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_F(ERROR, "Incomplete framebuffer (0x%04x) for %dx%d render target", status, width, height);
+		destroy();
+		return false;
+	}
+	return true;
+}
+
+void RenderTarget::destroy() {
+	if(_fbo != 0) {
+		CHECK_GL(glDeleteFramebuffers(1, &_fbo));
+		_fbo = 0;
+	}
+	if(_texture != 0) {
+		CHECK_GL(glDeleteTextures(1, &_texture));
+		_texture = 0;
+	}
+	_width = _height = 0;
+}
+
+void RenderTarget::setLabel(const std::string& label) const {
+	labelGLObject(GL_TEXTURE, _texture, label);
+	labelGLObject(GL_FRAMEBUFFER, _fbo, label);
+}
+
+void RenderTarget::bind() const {
+	CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, _fbo));
+	CHECK_GL(glViewport(0, 0, _width, _height));
+}
+
+void RenderTarget::unbind() {
+	CHECK_GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void RenderTarget::readPixels(std::vector<uint8_t>& pixels) const {
+	pixels.resize((size_t)_width * _height * 4);
+	CHECK_GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, _fbo));
+	CHECK_GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	CHECK_GL(glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]));
+	CHECK_GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+}
+
+/* Flips GL's bottom-up rows into image order */
+static void flipRows(int width, int height, const std::vector<uint8_t>& pixels, std::vector<uint8_t>& flipped) {
+	size_t stride = (size_t)width * 4;
+	flipped.resize(pixels.size());
+	for(int y = 0; y < height; ++y) {
+		memcpy(&flipped[y * stride], &pixels[(height - 1 - y) * stride], stride);
+	}
+}
+
+bool writePNG(const char* path, int width, int height, const std::vector<uint8_t>& pixels) {
+	std::vector<uint8_t> flipped;
+	flipRows(width, height, pixels, flipped);
+
+	// Write next to the destination and rename, so an interrupted render never leaves a partial frame behind
+	std::string partial = std::string(path) + ".part";
+	if(!stbi_write_png(partial.c_str(), width, height, 4, &flipped[0], width * 4)) {
+		LOG_F(ERROR, "Couldn't write image '%s'", path);
+		return false;
+	}
+	remove(path);
+	if(rename(partial.c_str(), path) != 0) {
+		LOG_F(ERROR, "Couldn't move image into place at '%s'", path);
+		remove(partial.c_str());
+		return false;
+	}
+	return true;
+}
+
+static void appendToVector(void* context, void* data, int size) {
+	std::vector<uint8_t>* out = (std::vector<uint8_t>*)context;
+	out->insert(out->end(), (uint8_t*)data, (uint8_t*)data + size);
+}
+
+bool encodePNG(int width, int height, const std::vector<uint8_t>& pixels, std::vector<uint8_t>& png) {
+	std::vector<uint8_t> flipped;
+	flipRows(width, height, pixels, flipped);
+
+	png.clear();
+	return stbi_write_png_to_func(appendToVector, &png, width, height, 4, &flipped[0], width * 4) != 0;
+}
@@ -0,0 +1,161 @@
+#include "sequence_channel.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <stb/stb_image.h>
+#include <loguru/loguru.hpp>
+
+ImageSequenceChannel::ImageSequenceChannel():_fps(60.0), _shown(-1), _offline(false), _missing(false), _useCounter(0), _stop(false) {
+}
+
+ImageSequenceChannel::~ImageSequenceChannel() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_work.notify_all();
+	for(size_t i = 0; i < _workers.size(); ++i) {
+		_workers[i].join();
+	}
+}
+
+bool ImageSequenceChannel::init(const char* pattern, double fps) {
+	if(!strchr(pattern, '%') || fps <= 0.0) {
+		LOG_F(ERROR, "Image sequence '%s' needs a frame number format like %%05d", pattern);
+		return false;
+	}
+	_pattern = pattern;
+	_fps = fps;
+
+	// Leave a core for the render thread
+	unsigned threads = std::thread::hardware_concurrency();
+	threads = threads > 2 ? threads - 1 : 1;
+	if(threads > 8) threads = 8;
+	for(unsigned i = 0; i < threads; ++i) {
+		_workers.push_back(std::thread(&ImageSequenceChannel::workerLoop, this));
+	}
+	LOG_F(INFO, "Reading image sequence '%s' at %.2f fps with %d threads", pattern, fps, (int)threads);
+	return true;
+}
+
+void ImageSequenceChannel::workerLoop() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(true) {
+		while(!_stop && _tasks.empty()) {
+			_work.wait(lock);
+		}
+		if(_stop) return;
+
+		int64_t index = _tasks.front();
+		_tasks.pop_front();
+		lock.unlock();
+
+		char path[1024];
+		snprintf(path, sizeof(path), _pattern.c_str(), (int)index);
+		int width = 0, height = 0, components;
+		uint8_t* pixels = stbi_load(path, &width, &height, &components, 4);
+		std::vector<uint8_t> rgba;
+		if(pixels) {
+			// Bottom row first for GL
+			size_t stride = (size_t)width * 4;
+			rgba.resize(stride * height);
+			for(int y = 0; y < height; ++y) {
+				memcpy(&rgba[(size_t)(height - 1 - y) * stride], pixels + (size_t)y * stride, stride);
+			}
+			stbi_image_free(pixels);
+		}
+
+		lock.lock();
+		// Entries being loaded are never evicted
+		CachedFrame& frame = _cache[index];
+		frame.state = pixels ? CachedFrame::READY : CachedFrame::MISSING;
+		frame.width = width;
+		frame.height = height;
+		frame.rgba.swap(rgba);
+		_done.notify_all();
+	}
+}
+
+void ImageSequenceChannel::schedule(int64_t first) {
+	int64_t last = first + READ_AHEAD;
+
+	// Decodes queued for a window we've moved away from are wasted work
+	for(std::deque<int64_t>::iterator it = _tasks.begin(); it != _tasks.end(); ) {
+		if(*it < first || *it >= last) {
+			_cache.erase(*it);
+			it = _tasks.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for(int64_t i = first; i < last; ++i) {
+		std::map<int64_t, CachedFrame>::iterator it = _cache.find(i);
+		if(it != _cache.end()) continue;
+		CachedFrame& frame = _cache[i];
+		frame.state = CachedFrame::LOADING;
+		frame.lastUsed = 0;
+		// The frame needed now goes first
+		if(i == first) _tasks.push_front(i);
+		else _tasks.push_back(i);
+	}
+	_work.notify_all();
+}
+
+void ImageSequenceChannel::evict(int64_t first) {
+	while(_cache.size() > CACHE_FRAMES) {
+		std::map<int64_t, CachedFrame>::iterator victim = _cache.end();
+		for(std::map<int64_t, CachedFrame>::iterator it = _cache.begin(); it != _cache.end(); ++it) {
+			bool inWindow = it->first >= first && it->first < first + READ_AHEAD;
+			if(it->second.state == CachedFrame::LOADING || inWindow) continue;
+			if(victim == _cache.end() || it->second.lastUsed < victim->second.lastUsed) {
+				victim = it;
+			}
+		}
+		if(victim == _cache.end()) break;
+		_cache.erase(victim);
+	}
+}
+
+void ImageSequenceChannel::update(const FrameState& frame) {
+	int64_t wanted = channelFrameIndex(frame.time, _fps);
+	if(wanted == _shown) return;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	schedule(wanted);
+	evict(wanted);
+
+	CachedFrame* next = &_cache[wanted];
+	while(_offline && next->state == CachedFrame::LOADING) {
+		_done.wait(lock);
+		next = &_cache[wanted];
+	}
+	next->lastUsed = ++_useCounter;
+	if(next->state != CachedFrame::READY) {
+		// Still decoding: hold the current frame
+		if(next->state == CachedFrame::MISSING) {
+			// Once per run of missing images, eg. past the end of the sequence
+			if(!_missing) {
+				LOG_F(WARNING, "Missing image %d of sequence '%s'", (int)wanted, _pattern.c_str());
+			}
+			_missing = true;
+			_shown = wanted;
+		}
+		return;
+	}
+	lock.unlock();
+
+	// Ready entries only change or go away on this thread, so no lock is needed to upload
+	if(next->width != _texture.getWidth() || next->height != _texture.getHeight()) {
+		if(_texture.getTexture()) {
+			LOG_F(WARNING, "Image %d of sequence '%s' is %dx%d, was %dx%d", (int)wanted, _pattern.c_str(),
+				next->width, next->height, _texture.getWidth(), _texture.getHeight());
+		}
+		_texture.create(next->width, next->height);
+		labelGLObject(GL_TEXTURE, _texture.getTexture(), "Image sequence");
+	}
+	_texture.upload(&next->rgba[0]);
+	_shown = wanted;
+	_missing = false;
+}
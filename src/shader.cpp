@@ -3,6 +3,7 @@
 #include <vector>
 #include <memory>
 #include <stdint.h>
+#include <string.h>
 
 struct SourceFile {
 	std::string filename;
@@ -31,12 +32,49 @@ SourceFile readWholeFile(const std::string& path) {
 	return result;
 }
 
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+bool isParallelShaderCompileSupported() {
+	static int supported = -1;
+	if(supported == -1) {
+		supported = 0;
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for(GLint i = 0; i < count; ++i) {
+			const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if(strcmp(ext, "GL_ARB_parallel_shader_compile") == 0 || strcmp(ext, "GL_KHR_parallel_shader_compile") == 0) {
+				supported = 1;
+				break;
+			}
+		}
+		if(supported) {
+			// Let the driver pick its own number of compiler threads
+			PFNGLMAXSHADERCOMPILERTHREADSPROC maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSPROC)gl3wGetProcAddress("glMaxShaderCompilerThreadsARB");
+			if(!maxThreads) maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSPROC)gl3wGetProcAddress("glMaxShaderCompilerThreadsKHR");
+			if(maxThreads) maxThreads(0xFFFFFFFF);
+		}
+	}
+	return supported == 1;
+}
+
 bool Shader::compile(GLenum shaderType, GLint size, const GLchar* data, const char* filename) {
+	startCompile(shaderType, size, data);
+	return checkCompileStatus(filename);
+}
+
+void Shader::startCompile(GLenum shaderType, GLint size, const GLchar* data) {
+	// Keep the source around so it can be inspected after compilation (eg. parameter annotations)
+	_source.assign(data, size == 0 ? strlen(data) : size);
+
+	// Shaders are recompiled in place, don't leak the previous one
+	if(_id != 0) CHECK_GL(glDeleteShader(_id));
 	CHECK_GL(_id = glCreateShader(shaderType));
 	// If shader size is 0, pass null to indicate null-terminated (ie embedded shader)
 	CHECK_GL(glShaderSource(_id, 1, &data, size == 0 ? NULL : &size));
 	CHECK_GL(glCompileShader(_id));
+}
 
+bool Shader::checkCompileStatus(const char* filename) {
 	GLint isCompiled = 0;
 	CHECK_GL(glGetShaderiv(_id, GL_COMPILE_STATUS, &isCompiled));
 	if(isCompiled == GL_FALSE) {
@@ -46,13 +84,28 @@ bool Shader::compile(GLenum shaderType, GLint size, const GLchar* data, const ch
 		// The logLength includes the NULL character
 		std::vector<GLchar> errorLog(logLength);
 		glGetShaderInfoLog(_id, logLength, &logLength, &errorLog[0]);
+		_infoLog.assign(&errorLog[0], logLength);
 		RAW_LOG_F(ERROR, "Failed to compile shader '%s'", filename);
 		RAW_LOG_F(ERROR, "%s", &errorLog[0]);
 
 		glDeleteShader(_id);
+		_id = 0;
 		return false;
 	}
 
+	labelGLObject(GL_SHADER, _id, filename);
+	return true;
+}
+
+bool Shader::startCompile(GLenum shaderType, const std::string& sourceFile) {
+	SourceFile source = readWholeFile(sourceFile);
+	if(source.size == 0) {
+		LOG_F(ERROR, "Couldn't read from file '%s'", sourceFile.c_str());
+		_infoLog = "Couldn't read from file";
+		return false;
+	}
+
+	startCompile(shaderType, source.size, (const GLchar*)source.data.get());
 	return true;
 }
 
@@ -71,8 +124,24 @@ void Program::bindAttribLocation(GLuint attribIndex, const GLchar* name) const {
 }
 
 bool Program::link() const {
+	startLink();
+	return checkLinkStatus();
+}
+
+void Program::startLink() const {
 	CHECK_GL(glLinkProgram(_id));
+}
+
+bool Program::isLinkComplete() const {
+	if(!isParallelShaderCompileSupported()) {
+		return true;
+	}
+	GLint complete = GL_FALSE;
+	CHECK_GL(glGetProgramiv(_id, GL_COMPLETION_STATUS_ARB, &complete));
+	return complete == GL_TRUE;
+}
 
+bool Program::checkLinkStatus() const {
 	GLint isLinked;
 	glGetProgramiv(_id, GL_LINK_STATUS, &isLinked);
 	if (isLinked == GL_FALSE) {
@@ -81,6 +150,7 @@ bool Program::link() const {
 		std::vector<GLchar> errorLog(logLength);
 
 		glGetProgramInfoLog(_id, logLength, &logLength, &errorLog[0]);
+		_infoLog.assign(&errorLog[0], logLength);
 
 		LOG_F(ERROR, "%s", &errorLog[0]);
 
@@ -92,4 +162,29 @@ bool Program::link() const {
 
 void Program::use() const {
 	glUseProgram(_id);
-}
\ No newline at end of file
+}
+
+std::vector<UniformInfo> Program::getActiveUniforms() const {
+	std::vector<UniformInfo> uniforms;
+
+	GLint count = 0, maxNameLength = 0;
+	CHECK_GL(glGetProgramiv(_id, GL_ACTIVE_UNIFORMS, &count));
+	CHECK_GL(glGetProgramiv(_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength));
+	if(count <= 0) {
+		return uniforms;
+	}
+
+	std::vector<GLchar> name(maxNameLength + 1);
+	for(GLint i = 0; i < count; ++i) {
+		GLsizei nameLength = 0;
+		UniformInfo info;
+		CHECK_GL(glGetActiveUniform(_id, (GLuint)i, (GLsizei)name.size(), &nameLength, &info.size, &info.type, &name[0]));
+		info.name.assign(&name[0], nameLength);
+		CHECK_GL(info.location = glGetUniformLocation(_id, info.name.c_str()));
+		// Uniforms in blocks have no location and can't be set individually
+		if(info.location != -1) {
+			uniforms.push_back(info);
+		}
+	}
+	return uniforms;
+}
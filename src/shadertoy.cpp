@@ -0,0 +1,318 @@
+#include "shadertoy.h"
+#include "json.h"
+#include "video_channel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <loguru/loguru.hpp>
+
+std::string buildShaderToyPass(const std::string& common, const std::string& code, RenderPass::Type type, const GLenum channelTypes[CHANNEL_COUNT]) {
+	std::string source =
+		"#version 330\n"
+		"uniform vec3 iResolution;\n"
+		"uniform float iTime;\n"
+		"uniform float iTimeDelta;\n"
+		"uniform float iFrameRate;\n"
+		"uniform int iFrame;\n"
+		"uniform float iChannelTime[4];\n"
+		"uniform vec3 iChannelResolution[4];\n"
+		"uniform vec4 iMouse;\n"
+		"uniform vec4 iDate;\n"
+		"uniform float iSampleRate;\n";
+	for(int c = 0; c < CHANNEL_COUNT; ++c) {
+		char line[64];
+		snprintf(line, sizeof(line), "uniform %s iChannel%d;\n", channelTypes[c] == GL_TEXTURE_CUBE_MAP ? "samplerCube" : "sampler2D", c);
+		source += line;
+	}
+	source += "layout(location = 0) out vec4 Out_Color;\n";
+
+	// Error lines are reported per part: file 1 is the common code, file 2 the pass
+	if(!common.empty()) {
+		source += "#line 1 1\n" + common + "\n";
+	}
+	source += "#line 1 2\n" + code + "\n#line 1 3\n";
+
+	if(type == RenderPass::CUBEMAP) {
+		source +=
+			"uniform int iCubeFace;\n"
+			"void main() {\n"
+			"\tvec2 st = gl_FragCoord.xy / iResolution.xy * 2.0 - 1.0;\n"
+			"\tvec3 dir;\n"
+			"\tif(iCubeFace == 0) dir = vec3(1.0, -st.y, -st.x);\n"
+			"\telse if(iCubeFace == 1) dir = vec3(-1.0, -st.y, st.x);\n"
+			"\telse if(iCubeFace == 2) dir = vec3(st.x, 1.0, st.y);\n"
+			"\telse if(iCubeFace == 3) dir = vec3(st.x, -1.0, -st.y);\n"
+			"\telse if(iCubeFace == 4) dir = vec3(st.x, -st.y, 1.0);\n"
+			"\telse dir = vec3(-st.x, -st.y, -1.0);\n"
+			"\tvec4 color = vec4(0.0);\n"
+			"\tmainCubemap(color, gl_FragCoord.xy, vec3(0.0), normalize(dir));\n"
+			"\tOut_Color = color;\n"
+			"}\n";
+	} else {
+		source +=
+			"void main() {\n"
+			"\tvec4 color = vec4(0.0);\n"
+			"\tmainImage(color, gl_FragCoord.xy);\n";
+		source += type == RenderPass::OUTPUT ? "\tOut_Color = vec4(color.rgb, 1.0);\n}\n" : "\tOut_Color = color;\n}\n";
+	}
+	return source;
+}
+
+static bool readTextFile(const std::string& path, std::string& text) {
+	std::ifstream in(path.c_str(), std::ios::binary);
+	if(!in) return false;
+	std::stringstream contents;
+	contents << in.rdbuf();
+	text = contents.str();
+	return true;
+}
+
+static bool fileExists(const std::string& path) {
+	FILE* f = fopen(path.c_str(), "rb");
+	if(f) fclose(f);
+	return f != NULL;
+}
+
+/* Finds the local copy of a ShaderToy asset such as /media/a/xyz.png */
+static std::string resolveAsset(const std::string& baseDir, const std::string& assetPath) {
+	size_t slash = assetPath.rfind('/');
+	std::string name = slash == std::string::npos ? assetPath : assetPath.substr(slash + 1);
+	std::string relative = assetPath;
+	while(!relative.empty() && relative[0] == '/') relative.erase(0, 1);
+
+	if(fileExists(baseDir + name)) return baseDir + name;
+	if(fileExists(baseDir + relative)) return baseDir + relative;
+	return std::string();
+}
+
+static SamplerSettings parseSampler(const JsonValue& sampler) {
+	SamplerSettings settings;
+	std::string filter = sampler["filter"].asString("linear");
+	if(filter == "nearest") settings.filter = SamplerSettings::NEAREST;
+	else if(filter == "mipmap") settings.filter = SamplerSettings::MIPMAP;
+	settings.repeat = sampler["wrap"].asString() == "repeat";
+	return settings;
+}
+
+/* The pass object list, from either the API's {"Shader": ...} or a bare shader or list of shaders */
+static const JsonValue& findRenderPasses(const JsonValue& root) {
+	const JsonValue* shader = &root;
+	if(shader->isArray()) shader = &(*shader)[0];
+	if((*shader)["Shader"].isObject()) shader = &(*shader)["Shader"];
+	return (*shader)["renderpass"];
+}
+
+/**
+ * Reads rendering hints from a "// shade:" comment in the pass code:
+ * scale(0.5) renders at half the output size, every(N) draws every Nth
+ * frame and every(change) only when an input changed.
+ */
+static std::string passHints(const std::string& code) {
+	size_t hints = code.find("// shade:");
+	if(hints == std::string::npos) return std::string();
+	return code.substr(hints, code.find('\n', hints) - hints);
+}
+
+/* Interval of an every() hint, 1 without one */
+static int parseUpdateInterval(const std::string& line) {
+	size_t every = line.find("every(");
+	if(every == std::string::npos) return 1;
+	const char* value = line.c_str() + every + 6;
+	int interval = strncmp(value, "change", 6) == 0 ? 0 : atoi(value);
+	return interval < 0 ? 1 : interval;
+}
+
+static void parsePassHints(const std::string& code, RenderPass& pass) {
+	std::string line = passHints(code);
+	if(line.empty()) return;
+
+	size_t scale = line.find("scale(");
+	if(scale != std::string::npos) {
+		float value = (float)atof(line.c_str() + scale + 6);
+		if(pass.type == RenderPass::OUTPUT) LOG_F(WARNING, "%s: only buffers and cubemaps can be scaled", pass.name.c_str());
+		else if(value > 0.0f && value <= 1.0f) pass.scale = value;
+		else LOG_F(WARNING, "%s: scale must be in (0, 1]", pass.name.c_str());
+	}
+	pass.updateInterval = parseUpdateInterval(line);
+}
+
+static bool passOrder(const std::pair<std::string, const JsonValue*>& a, const std::pair<std::string, const JsonValue*>& b) {
+	return a.first < b.first;
+}
+
+typedef std::vector<std::pair<std::string, const JsonValue*> > NamedPasses;
+
+/* Parses a project and sorts its passes into drawing order: buffers by name, cubemap, image */
+static bool readProject(const char* path, JsonValue& root, std::string& common, NamedPasses& ordered, std::string& error) {
+	std::string text;
+	if(!readTextFile(path, text)) {
+		error = std::string("Couldn't read '") + path + "'";
+		return false;
+	}
+	if(!JsonValue::parse(text, root, error)) {
+		error = std::string(path) + ": " + error;
+		return false;
+	}
+
+	const JsonValue& renderPasses = findRenderPasses(root);
+	if(!renderPasses.isArray() || renderPasses.size() == 0) {
+		error = std::string(path) + " has no render passes";
+		return false;
+	}
+
+	NamedPasses buffers, cubemaps, images;
+	for(size_t i = 0; i < renderPasses.size(); ++i) {
+		const JsonValue& pass = renderPasses[i];
+		std::string type = pass["type"].asString();
+		std::string name = pass["name"].asString(type);
+		if(type == "common") {
+			common += pass["code"].asString() + "\n";
+		} else if(type == "buffer") {
+			buffers.push_back(std::make_pair(name, &pass));
+		} else if(type == "cubemap") {
+			cubemaps.push_back(std::make_pair(name, &pass));
+		} else if(type == "image") {
+			images.push_back(std::make_pair(name, &pass));
+		} else {
+			LOG_F(WARNING, "Skipping unsupported %s pass '%s'", type.c_str(), name.c_str());
+		}
+	}
+	if(images.empty()) {
+		error = std::string(path) + " has no image pass";
+		return false;
+	}
+	std::sort(buffers.begin(), buffers.end(), passOrder);
+
+	ordered = buffers;
+	ordered.insert(ordered.end(), cubemaps.begin(), cubemaps.end());
+	ordered.push_back(images[0]);
+	return true;
+}
+
+bool isShaderToyProject(const char* path) {
+	size_t length = strlen(path);
+	return length > 5 && strcmp(path + length - 5, ".json") == 0;
+}
+
+bool shaderToyProjectCarriesState(const char* path) {
+	JsonValue root;
+	std::string common, error;
+	NamedPasses ordered;
+	if(!readProject(path, root, common, ordered, error)) return false;
+
+	std::vector<std::string> outputIds;
+	for(size_t i = 0; i < ordered.size(); ++i) {
+		outputIds.push_back((*ordered[i].second)["outputs"][0]["id"].asString());
+	}
+	for(size_t i = 0; i < ordered.size(); ++i) {
+		const JsonValue& json = *ordered[i].second;
+		if(parseUpdateInterval(passHints(json["code"].asString())) != 1) return true;
+		const JsonValue& inputs = json["inputs"];
+		for(size_t n = 0; n < inputs.size(); ++n) {
+			std::string ctype = inputs[n]["ctype"].asString(inputs[n]["type"].asString());
+			if(ctype != "buffer" && ctype != "cubemap") continue;
+			std::string id = inputs[n]["id"].asString();
+			std::vector<std::string>::iterator producer = std::find(outputIds.begin(), outputIds.end(), id);
+			// Same rule as loading: reads of passes drawn later are of their previous frame
+			if(!id.empty() && producer != outputIds.end() && producer - outputIds.begin() >= (ptrdiff_t)i) return true;
+		}
+	}
+	return false;
+}
+
+bool loadShaderToyProject(const char* path, RenderGraph& graph, std::string& error) {
+	JsonValue root;
+	std::string common;
+	NamedPasses ordered;
+	if(!readProject(path, root, common, ordered, error)) return false;
+
+	std::string baseDir = path;
+	size_t slash = baseDir.rfind('/');
+	baseDir = slash == std::string::npos ? std::string() : baseDir.substr(0, slash + 1);
+
+	// Pass outputs are referenced by id from inputs
+	std::vector<std::string> outputIds;
+	for(size_t i = 0; i < ordered.size(); ++i) {
+		const JsonValue& pass = *ordered[i].second;
+		RenderPass::Type type = pass["type"].asString() == "buffer" ? RenderPass::BUFFER :
+		                        (pass["type"].asString() == "cubemap" ? RenderPass::CUBEMAP : RenderPass::OUTPUT);
+		graph.addPass(ordered[i].first, type);
+		outputIds.push_back(pass["outputs"][0]["id"].asString());
+	}
+
+	std::vector<RenderPass*>& passes = graph.getPasses();
+	for(size_t i = 0; i < ordered.size(); ++i) {
+		const JsonValue& json = *ordered[i].second;
+		RenderPass& pass = *passes[i];
+		GLenum channelTypes[CHANNEL_COUNT] = { GL_TEXTURE_2D, GL_TEXTURE_2D, GL_TEXTURE_2D, GL_TEXTURE_2D };
+
+		const JsonValue& inputs = json["inputs"];
+		for(size_t n = 0; n < inputs.size(); ++n) {
+			const JsonValue& input = inputs[n];
+			int channel = (int)input["channel"].asNumber(-1);
+			if(channel < 0 || channel >= CHANNEL_COUNT) continue;
+
+			std::string ctype = input["ctype"].asString(input["type"].asString());
+			std::string id = input["id"].asString();
+			std::string asset = input["filepath"].asString(input["src"].asString());
+			const JsonValue& sampler = input["sampler"];
+			PassInput& target = pass.inputs[channel];
+			target.sampler = parseSampler(sampler);
+
+			if(ctype == "buffer" || ctype == "cubemap") {
+				std::vector<std::string>::iterator producer = std::find(outputIds.begin(), outputIds.end(), id);
+				if(producer != outputIds.end() && !id.empty()) {
+					target.source = PassInput::PASS;
+					target.pass = (int)(producer - outputIds.begin());
+					// Passes drawn later (and the pass itself) show their previous frame, as on ShaderToy
+					target.previousFrame = target.pass >= (int)i;
+					channelTypes[channel] = passes[target.pass]->getOutputTarget();
+					continue;
+				}
+				if(ctype == "buffer") {
+					LOG_F(WARNING, "%s: iChannel%d reads a buffer that isn't in the project", pass.name.c_str(), channel);
+					continue;
+				}
+			}
+
+			ChannelInput* channelInput = NULL;
+			if(ctype == "keyboard") {
+				channelInput = new KeyboardChannel;
+			} else if(ctype == "texture" || ctype == "cubemap" || ctype == "video") {
+				std::string file = resolveAsset(baseDir, asset);
+				if(file.empty()) {
+					LOG_F(WARNING, "%s: iChannel%d needs '%s', place it next to the project", pass.name.c_str(), channel, asset.c_str());
+					continue;
+				}
+				bool flip = sampler["vflip"].asBool(ctype != "cubemap");
+				bool srgb = sampler["srgb"].asBool(false);
+				if(ctype == "video") {
+					VideoChannel* video = new VideoChannel;
+					if(video->init(file.c_str())) channelInput = video;
+					else delete video;
+				} else {
+					ImageChannel* image = new ImageChannel;
+					bool loaded = ctype == "cubemap" ? image->initCubemap(file.c_str(), flip, srgb) : image->init(file.c_str(), flip, srgb);
+					if(loaded) channelInput = image;
+					else delete image;
+				}
+			} else {
+				LOG_F(WARNING, "%s: %s inputs aren't supported, iChannel%d is left unbound", pass.name.c_str(), ctype.c_str(), channel);
+			}
+
+			if(channelInput) {
+				target.source = PassInput::CHANNEL;
+				target.channel = graph.addChannel(channelInput);
+				channelTypes[channel] = channelInput->getTarget();
+			}
+		}
+
+		parsePassHints(json["code"].asString(), pass);
+		pass.source = buildShaderToyPass(common, json["code"].asString(), pass.type, channelTypes);
+	}
+	return true;
+}
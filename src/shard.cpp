@@ -0,0 +1,136 @@
+#include "export.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <loguru/loguru.hpp>
+
+#if !defined(_WIN32)
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+/* Chunks per worker, so workers that finish early pick up the remaining frames */
+static const size_t CHUNKS_PER_WORKER = 4;
+
+/**
+ * Copies the command line minus the options the coordinator overrides
+ * (--workers, --frames, --shard), for the worker processes.
+ */
+static std::vector<std::string> workerArguments(int argc, const char* argv[]) {
+	static const char* overridden[] = { "-j", "--workers", "-f", "--frames", "-s", "--shard" };
+	std::vector<std::string> args;
+	for(int i = 0; i < argc; ++i) {
+		bool skip = false;
+		for(size_t o = 0; o < sizeof(overridden) / sizeof(overridden[0]); ++o) {
+			size_t length = strlen(overridden[o]);
+			if(strcmp(argv[i], overridden[o]) == 0) {
+				// Also drop the option's value
+				++i;
+				skip = true;
+			} else if(strncmp(argv[i], overridden[o], length) == 0 && argv[i][length] == '=') {
+				skip = true;
+			}
+		}
+		if(!skip) args.push_back(argv[i]);
+	}
+	return args;
+}
+
+#if defined(_WIN32)
+
+int runShardCoordinator(int, const char*[], const ExportSettings&, const std::string&, int, bool) {
+	fprintf(stderr, "--workers isn't supported on this platform, run instances with --shard K/N instead\n");
+	return EXIT_FAILURE;
+}
+
+#else
+
+static pid_t spawnWorker(const std::vector<std::string>& baseArgs, const std::vector<int>& frames) {
+	std::vector<std::string> args = baseArgs;
+	args.push_back("--frames");
+	args.push_back(formatFrameList(frames));
+
+	std::vector<char*> argv;
+	for(size_t i = 0; i < args.size(); ++i) {
+		argv.push_back(const_cast<char*>(args[i].c_str()));
+	}
+	argv.push_back(NULL);
+
+	pid_t pid;
+	// argv[0] may be a bare name found through PATH, so use the p variant
+	if(posix_spawnp(&pid, argv[0], NULL, NULL, &argv[0], environ) != 0) {
+		return -1;
+	}
+	return pid;
+}
+
+int runShardCoordinator(int argc, const char* argv[], const ExportSettings& settings, const std::string& stem, int workers, bool carriesState) {
+	// Frames rendered by an earlier, interrupted run are kept
+	std::vector<int> remaining;
+	for(size_t i = 0; i < settings.frames.size(); ++i) {
+		if(!frameExists(settings.outDir, stem, settings.frames[i])) {
+			remaining.push_back(settings.frames[i]);
+		}
+	}
+
+	// A chunk of a stateful project renders all frames before it too, so splitting only adds work
+	size_t chunkSize = remaining.size() / (workers * CHUNKS_PER_WORKER);
+	if(carriesState && workers > 1) {
+		fprintf(stderr, "Frames depend on earlier ones (buffers read their previous frame, or passes skip frames), rendering them in one worker\n");
+		workers = 1;
+		chunkSize = remaining.size();
+	}
+	fprintf(stderr, "%d of %d frames to render with %d workers\n", (int)remaining.size(), (int)settings.frames.size(), workers);
+	if(chunkSize < 1) chunkSize = 1;
+	std::deque<std::vector<int> > chunks;
+	for(size_t i = 0; i < remaining.size(); i += chunkSize) {
+		size_t end = i + chunkSize < remaining.size() ? i + chunkSize : remaining.size();
+		chunks.push_back(std::vector<int>(remaining.begin() + i, remaining.begin() + end));
+	}
+
+	std::vector<std::string> baseArgs = workerArguments(argc, argv);
+	int running = 0;
+	bool failed = false;
+	while(running > 0 || (!chunks.empty() && !failed)) {
+		while(running < workers && !chunks.empty() && !failed) {
+			pid_t pid = spawnWorker(baseArgs, chunks.front());
+			if(pid < 0) {
+				fprintf(stderr, "Couldn't launch worker '%s'\n", baseArgs[0].c_str());
+				failed = true;
+				break;
+			}
+			LOG_F(INFO, "Worker %d rendering frames %s", (int)pid, formatFrameList(chunks.front()).c_str());
+			chunks.pop_front();
+			++running;
+		}
+		if(running == 0) break;
+
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		if(pid < 0) break;
+		--running;
+		if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "Worker %d failed, not starting new chunks\n", (int)pid);
+			failed = true;
+		}
+	}
+
+	// Workers write straight into the final sequence, so merging comes down to checking it's complete
+	std::vector<int> missing;
+	for(size_t i = 0; i < settings.frames.size(); ++i) {
+		if(!frameExists(settings.outDir, stem, settings.frames[i])) {
+			missing.push_back(settings.frames[i]);
+		}
+	}
+	if(!missing.empty()) {
+		fprintf(stderr, "Missing frames: %s\n", formatFrameList(missing).c_str());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include "shm_output.h"
+
+#include <string.h>
+#include <loguru/loguru.hpp>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/* The ring header, slots and the pixels in each slot start on page boundaries */
+static const size_t SHM_PAGE_SIZE = 4096;
+
+static size_t alignUp(size_t size, size_t alignment) {
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+#if defined(_WIN32)
+
+bool ShmFrameOutput::open(const char* name, int, int, ShmPixelFormat, int) {
+	LOG_F(ERROR, "Shared-memory output '%s' isn't supported on this platform", name);
+	return false;
+}
+
+void ShmFrameOutput::close() {}
+
+void ShmFrameOutput::publish(const uint8_t*, uint64_t) {}
+
+#else
+
+bool ShmFrameOutput::open(const char* name, int width, int height, ShmPixelFormat format, int slotCount) {
+	close();
+
+	_name = name[0] == '/' ? name : std::string("/") + name;
+	_width = width;
+	_height = height;
+	_format = format;
+	_stride = width * (format == SHM_FORMAT_RGBA32F ? 16 : 4);
+
+	size_t headerSize = alignUp(sizeof(ShmRingHeader), SHM_PAGE_SIZE);
+	size_t slotSize = alignUp(sizeof(ShmFrameHeader), SHM_PAGE_SIZE) + alignUp((size_t)_stride * height, SHM_PAGE_SIZE);
+	_mappedSize = headerSize + slotSize * slotCount;
+
+	_fd = shm_open(_name.c_str(), O_CREAT | O_RDWR, 0644);
+	if(_fd < 0) {
+		LOG_F(ERROR, "Couldn't create shared memory '%s'", _name.c_str());
+		return false;
+	}
+	if(ftruncate(_fd, _mappedSize) != 0) {
+		LOG_F(ERROR, "Couldn't size shared memory '%s' to %d bytes", _name.c_str(), (int)_mappedSize);
+		close();
+		return false;
+	}
+	void* base = mmap(NULL, _mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+	if(base == MAP_FAILED) {
+		LOG_F(ERROR, "Couldn't map shared memory '%s'", _name.c_str());
+		close();
+		return false;
+	}
+	_base = (uint8_t*)base;
+	memset(_base, 0, headerSize);
+
+	ShmRingHeader* ring = header();
+	ring->version = SHADE_SHM_VERSION;
+	ring->slotCount = slotCount;
+	ring->slotSize = (uint32_t)slotSize;
+	ring->headerSize = (uint32_t)alignUp(sizeof(ShmFrameHeader), SHM_PAGE_SIZE);
+	ring->sequence = 0;
+	ring->latestSlot = 0;
+	ring->latestFrame = 0;
+	for(int i = 0; i < slotCount; ++i) {
+		memset(_base + headerSize + slotSize * i, 0, sizeof(ShmFrameHeader));
+	}
+	// Written last so consumers that see the magic see a complete header
+	__atomic_store_n(&ring->magic, (uint32_t)SHADE_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	_published = 0;
+	LOG_F(INFO, "Publishing %dx%d frames to shared memory '%s' (%d slots)", width, height, _name.c_str(), slotCount);
+	return true;
+}
+
+void ShmFrameOutput::close() {
+	if(_base) {
+		munmap(_base, _mappedSize);
+		_base = nullptr;
+	}
+	if(_fd >= 0) {
+		::close(_fd);
+		shm_unlink(_name.c_str());
+		_fd = -1;
+	}
+}
+
+void ShmFrameOutput::publish(const uint8_t* pixels, uint64_t frameIndex) {
+	if(!_base) return;
+
+	ShmRingHeader* ring = header();
+	uint32_t slotIndex = (uint32_t)(_published % ring->slotCount);
+	uint8_t* slot = _base + alignUp(sizeof(ShmRingHeader), SHM_PAGE_SIZE) + (size_t)ring->slotSize * slotIndex;
+	ShmFrameHeader* frame = (ShmFrameHeader*)slot;
+
+	// Odd seqlock while the slot is being overwritten
+	uint32_t seq = __atomic_load_n(&frame->seqlock, __ATOMIC_RELAXED);
+	__atomic_store_n(&frame->seqlock, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	frame->format = _format;
+	frame->width = _width;
+	frame->height = _height;
+	frame->stride = _stride;
+	frame->frameIndex = frameIndex;
+	frame->timestampNs = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+	memcpy(slot + ring->headerSize, pixels, (size_t)_stride * _height);
+
+	__atomic_store_n(&frame->seqlock, seq + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&ring->latestSlot, slotIndex, __ATOMIC_RELAXED);
+	__atomic_store_n(&ring->latestFrame, frameIndex, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&ring->sequence, 1, __ATOMIC_RELEASE);
+	++_published;
+
+#if defined(__linux__)
+	// Shared (non-private) futex so waiters in other processes are woken
+	syscall(SYS_futex, &ring->sequence, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+#endif
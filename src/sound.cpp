@@ -0,0 +1,132 @@
+#include "app.h"
+#include "sound.h"
+#include "wav.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+
+std::string buildSoundShader(const std::string& source) {
+	size_t name = source.find("mainSound");
+	size_t open = name == std::string::npos ? name : source.find('(', name);
+	size_t close = open == std::string::npos ? open : source.find(')', open);
+	if(close == std::string::npos) {
+		return std::string();
+	}
+	bool withSampleIndex = source.find(',', open) < close;
+
+	// The wrapper picks the GLSL version, drop the shader's own
+	std::string body = source;
+	size_t version = body.find("#version");
+	if(version != std::string::npos) {
+		body.replace(version, body.find('\n', version) - version, "");
+	}
+
+	char main[512];
+	snprintf(main, sizeof(main),
+		"\nvoid main() {\n"
+		"\tint samp = iBlockOffset + int(gl_FragCoord.y) * %d + int(gl_FragCoord.x);\n"
+		"\tfloat time = float(samp) / iSampleRate;\n"
+		"\tOut_Sound = vec4(%s, 0.0, 1.0);\n"
+		"}\n",
+		SOUND_BLOCK_WIDTH, withSampleIndex ? "mainSound(samp, time)" : "mainSound(time)");
+
+	return "#version 330\n"
+	       "uniform float iSampleRate;\n"
+	       "uniform int iBlockOffset;\n"
+	       "layout(location = 0) out vec4 Out_Sound;\n"
+	       "#line 1\n" + body + main;
+}
+
+/**
+ * Renders a sound shader to a WAV file or stdout.  Each draw fills a whole
+ * block of several seconds of samples; blocks are read back asynchronously
+ * so the GPU renders the next block while the previous one is written.
+ */
+int ShadeApp::renderSound(const char* shaderFile, const SoundSettings& settings) {
+	std::ifstream in(shaderFile, std::ios::binary);
+	if(!in) {
+		fprintf(stderr, "Couldn't read '%s'\n", shaderFile);
+		return EXIT_FAILURE;
+	}
+	std::stringstream contents;
+	contents << in.rdbuf();
+
+	std::string source = buildSoundShader(contents.str());
+	if(source.empty()) {
+		fprintf(stderr, "'%s' has no mainSound() function\n", shaderFile);
+		return EXIT_FAILURE;
+	}
+
+	Shader fragment;
+	if(!fragment.compile(GL_FRAGMENT_SHADER, (GLint)source.size(), source.c_str(), shaderFile)) {
+		fprintf(stderr, "%s\n", fragment.getInfoLog().c_str());
+		return EXIT_FAILURE;
+	}
+	Program program(_builtinVertexShader, &fragment);
+	program.bindAttribLocation(0, "Pos");
+	program.bindAttribLocation(1, "UV");
+	if(!program.link()) {
+		fprintf(stderr, "%s\n", program.getInfoLog().c_str());
+		return EXIT_FAILURE;
+	}
+	GLint sampleRate = glGetUniformLocation(program.getID(), "iSampleRate");
+	GLint blockOffset = glGetUniformLocation(program.getID(), "iBlockOffset");
+
+	RenderTarget target;
+	AsyncReadback readback;
+	if(!target.create(SOUND_BLOCK_WIDTH, SOUND_BLOCK_HEIGHT, GL_RG32F) ||
+	   !readback.init(SOUND_BLOCK_WIDTH, SOUND_BLOCK_HEIGHT, GL_RG, GL_FLOAT)) {
+		return EXIT_FAILURE;
+	}
+	target.setLabel("Sound block");
+
+	uint64_t totalFrames = (uint64_t)(settings.duration * settings.sampleRate);
+	const uint64_t blockFrames = SOUND_BLOCK_WIDTH * SOUND_BLOCK_HEIGHT;
+	uint64_t blockCount = (totalFrames + blockFrames - 1) / blockFrames;
+
+	WavWriter wav;
+	if(!wav.open(settings.output.c_str(), settings.sampleRate, totalFrames)) {
+		return EXIT_FAILURE;
+	}
+
+	double start = glfwGetTime();
+	bool ok = true;
+	uint64_t written = 0;
+	for(uint64_t block = 0; block < blockCount || readback.pending() > 0; ) {
+		if(block < blockCount && readback.pending() < 3) {
+			target.bind();
+			program.use();
+			glUniform1f(sampleRate, (float)settings.sampleRate);
+			glUniform1i(blockOffset, (GLint)(block * blockFrames));
+			drawQuad();
+			readback.start(target, block);
+			++block;
+			// Keep queueing blocks until the readback ring is full
+			if(block < blockCount && readback.pending() < 3) continue;
+		}
+
+		uint64_t tag;
+		const float* samples = (const float*)readback.map(tag, true);
+		if(!samples) {
+			ok = false;
+			break;
+		}
+		uint64_t count = totalFrames - written < blockFrames ? totalFrames - written : blockFrames;
+		ok = wav.write(samples, (size_t)count);
+		readback.unmap();
+		written += count;
+		if(!ok) break;
+	}
+	RenderTarget::unbind();
+	wav.close();
+
+	if(!ok) {
+		fprintf(stderr, "Couldn't write '%s'\n", settings.output.c_str());
+		return EXIT_FAILURE;
+	}
+	LOG_F(INFO, "Rendered %.1f s of audio in %.2f s", settings.duration, glfwGetTime() - start);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+#include "tile_scheduler.h"
+
+#include <string.h>
+
+/* Weight of a new measurement in the running estimate of a tile's cost */
+static const double COST_SMOOTHING = 0.25;
+
+void TileScheduler::schedule(size_t count, std::vector<size_t>& tiles) {
+	if(_tiles.size() != count) {
+		destroy();
+		Tile tile;
+		memset(&tile, 0, sizeof(tile));
+		tile.cost = DEFAULT_TILE_COST_MS;
+		_tiles.assign(count, tile);
+		_next = 0;
+	}
+	collect();
+
+	tiles.clear();
+	_plannedMs = 0.0;
+	for(size_t n = 0; n < count; ++n) {
+		size_t tile = (_next + n) % count;
+		double cost = _tiles[tile].cost;
+		if(!tiles.empty() && _plannedMs + cost > _budgetMs) break;
+		tiles.push_back(tile);
+		_plannedMs += cost;
+	}
+	if(count > 0) _next = (_next + tiles.size()) % count;
+}
+
+void TileScheduler::beginTile(size_t tile) {
+	// GL_TIMESTAMP is core in 3.3, the context may be 3.2
+	Tile& t = _tiles[tile];
+	if(t.timing || !gl3wIsSupported(3, 3)) return;
+	if(t.queries[0] == 0) {
+		glGenQueries(2, t.queries);
+	}
+	glQueryCounter(t.queries[0], GL_TIMESTAMP);
+	t.started = true;
+}
+
+void TileScheduler::endTile(size_t tile) {
+	Tile& t = _tiles[tile];
+	if(!t.started) return;
+	glQueryCounter(t.queries[1], GL_TIMESTAMP);
+	t.started = false;
+	t.timing = true;
+}
+
+void TileScheduler::invalidate(size_t tile) {
+	if(tile >= _tiles.size()) return;
+	// A timing still in flight is of the old program, drop it; the queries are reused by the next begin
+	_tiles[tile].started = false;
+	_tiles[tile].timing = false;
+	_tiles[tile].measured = false;
+	_tiles[tile].cost = DEFAULT_TILE_COST_MS;
+}
+
+void TileScheduler::collect() {
+	for(size_t i = 0; i < _tiles.size(); ++i) {
+		Tile& tile = _tiles[i];
+		if(!tile.timing) continue;
+		GLint available = 0;
+		glGetQueryObjectiv(tile.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if(!available) continue;
+
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(tile.queries[0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(tile.queries[1], GL_QUERY_RESULT, &end);
+		double ms = end > start ? (end - start) / 1e6 : 0.0;
+		tile.cost = tile.measured ? tile.cost + (ms - tile.cost) * COST_SMOOTHING : ms;
+		tile.measured = true;
+		tile.timing = false;
+	}
+}
+
+void TileScheduler::destroy() {
+	for(size_t i = 0; i < _tiles.size(); ++i) {
+		if(_tiles[i].queries[0] != 0) {
+			glDeleteQueries(2, _tiles[i].queries);
+		}
+	}
+	_tiles.clear();
+	_next = 0;
+}
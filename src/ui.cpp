@@ -2,6 +2,8 @@
 
 void ShadeApp::initUI() {
 	ImGui_ImplGlfwGL3_Init(_window, true);
+	// Chain in front of ImGui's key callback to capture key events
+	glfwSetKeyCallback(_window, keyCallback);
 }
 
 void ShadeApp::drawUI() {
@@ -9,12 +11,57 @@ void ShadeApp::drawUI() {
     if(ImGui::BeginMenu("File")) {
         if(ImGui::MenuItem("Reload", "CTRL+R")) {
             loadFragmentShader(_currentShaderFile);
+            logLiveGLObjects();
+        }
+        ImGui::EndMenu();
+    }
+    if(ImGui::BeginMenu("View")) {
+        ImGui::MenuItem("Parameters", NULL, &_showParameters);
+        ImGui::MenuItem("Render graph", NULL, &_showGraph);
+        ImGui::MenuItem("Frame times", NULL, &_showFrameStats);
+        if(!_views.empty()) {
+            ImGui::MenuItem("Shader grid", NULL, &_showViews);
+            float budget = (float)_tileScheduler.getBudget();
+            if(ImGui::SliderFloat("Grid GPU budget", &budget, 0.5f, 33.0f, "%.1f ms")) {
+                _tileScheduler.setBudget(budget);
+            }
+        }
+        if(ImGui::MenuItem("Fullscreen", "F11", _fullscreen)) {
+            setFullscreen(!_fullscreen);
+        }
+        if(ImGui::BeginMenu("Present")) {
+            FramePacer::Mode mode = _pacer.getMode();
+            if(ImGui::MenuItem("Vsync", NULL, mode == FramePacer::VSYNC)) setPresentMode(FramePacer::VSYNC);
+            if(ImGui::MenuItem("Uncapped", NULL, mode == FramePacer::UNCAPPED)) setPresentMode(FramePacer::UNCAPPED);
+            if(ImGui::MenuItem("Low latency", NULL, mode == FramePacer::LOW_LATENCY)) setPresentMode(FramePacer::LOW_LATENCY);
+            static const int caps[] = { 30, 60, 120, 144 };
+            for(int i = 0; i < 4; ++i) {
+                char label[32];
+                snprintf(label, sizeof(label), "Capped at %d fps", caps[i]);
+                if(ImGui::MenuItem(label, NULL, mode == FramePacer::CAPPED && _pacer.getFpsCap() == caps[i])) {
+                    setPresentMode(FramePacer::CAPPED, caps[i]);
+                }
+            }
+            ImGui::EndMenu();
         }
         ImGui::EndMenu();
     }
     
     ImGui::EndMainMenuBar();
 
+    if(_showParameters) {
+        drawParameterUI();
+    }
+    if(_showGraph) {
+        drawGraphUI();
+    }
+    if(_showFrameStats) {
+        drawFrameStatsUI();
+    }
+    if(_showViews && !_views.empty()) {
+        drawViewsUI();
+    }
+
     // Framerate overlay
     ImGui::SetNextWindowPos(ImVec2(10,30));
     if (!ImGui::Begin("", &_showFramerate, ImVec2(0,0), 0.3f, ImGuiWindowFlags_NoTitleBar|ImGuiWindowFlags_NoResize|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoSavedSettings))
@@ -23,5 +70,275 @@ void ShadeApp::drawUI() {
         return;
     }
     ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+    if(_showViews && !_views.empty()) {
+        ImGui::Text("Tiles: %d of %d per frame, %.1f ms", (int)_scheduledTiles.size(), (int)_views.size(), _tileScheduler.getPlannedMs());
+    }
+    if(!_playlist.empty()) {
+        const PlaylistSlot& slot = _playlistSlots[_playlistCurrent];
+        const std::string& path = _playlist[slot.entry].path;
+        size_t slash = path.rfind('/');
+        double left = slot.startTime < 0.0 ? _playlist[slot.entry].duration : _playlist[slot.entry].duration - (_lastFrameTime - slot.startTime);
+        ImGui::Text("Playlist: %s (%d/%d), next in %.0f s", path.c_str() + (slash == std::string::npos ? 0 : slash + 1),
+            (int)slot.entry + 1, (int)_playlist.size(), left > 0.0 ? left : 0.0);
+    }
+    if(_pacer.getLatency() > 0.0) {
+        ImGui::Text("Input latency: %s%.1f ms (max %.1f)", _pacer.isLatencyUpperBound() ? "<= " : "",
+            _pacer.getLatency() * 1000.0, _pacer.getMaxLatency() * 1000.0);
+    }
+    ImGui::End();
+}
+
+/* Auto-generated controls for the uniforms of the current shader */
+void ShadeApp::drawParameterUI() {
+    std::vector<ShaderParameter>& params = _parameters.getParameters();
+    if(params.empty()) return;
+
+    ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 310.0f, 30), ImGuiSetCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(300, 0), ImGuiSetCond_FirstUseEver);
+    if(!ImGui::Begin("Parameters", &_showParameters)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Checkbox("Bake", &_bakeParameters);
+    if(_bakeParameters) {
+        ImGui::SameLine();
+        if(_bakedPermutation && _bakedPermutation->state == Permutation::READY) {
+            ImGui::Text("constants (%d cached)", (int)_permutations.size());
+        } else if(_bakedPermutation && _bakedPermutation->state == Permutation::FAILED) {
+            ImGui::Text("failed, using uniforms");
+        } else {
+            ImGui::TextDisabled("compiling...");
+        }
+    }
+    ImGui::Separator();
+
+    for(size_t i = 0; i < params.size(); ++i) {
+        ShaderParameter& param = params[i];
+        const char* label = param.name.c_str();
+        int components = ParameterTable::componentCount(param.type);
+        bool changed = false;
+
+        if(param.type == GL_BOOL) {
+            bool value = param.intValue[0] != 0;
+            if(ImGui::Checkbox(label, &value)) {
+                param.intValue[0] = value ? 1 : 0;
+                changed = true;
+            }
+        } else if(ParameterTable::isIntegerType(param.type)) {
+            int* v = param.intValue;
+            if(param.hasRange) {
+                int lo = (int)param.minValue, hi = (int)param.maxValue;
+                switch(components) {
+                    case 1: changed = ImGui::SliderInt(label, v, lo, hi); break;
+                    case 2: changed = ImGui::SliderInt2(label, v, lo, hi); break;
+                    case 3: changed = ImGui::SliderInt3(label, v, lo, hi); break;
+                    case 4: changed = ImGui::SliderInt4(label, v, lo, hi); break;
+                }
+            } else {
+                // Without a range there's nothing to scale a slider to, so use a drag control
+                switch(components) {
+                    case 1: changed = ImGui::DragInt(label, v, 0.2f); break;
+                    case 2: changed = ImGui::DragInt2(label, v, 0.2f); break;
+                    case 3: changed = ImGui::DragInt3(label, v, 0.2f); break;
+                    case 4: changed = ImGui::DragInt4(label, v, 0.2f); break;
+                }
+            }
+        } else if(param.isColor) {
+            changed = components == 3 ? ImGui::ColorEdit3(label, param.floatValue) : ImGui::ColorEdit4(label, param.floatValue);
+        } else {
+            float* v = param.floatValue;
+            float lo = param.minValue, hi = param.maxValue;
+            if(!param.hasRange) {
+                // Let unannotated parameters grow past the default [0,1] range
+                for(int c = 0; c < components; ++c) {
+                    if(v[c] < lo) lo = v[c];
+                    if(v[c] > hi) hi = v[c];
+                }
+            }
+            switch(components) {
+                case 1: changed = ImGui::SliderFloat(label, v, lo, hi); break;
+                case 2: changed = ImGui::SliderFloat2(label, v, lo, hi); break;
+                case 3: changed = ImGui::SliderFloat3(label, v, lo, hi); break;
+                case 4: changed = ImGui::SliderFloat4(label, v, lo, hi); break;
+            }
+        }
+
+        if(changed) {
+            _parameters.markEdited(param);
+        }
+    }
+
+    ImGui::End();
+}
+
+/* Passes of the render graph in drawing order, with their storage and what was skipped */
+void ShadeApp::drawGraphUI() {
+    if(!_graph) return;
+
+    ImGui::SetNextWindowPos(ImVec2(10, 70), ImGuiSetCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(320, 0), ImGuiSetCond_FirstUseEver);
+    if(!ImGui::Begin("Render graph", &_showGraph)) {
+        ImGui::End();
+        return;
+    }
+
+    std::vector<RenderPass*>& passes = _graph->getPasses();
+    const std::vector<RenderPass*>& schedule = _graph->getSchedule();
+    ImGui::Text("%d passes, %d textures (%.1f MB)", (int)schedule.size(), (int)_graph->getTextureCount(),
+        _graph->getTextureBytes() / (1024.0 * 1024.0));
+    if(_graph->getSlotCount() > 0) {
+        ImGui::Text("%d shared by transient buffers", _graph->getSlotCount());
+    }
+    ImGui::Separator();
+
+    static const char* typeNames[] = { "output", "buffer", "cubemap" };
+    for(size_t i = 0; i < schedule.size(); ++i) {
+        const RenderPass& pass = *schedule[i];
+        const char* storage = pass.type == RenderPass::OUTPUT ? "framebuffer" :
+                              (pass.transient ? "shared" : (pass.history ? "double-buffered" : "own texture"));
+        bool open = ImGui::TreeNode(&pass, "%d. %s", (int)i + 1, pass.name.c_str());
+        ImGui::SameLine(200);
+        if(pass.drawCount == 0) ImGui::TextDisabled("not drawn");
+        else if(pass.timeVarying) ImGui::Text("every frame");
+        else ImGui::Text("%d drawn, %d skipped", (int)pass.drawCount, (int)pass.skipCount);
+        if(!open) continue;
+
+        ImGui::Text("%s %dx%d, %s", typeNames[pass.type], pass.width, pass.height, storage);
+        if(pass.transient) {
+            ImGui::SameLine();
+            ImGui::Text("(slot %d)", pass.slot);
+        }
+        if(pass.type != RenderPass::OUTPUT && !pass.external) {
+            RenderPass& settings = *schedule[i];
+            bool changed = ImGui::SliderFloat("Scale", &settings.scale, 0.125f, 1.0f);
+            changed |= ImGui::InputInt("Every N frames (0: on change)", &settings.updateInterval);
+            if(changed) {
+                // Storage depends on the settings; buffers start over cleared
+                std::string error;
+                _graph->schedule(error);
+                _graph->resize(_graph->getWidth(), _graph->getHeight());
+            }
+        }
+        for(int c = 0; c < CHANNEL_COUNT; ++c) {
+            const PassInput& input = pass.inputs[c];
+            if(input.source == PassInput::PASS) {
+                ImGui::BulletText("iChannel%d: %s%s", c, passes[input.pass]->name.c_str(), input.previousFrame ? " (previous frame)" : "");
+            } else if(input.source == PassInput::CHANNEL) {
+                ImGui::BulletText("iChannel%d: %dx%d input", c, input.channel->getWidth(), input.channel->getHeight());
+            }
+        }
+        ImGui::TreePop();
+    }
+
+    for(size_t i = 0; i < passes.size(); ++i) {
+        if(passes[i]->order < 0) {
+            ImGui::TextDisabled("%s: unused", passes[i]->name.c_str());
+        }
+    }
     ImGui::End();
 }
+
+void ShadeApp::drawFrameStatsUI() {
+    ImGui::SetNextWindowPos(ImVec2(340, 70), ImGuiSetCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(360, 0), ImGuiSetCond_FirstUseEver);
+    if(!ImGui::Begin("Frame times", &_showFrameStats)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Combo("Window", &_frameStatsWindow, "Last second\0Last 10 seconds\0Last minute\0All time\0");
+    FrameStats::Window window = (FrameStats::Window)_frameStatsWindow;
+
+    ImGui::Columns(5, "frame times", false);
+    static const char* headers[] = { "ms", "p50", "p95", "p99", "max" };
+    for(int c = 0; c < 5; ++c) {
+        ImGui::TextDisabled("%s", headers[c]);
+        ImGui::NextColumn();
+    }
+    static const char* seriesNames[] = { "Frame", "CPU", "GPU" };
+    for(int s = 0; s < FrameStats::SERIES_COUNT; ++s) {
+        FrameTimePercentiles p = _frameStats.getPercentiles((FrameStats::Series)s, window);
+        ImGui::Text("%s", seriesNames[s]);
+        ImGui::NextColumn();
+        if(p.count == 0) {
+            for(int c = 0; c < 4; ++c) {
+                ImGui::TextDisabled("-");
+                ImGui::NextColumn();
+            }
+            continue;
+        }
+        double values[] = { p.p50, p.p95, p.p99, p.max };
+        for(int c = 0; c < 4; ++c) {
+            ImGui::Text("%.2f", values[c]);
+            ImGui::NextColumn();
+        }
+    }
+    ImGui::Columns(1);
+
+    // The last few seconds of frames, hitches stand out as spikes
+    std::vector<FrameSample> samples;
+    _frameStats.getRing().copy(samples, 300);
+    std::vector<float> intervals, gpu;
+    float highest = 0.0f;
+    for(size_t i = 0; i < samples.size(); ++i) {
+        intervals.push_back(samples[i].intervalMs > 0.0f ? samples[i].intervalMs : 0.0f);
+        gpu.push_back(samples[i].gpuMs > 0.0f ? samples[i].gpuMs : 0.0f);
+        if(intervals.back() > highest) highest = intervals.back();
+    }
+    if(!intervals.empty()) {
+        ImGui::PlotLines("Frame", &intervals[0], (int)intervals.size(), 0, NULL, 0.0f, highest * 1.1f, ImVec2(0, 60));
+        ImGui::PlotLines("GPU", &gpu[0], (int)gpu.size(), 0, NULL, 0.0f, highest * 1.1f, ImVec2(0, 60));
+    }
+
+    const char* csvFile = _frameTimesFile.empty() ? "frame_times.csv" : _frameTimesFile.c_str();
+    if(ImGui::Button("Export CSV")) {
+        _frameStats.writeCSV(csvFile);
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s", csvFile);
+    ImGui::End();
+}
+
+/* Names and errors over the tiles of the grid, in full for the hovered one; double-clicking a tile opens its shader alone */
+void ShadeApp::drawViewsUI() {
+    ImGuiIO& io = ImGui::GetIO();
+    // Tiles are in framebuffer pixels, ImGui in screen coordinates
+    float scale = _viewWidth > 0 ? io.DisplaySize.x / _viewWidth : 1.0f;
+    int hovered = -1;
+    for(size_t i = 0; i < _views.size(); ++i) {
+        const ShaderView& view = *_views[i];
+        int rect[4];
+        getViewRect(i, rect);
+        float left = rect[0] * scale;
+        float top = MENUBAR_HEIGHT + (_windowHeight - rect[1] - rect[3]) * scale;
+        bool isHovered = io.MousePos.x >= left && io.MousePos.x < left + rect[2] * scale &&
+                         io.MousePos.y >= top && io.MousePos.y < top + rect[3] * scale;
+        if(isHovered) {
+            hovered = (int)i;
+        }
+        // A gallery has too many tiles to label them all
+        bool compiling = view.error.empty() && (view.pending || !view.current);
+        if(!isHovered && view.error.empty() && !compiling && _views.size() > 16) continue;
+
+        char name[32];
+        snprintf(name, sizeof(name), "##view%d", (int)i);
+        ImGui::SetNextWindowPos(ImVec2(left + 4.0f, top + 4.0f));
+        ImGui::Begin(name, NULL, ImVec2(0,0), 0.3f, ImGuiWindowFlags_NoTitleBar|ImGuiWindowFlags_NoResize|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoSavedSettings|ImGuiWindowFlags_NoInputs|ImGuiWindowFlags_AlwaysAutoResize);
+        ImGui::Text("%s", view.path.c_str());
+        if(!view.error.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", isHovered ? view.error.c_str() : "error");
+        } else if(compiling) {
+            ImGui::TextDisabled("compiling");
+        } else if(isHovered && _tileScheduler.getCost(i) >= 0.0) {
+            ImGui::TextDisabled("%.2f ms", _tileScheduler.getCost(i));
+        }
+        ImGui::End();
+    }
+
+    if(hovered >= 0 && ImGui::IsMouseDoubleClicked(0) && !io.WantCaptureMouse) {
+        // Views live until the app exits, so the path outlives the loaded shader
+        loadFragmentShader(_views[hovered]->path.c_str());
+        _showViews = false;
+    }
+}
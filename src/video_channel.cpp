@@ -0,0 +1,149 @@
+#include "video_channel.h"
+
+#include <string.h>
+#include <loguru/loguru.hpp>
+
+VideoChannel::VideoChannel():_frameRate(0.0), _seekable(false), _shown(-1), _offline(false), _nextIndex(0), _seekTo(-1), _ended(false), _stop(false) {
+}
+
+VideoChannel::~VideoChannel() {
+	if(_decoder.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_wake.notify_all();
+		_decoder.join();
+	}
+}
+
+bool VideoChannel::init(const char* path) {
+	size_t length = strlen(path);
+	bool isY4M = length > 4 && strcmp(path + length - 4, ".y4m") == 0;
+	if(!(isY4M ? _reader.open(path) : _reader.openWithFFmpeg(path))) {
+		return false;
+	}
+	_frameRate = _reader.getFrameRate();
+	_seekable = _reader.isSeekable();
+	if(!_texture.create(_reader.getWidth(), _reader.getHeight())) {
+		return false;
+	}
+	labelGLObject(GL_TEXTURE, _texture.getTexture(), path);
+
+	_decoder = std::thread(&VideoChannel::decodeLoop, this);
+	return true;
+}
+
+void VideoChannel::decodeLoop() {
+	size_t frameSize = (size_t)_reader.getWidth() * _reader.getHeight() * 4;
+	uint64_t frameCount = _reader.getFrameCount();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(!_stop) {
+		if(_seekTo >= 0) {
+			_queue.clear();
+			_nextIndex = _seekTo;
+			_seekTo = -1;
+			int64_t index = _nextIndex;
+
+			// Outside the lock, a pipe restarts ffmpeg and decodes up to the frame
+			lock.unlock();
+			bool ok = frameCount > 0 ? _reader.seek(index % frameCount) : !_seekable && _reader.seek(index);
+			lock.lock();
+			if(_seekTo >= 0 || index != _nextIndex) continue;
+			_ended = !ok;
+			if(_ended) _wake.notify_all();
+		}
+		if(_queue.size() >= QUEUE_DEPTH || _ended) {
+			_wake.wait(lock);
+			continue;
+		}
+
+		std::vector<uint8_t> rgba;
+		if(!_free.empty()) {
+			rgba.swap(_free.back());
+			_free.pop_back();
+		}
+		rgba.resize(frameSize);
+		int64_t index = _nextIndex;
+
+		// Decode outside the lock
+		lock.unlock();
+		bool ok = _reader.readFrame(&rgba[0]);
+		if(!ok && _seekable && frameCount > 0 && _reader.seek(0)) {
+			// Loop
+			ok = _reader.readFrame(&rgba[0]);
+		}
+		lock.lock();
+
+		if(_seekTo >= 0 || index != _nextIndex) {
+			// Seeked while decoding, the frame is from the old position
+			_free.push_back(std::vector<uint8_t>());
+			_free.back().swap(rgba);
+			continue;
+		}
+		if(!ok) {
+			_ended = true;
+			_wake.notify_all();
+			continue;
+		}
+
+		_queue.push_back(Frame());
+		_queue.back().index = index;
+		_queue.back().rgba.swap(rgba);
+		++_nextIndex;
+		_wake.notify_all();
+	}
+}
+
+void VideoChannel::requestSeek(int64_t index) {
+	_seekTo = index;
+	_ended = false;
+	_wake.notify_all();
+}
+
+void VideoChannel::update(const FrameState& frame) {
+	int64_t wanted = channelFrameIndex(frame.time, _frameRate);
+	if(wanted == _shown) return;
+
+	Frame next;
+	next.index = -1;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		// Going back in time, or too far ahead for the decoder to catch up by dropping
+		bool behind = !_queue.empty() ? _queue.front().index > wanted : _nextIndex > wanted;
+		bool farAhead = wanted >= _nextIndex + (int64_t)QUEUE_DEPTH;
+		// Pipes only seek back, forward they catch up by dropping as seeking means decoding every frame anyway
+		if((behind || (farAhead && _seekable)) && _seekTo < 0) {
+			requestSeek(wanted);
+		}
+
+		while(true) {
+			// Drop frames that are late
+			while(!_queue.empty() && _queue.front().index < wanted) {
+				_free.push_back(std::vector<uint8_t>());
+				_free.back().swap(_queue.front().rgba);
+				_queue.pop_front();
+				_wake.notify_all();
+			}
+			if(!_queue.empty() && _queue.front().index == wanted) {
+				next.index = wanted;
+				next.rgba.swap(_queue.front().rgba);
+				_queue.pop_front();
+				_wake.notify_all();
+				break;
+			}
+			// Not decoded yet: hold the current frame, unless rendering offline
+			if(!_offline || _ended) break;
+			_wake.wait(lock);
+		}
+	}
+
+	if(next.index < 0) return;
+	_texture.upload(&next.rgba[0]);
+	_shown = next.index;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_free.push_back(std::vector<uint8_t>());
+	_free.back().swap(next.rgba);
+}
@@ -0,0 +1,195 @@
+#include "app.h"
+
+#include <math.h>
+#include <fstream>
+#include <sstream>
+
+/* Builds in flight per view (the drawn one and a newer one), plus room for files changing back */
+static const size_t PROGRAMS_PER_VIEW = 2;
+static const size_t SPARE_PROGRAMS = 8;
+
+bool ShadeApp::addView(const char* path) {
+	std::ifstream in(path, std::ios::binary);
+	if(!in) {
+		LOG_F(ERROR, "Couldn't open '%s'", path);
+		return false;
+	}
+
+	ShaderView* view = new ShaderView;
+	view->path = path;
+	fwatch::checkFileModified(path, &view->timestamp);
+	_views.push_back(view);
+	// Views touch their programs every frame, so with room for every build in flight none is evicted while drawn
+	_viewPrograms.setCapacity(_views.size() * PROGRAMS_PER_VIEW + SPARE_PROGRAMS);
+	loadView(*view);
+	_showViews = true;
+	return true;
+}
+
+int ShadeApp::addGallery(const char* dir) {
+	std::vector<std::string> files = fwatch::listFiles(dir, ".glsl");
+	int added = 0;
+	for(size_t i = 0; i < files.size(); ++i) {
+		if(addView(files[i].c_str())) ++added;
+	}
+	if(added == 0) {
+		LOG_F(ERROR, "No shaders in '%s'", dir);
+	}
+	return added;
+}
+
+/* Starts a build of the file's current source, the view keeps drawing its previous program meanwhile */
+void ShadeApp::loadView(ShaderView& view) {
+	std::ifstream in(view.path.c_str(), std::ios::binary);
+	if(!in) {
+		view.error = "Couldn't open '" + view.path + "'";
+		return;
+	}
+	std::ostringstream contents;
+	contents << in.rdbuf();
+
+	// Keyed by the source itself, so views of the same shader share a program
+	std::string source = moveBuiltinsToBlock(contents.str());
+	// Pinned, as hidden views don't touch their programs and saves keep adding entries
+	Permutation* pending = _viewPrograms.request(source, _builtinVertexShader, source);
+	_viewPrograms.pin(pending);
+	if(view.pending) _viewPrograms.unpin(view.pending);
+	view.pending = pending;
+}
+
+void ShadeApp::pollViewFiles() {
+	for(size_t i = 0; i < _views.size(); ++i) {
+		ShaderView& view = *_views[i];
+		if(fwatch::checkFileModified(view.path.c_str(), &view.timestamp)) {
+			loadView(view);
+		}
+	}
+}
+
+/* Swaps in the builds the driver has finished */
+void ShadeApp::updateViews() {
+	_viewPrograms.poll();
+	for(size_t i = 0; i < _views.size(); ++i) {
+		ShaderView& view = *_views[i];
+		if(!view.pending || view.pending->state == Permutation::COMPILING) continue;
+
+		if(view.pending->state == Permutation::READY) {
+			bindBuiltinBlock(*view.pending->program);
+			// The pending build's pin moves to current
+			if(view.current) _viewPrograms.unpin(view.current);
+			view.current = view.pending;
+			_tileScheduler.invalidate(i);
+			view.error.clear();
+		} else {
+			LOG_F(ERROR, "%s: %s", view.path.c_str(), view.pending->error.c_str());
+			view.error = view.pending->error;
+			_viewPrograms.unpin(view.pending);
+		}
+		view.pending = nullptr;
+	}
+}
+
+/* Tile of a view in render pixels, x and y from the bottom left, then width and height; views fill rows from the top */
+void ShadeApp::getViewRect(size_t index, int rect[4]) const {
+	int count = (int)_views.size();
+	int columns = (int)ceil(sqrt((double)count));
+	int rows = (count + columns - 1) / columns;
+	int column = (int)index % columns;
+	int row = (int)index / columns;
+
+	int left = column * _windowWidth / columns;
+	int right = (column + 1) * _windowWidth / columns;
+	int top = row * _windowHeight / rows;
+	int bottom = (row + 1) * _windowHeight / rows;
+	rect[0] = left;
+	rect[1] = _windowHeight - bottom;
+	rect[2] = right - left;
+	rect[3] = bottom - top;
+}
+
+/* Moves a position of ShaderToy's iMouse, whose sign carries the button state and 0 means no click yet */
+static float offsetClick(float value, float origin) {
+	if(value == 0.0f) return 0.0f;
+	return value < 0.0f ? -(-value - origin) : value - origin;
+}
+
+void ShadeApp::drawViews(const FrameState& frame) {
+	updateViews();
+
+	// Only the tiles that fit in the GPU budget are redrawn, the others show their last frame
+	_tileScheduler.schedule(_views.size(), _scheduledTiles);
+	std::vector<bool> scheduled(_views.size(), false);
+	for(size_t i = 0; i < _scheduledTiles.size(); ++i) {
+		scheduled[_scheduledTiles[i]] = true;
+	}
+
+	// One upload of every view's built-ins, each draw binds its own range
+	std::vector<FrameState> frames(_views.size(), frame);
+	for(size_t i = 0; i < _views.size(); ++i) {
+		const ShaderView& view = *_views[i];
+		int rect[4];
+		getViewRect(i, rect);
+		FrameState& viewFrame = frames[i];
+		viewFrame.resolution[0] = (float)rect[2];
+		viewFrame.resolution[1] = (float)rect[3];
+		viewFrame.frame = view.drawCount;
+		viewFrame.timeDelta = view.drawCount > 0 ? (float)(frame.time - view.lastDrawTime) : 0.0f;
+		// The cursor is y down from the top of the render, iMouse y up
+		viewFrame.mouse[0] = frame.mouse[0] - rect[0];
+		viewFrame.mouse[1] = frame.mouse[1] - (_windowHeight - rect[1] - rect[3]);
+		for(int c = 0; c < 4; ++c) {
+			viewFrame.clickMouse[c] = offsetClick(frame.clickMouse[c], (float)rect[c % 2]);
+		}
+	}
+	_viewBlock.update(frames);
+
+	for(size_t i = 0; i < _views.size(); ++i) {
+		ShaderView& view = *_views[i];
+		if(view.current) _viewPrograms.touch(view.current);
+		if(view.pending) _viewPrograms.touch(view.pending);
+
+		int rect[4];
+		getViewRect(i, rect);
+		if(rect[2] <= 0 || rect[3] <= 0) continue;
+		if(view.target.getWidth() != rect[2] || view.target.getHeight() != rect[3]) {
+			// Starts out black, after a resize tiles are redrawn in turn rather than all at once
+			if(!view.target.create(rect[2], rect[3])) continue;
+			view.target.setLabel(view.path);
+			view.target.bind();
+			CHECK_GL(glClear(GL_COLOR_BUFFER_BIT));
+		}
+
+		if(scheduled[i]) {
+			GLDebugGroup group(view.path);
+			view.target.bind();
+			CHECK_GL(glClear(GL_COLOR_BUFFER_BIT));
+			if(view.current) {
+				_tileScheduler.beginTile(i);
+				view.current->program->use();
+				// Sets what isn't in the block, and everything for GLSL older than 1.40
+				view.current->builtins.set(frames[i]);
+				_viewBlock.bind(i);
+				drawQuad();
+				_tileScheduler.endTile(i);
+				view.lastDrawTime = frame.time;
+				++view.drawCount;
+			}
+		}
+
+		CHECK_GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, view.target.getFramebuffer()));
+		CHECK_GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+		CHECK_GL(glBlitFramebuffer(0, 0, rect[2], rect[3], rect[0], rect[1], rect[0] + rect[2], rect[1] + rect[3], GL_COLOR_BUFFER_BIT, GL_NEAREST));
+	}
+	RenderTarget::unbind();
+}
+
+void ShadeApp::clearViews() {
+	for(size_t i = 0; i < _views.size(); ++i) {
+		delete _views[i];
+	}
+	_views.clear();
+	_viewPrograms.clear();
+	_viewBlock.destroy();
+	_tileScheduler.destroy();
+	_showViews = false;
+}
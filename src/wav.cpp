@@ -0,0 +1,191 @@
+#include "wav.h"
+
+#include <string.h>
+#include <vector>
+#include <loguru/loguru.hpp>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+static const uint16_t WAVE_FORMAT_PCM = 1;
+static const uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+static const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+static uint16_t readU16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool WavReader::open(const char* path) {
+	close();
+	_file = fopen(path, "rb");
+	if(!_file) {
+		LOG_F(ERROR, "Couldn't open '%s'", path);
+		return false;
+	}
+
+	uint8_t riff[12];
+	if(fread(riff, sizeof(riff), 1, _file) != 1 || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+		LOG_F(ERROR, "'%s' isn't a WAV file", path);
+		close();
+		return false;
+	}
+
+	// Walk the chunks for the format and the start of the samples
+	bool haveFormat = false;
+	uint16_t format = 0;
+	uint8_t chunk[8];
+	while(fread(chunk, sizeof(chunk), 1, _file) == 1) {
+		uint32_t size = readU32(chunk + 4);
+		if(memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+			std::vector<uint8_t> fmt(size);
+			if(fread(&fmt[0], size, 1, _file) != 1) break;
+			format = readU16(&fmt[0]);
+			_channels = readU16(&fmt[2]);
+			_sampleRate = (int)readU32(&fmt[4]);
+			_bitsPerSample = readU16(&fmt[14]);
+			if(format == WAVE_FORMAT_EXTENSIBLE && size >= 26) {
+				format = readU16(&fmt[24]);
+			}
+			haveFormat = true;
+		} else if(memcmp(chunk, "data", 4) == 0) {
+			_dataOffset = ftell(_file);
+			if(haveFormat && _channels > 0 && _bitsPerSample >= 8) {
+				_frameCount = size / (_channels * (_bitsPerSample / 8));
+			}
+			break;
+		} else if(fseek(_file, size + (size & 1), SEEK_CUR) != 0) {
+			break;
+		}
+	}
+
+	_isFloat = format == WAVE_FORMAT_IEEE_FLOAT;
+	bool supported = (format == WAVE_FORMAT_PCM && (_bitsPerSample == 8 || _bitsPerSample == 16 || _bitsPerSample == 24 || _bitsPerSample == 32)) ||
+	                 (_isFloat && _bitsPerSample == 32);
+	if(!haveFormat || !_dataOffset || !supported || _sampleRate <= 0) {
+		LOG_F(ERROR, "'%s' has no samples in a supported format (PCM 8/16/24/32 bit or 32 bit float)", path);
+		close();
+		return false;
+	}
+
+	LOG_F(INFO, "Opened '%s': %d Hz, %d channels, %d bit, %.1f s", path, _sampleRate, _channels, _bitsPerSample,
+		(double)_frameCount / _sampleRate);
+	return true;
+}
+
+void WavReader::close() {
+	if(_file) {
+		fclose(_file);
+		_file = NULL;
+	}
+	_dataOffset = 0;
+	_frameCount = 0;
+}
+
+size_t WavReader::read(uint64_t frame, float* mono, size_t count) {
+	if(!_file || frame >= _frameCount) return 0;
+	if(count > _frameCount - frame) count = (size_t)(_frameCount - frame);
+
+	int bytesPerSample = _bitsPerSample / 8;
+	size_t frameSize = bytesPerSample * _channels;
+	if(fseek(_file, _dataOffset + (long)(frame * frameSize), SEEK_SET) != 0) return 0;
+
+	std::vector<uint8_t> data(count * frameSize);
+	count = fread(&data[0], frameSize, count, _file);
+
+	float scale = 1.0f / _channels;
+	const uint8_t* p = &data[0];
+	for(size_t i = 0; i < count; ++i) {
+		float sum = 0.0f;
+		for(int c = 0; c < _channels; ++c, p += bytesPerSample) {
+			if(_isFloat) {
+				float f;
+				memcpy(&f, p, sizeof(f));
+				sum += f;
+			} else switch(bytesPerSample) {
+			case 1: sum += (p[0] - 128) / 128.0f; break;
+			case 2: sum += (int16_t)readU16(p) / 32768.0f; break;
+			case 3: sum += (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) / 2147483648.0f; break;
+			case 4: sum += (int32_t)readU32(p) / 2147483648.0f; break;
+			}
+		}
+		mono[i] = sum * scale;
+	}
+	return count;
+}
+
+static void writeU16(uint8_t* p, uint16_t v) {
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+static void writeU32(uint8_t* p, uint32_t v) {
+	writeU16(p, v & 0xFFFF);
+	writeU16(p + 2, v >> 16);
+}
+
+bool WavWriter::open(const char* path, int sampleRate, uint64_t frameCount) {
+	close();
+	if(strcmp(path, "-") == 0) {
+#if defined(_WIN32)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		_file = stdout;
+	} else {
+		_file = fopen(path, "wb");
+	}
+	if(!_file) {
+		LOG_F(ERROR, "Couldn't open '%s' for writing", path);
+		return false;
+	}
+
+	const int channels = 2, bytesPerSample = 2;
+	uint64_t dataSize = frameCount * channels * bytesPerSample;
+	if(dataSize > 0xFFFFFFFFull - 36) dataSize = 0xFFFFFFFFull - 36;
+
+	uint8_t header[44];
+	memcpy(header, "RIFF", 4);
+	writeU32(header + 4, (uint32_t)(36 + dataSize));
+	memcpy(header + 8, "WAVEfmt ", 8);
+	writeU32(header + 16, 16);
+	writeU16(header + 20, WAVE_FORMAT_PCM);
+	writeU16(header + 22, channels);
+	writeU32(header + 24, sampleRate);
+	writeU32(header + 28, sampleRate * channels * bytesPerSample);
+	writeU16(header + 32, channels * bytesPerSample);
+	writeU16(header + 34, bytesPerSample * 8);
+	memcpy(header + 36, "data", 4);
+	writeU32(header + 40, (uint32_t)dataSize);
+	_frames = 0;
+	return fwrite(header, sizeof(header), 1, _file) == 1;
+}
+
+void WavWriter::close() {
+	if(!_file) return;
+	if(_file == stdout) {
+		fflush(_file);
+	} else {
+		fclose(_file);
+	}
+	_file = NULL;
+}
+
+bool WavWriter::write(const float* stereo, size_t count) {
+	if(!_file) return false;
+	_buffer.resize(count * 2);
+	for(size_t i = 0; i < count * 2; ++i) {
+		float v = stereo[i];
+		v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+		int16_t sample = (int16_t)(v * 32767.0f);
+		// WAV is little endian
+		uint8_t* p = (uint8_t*)&_buffer[i];
+		writeU16(p, (uint16_t)sample);
+	}
+	_frames += count;
+	return fwrite(&_buffer[0], sizeof(int16_t), _buffer.size(), _file) == _buffer.size();
+}
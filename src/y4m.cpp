@@ -0,0 +1,238 @@
+#include "y4m.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <loguru/loguru.hpp>
+
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#else
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+bool Y4MReader::open(const char* path) {
+	close();
+	_file = fopen(path, "rb");
+	if(!_file) {
+		LOG_F(ERROR, "Couldn't open '%s'", path);
+		return false;
+	}
+	_pipe = false;
+	_path = path;
+	if(!readHeader(path)) return false;
+
+	// Frames are "FRAME\n" and fixed size data when the stream has no per-frame parameters
+	fseek(_file, 0, SEEK_END);
+	long size = ftell(_file);
+	_frameCount = (size - _dataOffset) / (6 + frameDataSize());
+	fseek(_file, _dataOffset, SEEK_SET);
+	return true;
+}
+
+#if defined(_WIN32)
+
+bool Y4MReader::openWithFFmpeg(const char* path) {
+	close();
+	// cmd.exe has no way to escape a quote inside a quoted argument
+	if(strchr(path, '"')) {
+		LOG_F(ERROR, "Can't pass '%s' to ffmpeg", path);
+		return false;
+	}
+	std::string command = std::string("ffmpeg -loglevel error -nostdin -i \"") + path + "\" -f yuv4mpegpipe -pix_fmt yuv420p -";
+	_file = popen(command.c_str(), "rb");
+	if(!_file) {
+		LOG_F(ERROR, "Couldn't run '%s'", command.c_str());
+		return false;
+	}
+	_pipe = true;
+	_path = path;
+	return readHeader(path);
+}
+
+#else
+
+bool Y4MReader::openWithFFmpeg(const char* path) {
+	close();
+	int fds[2];
+	if(pipe(fds) != 0) {
+		LOG_F(ERROR, "Couldn't create a pipe for ffmpeg");
+		return false;
+	}
+	// Other children, like the ffmpeg of another channel, mustn't hold the pipe open; dup2 clears this for stdout
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+	// No shell in between, so the path is passed as is whatever characters it has
+	const char* argv[] = { "ffmpeg", "-loglevel", "error", "-nostdin", "-i", path, "-f", "yuv4mpegpipe", "-pix_fmt", "yuv420p", "-", NULL };
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+	posix_spawn_file_actions_addclose(&actions, fds[0]);
+	posix_spawn_file_actions_addclose(&actions, fds[1]);
+	pid_t pid;
+	int error = posix_spawnp(&pid, argv[0], &actions, NULL, const_cast<char**>(argv), environ);
+	posix_spawn_file_actions_destroy(&actions);
+	::close(fds[1]);
+	if(error != 0) {
+		LOG_F(ERROR, "Couldn't run ffmpeg: %s", strerror(error));
+		::close(fds[0]);
+		return false;
+	}
+
+	_ffmpeg = pid;
+	_file = fdopen(fds[0], "rb");
+	if(!_file) {
+		::close(fds[0]);
+		close();
+		return false;
+	}
+	_pipe = true;
+	_path = path;
+	return readHeader(path);
+}
+
+#endif
+
+void Y4MReader::close() {
+	if(_file) {
+#if defined(_WIN32)
+		if(_pipe) pclose(_file);
+		else fclose(_file);
+#else
+		fclose(_file);
+#endif
+		_file = NULL;
+	}
+#if !defined(_WIN32)
+	// ffmpeg exits on a broken pipe if it wasn't done
+	if(_ffmpeg > 0) {
+		waitpid(_ffmpeg, NULL, 0);
+		_ffmpeg = 0;
+	}
+#endif
+	_frameCount = 0;
+	_position = 0;
+}
+
+bool Y4MReader::readHeader(const char* path) {
+	char line[256];
+	if(!fgets(line, sizeof(line), _file) || strncmp(line, "YUV4MPEG2 ", 10) != 0) {
+		LOG_F(ERROR, "'%s' isn't a YUV4MPEG2 stream", path);
+		close();
+		return false;
+	}
+
+	_fpsNum = 25;
+	_fpsDen = 1;
+	_chroma = CHROMA_420;
+	for(char* p = strtok(line + 10, " \n"); p; p = strtok(NULL, " \n")) {
+		switch(p[0]) {
+		case 'W': _width = atoi(p + 1); break;
+		case 'H': _height = atoi(p + 1); break;
+		case 'F': sscanf(p + 1, "%d:%d", &_fpsNum, &_fpsDen); break;
+		case 'C':
+			if(strncmp(p + 1, "420", 3) == 0) _chroma = CHROMA_420;
+			else if(strcmp(p + 1, "422") == 0) _chroma = CHROMA_422;
+			else if(strcmp(p + 1, "444") == 0) _chroma = CHROMA_444;
+			else if(strcmp(p + 1, "mono") == 0) _chroma = CHROMA_MONO;
+			else {
+				LOG_F(ERROR, "'%s' uses unsupported colorspace %s", path, p + 1);
+				close();
+				return false;
+			}
+			break;
+		}
+	}
+	if(_width <= 0 || _height <= 0 || _fpsNum <= 0 || _fpsDen <= 0) {
+		LOG_F(ERROR, "'%s' has an invalid header", path);
+		close();
+		return false;
+	}
+	_dataOffset = _pipe ? 0 : ftell(_file);
+	_yuv.resize(frameDataSize());
+
+	LOG_F(INFO, "Opened video '%s': %dx%d at %.2f fps", path, _width, _height, getFrameRate());
+	return true;
+}
+
+size_t Y4MReader::frameDataSize() const {
+	size_t luma = (size_t)_width * _height;
+	switch(_chroma) {
+	case CHROMA_420: return luma + 2 * (((_width + 1) / 2) * (size_t)((_height + 1) / 2));
+	case CHROMA_422: return luma + 2 * (((_width + 1) / 2) * (size_t)_height);
+	case CHROMA_444: return luma * 3;
+	default: return luma;
+	}
+}
+
+bool Y4MReader::seek(uint64_t frame) {
+	if(!_file) return false;
+	if(!_pipe) {
+		if(frame >= _frameCount || fseek(_file, _dataOffset + (long)(frame * (6 + frameDataSize())), SEEK_SET) != 0) return false;
+		_position = frame;
+		return true;
+	}
+
+	if(frame < _position) {
+		std::string path = _path;
+		if(!openWithFFmpeg(path.c_str())) return false;
+	}
+	while(_position < frame) {
+		if(!readFrameData()) return false;
+	}
+	return true;
+}
+
+static inline uint8_t clampByte(int v) {
+	return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+bool Y4MReader::readFrameData() {
+	if(!_file) return false;
+
+	char line[256];
+	if(!fgets(line, sizeof(line), _file) || strncmp(line, "FRAME", 5) != 0) return false;
+	if(fread(&_yuv[0], 1, _yuv.size(), _file) != _yuv.size()) return false;
+	++_position;
+	return true;
+}
+
+bool Y4MReader::readFrame(uint8_t* rgba) {
+	if(!readFrameData()) return false;
+
+	int chromaWidth = _chroma == CHROMA_444 ? _width : (_width + 1) / 2;
+	int chromaHeight = _chroma == CHROMA_420 ? (_height + 1) / 2 : _height;
+	const uint8_t* yPlane = &_yuv[0];
+	const uint8_t* uPlane = yPlane + (size_t)_width * _height;
+	const uint8_t* vPlane = uPlane + (size_t)chromaWidth * chromaHeight;
+
+	for(int y = 0; y < _height; ++y) {
+		// Flip so the first row of the image ends up at the top of the texture
+		uint8_t* out = rgba + (size_t)(_height - 1 - y) * _width * 4;
+		const uint8_t* yRow = yPlane + (size_t)y * _width;
+		int cy = _chroma == CHROMA_420 ? y / 2 : y;
+		const uint8_t* uRow = uPlane + (size_t)cy * chromaWidth;
+		const uint8_t* vRow = vPlane + (size_t)cy * chromaWidth;
+
+		for(int x = 0; x < _width; ++x, out += 4) {
+			// BT.601 limited range in 16.16 fixed point
+			int c = 76309 * (yRow[x] - 16);
+			int d = 0, e = 0;
+			if(_chroma != CHROMA_MONO) {
+				int cx = _chroma == CHROMA_444 ? x : x / 2;
+				d = uRow[cx] - 128;
+				e = vRow[cx] - 128;
+			}
+			out[0] = clampByte((c + 104597 * e + 32768) >> 16);
+			out[1] = clampByte((c - 25675 * d - 53279 * e + 32768) >> 16);
+			out[2] = clampByte((c + 132201 * d + 32768) >> 16);
+			out[3] = 255;
+		}
+	}
+	return true;
+}
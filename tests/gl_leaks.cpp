@@ -0,0 +1,204 @@
+/**
+ * GL object leak stress test.
+ *
+ * Reloads shaders thousands of times in one process, cycling through a
+ * valid shader, a compile error, a link error, a shader with parameters and
+ * a ShaderToy project with buffer passes, and now and then exports frames.
+ * After a warm-up cycle the live GL objects counted by gl_objects.h must
+ * stay the same at the end of every cycle, and nothing may be deleted
+ * twice.  Needs a build with TRACK_GL_OBJECTS, which debug builds have.
+ *
+ * Runs on Mesa's llvmpipe, under xvfb-run when there is no display.
+ */
+
+#include "app.h"
+#include "gl_objects.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+static const int CYCLES = 500;
+static const int EXPORT_INTERVAL = 50;
+
+static const char* VALID_SHADER =
+	"#version 330\n"
+	"uniform float iTime;\n"
+	"in vec2 Frag_UV;\n"
+	"layout(location = 0) out vec4 Out_Color;\n"
+	"void main() {\n"
+	"	Out_Color = vec4(Frag_UV, 0.5 + 0.5 * sin(iTime), 1.0);\n"
+	"}\n";
+
+static const char* COMPILE_ERROR_SHADER =
+	"#version 330\n"
+	"in vec2 Frag_UV;\n"
+	"layout(location = 0) out vec4 Out_Color;\n"
+	"void main() {\n"
+	"	Out_Color = vec4(Frag_UV, undeclared, 1.0);\n"
+	"}\n";
+
+// Compiles, but the built-in vertex shader doesn't write the input
+static const char* LINK_ERROR_SHADER =
+	"#version 330\n"
+	"in vec3 Frag_Missing;\n"
+	"layout(location = 0) out vec4 Out_Color;\n"
+	"void main() {\n"
+	"	Out_Color = vec4(Frag_Missing, 1.0);\n"
+	"}\n";
+
+static const char* PARAMETERS_SHADER =
+	"#version 330\n"
+	"uniform float iTime;\n"
+	"uniform float speed = 5.0; // range(0.0, 20.0)\n"
+	"uniform vec3 tint = vec3(1.0, 0.4, 0.1); // color\n"
+	"in vec2 Frag_UV;\n"
+	"layout(location = 0) out vec4 Out_Color;\n"
+	"void main() {\n"
+	"	Out_Color = vec4(tint * fract(Frag_UV.x + iTime * speed), 1.0);\n"
+	"}\n";
+
+// Buffer A feeds back into itself and into the image
+static const char* PROJECT =
+	"{ \"Shader\": { \"renderpass\": [\n"
+	"  { \"name\": \"Buffer A\", \"type\": \"buffer\",\n"
+	"    \"inputs\": [ { \"id\": \"a\", \"channel\": 0, \"type\": \"buffer\" } ],\n"
+	"    \"outputs\": [ { \"id\": \"a\", \"channel\": 0 } ],\n"
+	"    \"code\": \"void mainImage(out vec4 c, in vec2 p) { c = 0.9 * texture(iChannel0, p / iResolution.xy) + 0.1 * vec4(sin(iTime)); }\" },\n"
+	"  { \"name\": \"Buffer B\", \"type\": \"buffer\",\n"
+	"    \"inputs\": [ { \"id\": \"a\", \"channel\": 0, \"type\": \"buffer\" } ],\n"
+	"    \"outputs\": [ { \"id\": \"b\", \"channel\": 0 } ],\n"
+	"    \"code\": \"void mainImage(out vec4 c, in vec2 p) { c = texture(iChannel0, p / iResolution.xy).yzxw; }\" },\n"
+	"  { \"name\": \"Image\", \"type\": \"image\",\n"
+	"    \"inputs\": [ { \"id\": \"a\", \"channel\": 0, \"type\": \"buffer\" }, { \"id\": \"b\", \"channel\": 1, \"type\": \"buffer\" } ],\n"
+	"    \"outputs\": [ { \"id\": \"image\", \"channel\": 0 } ],\n"
+	"    \"code\": \"void mainImage(out vec4 c, in vec2 p) { vec2 uv = p / iResolution.xy; c = texture(iChannel0, uv) + texture(iChannel1, uv); }\" }\n"
+	"] } }\n";
+
+struct Variant {
+	const char* file;
+	const char* source;
+	bool exportable;
+};
+
+static bool writeFile(const std::string& path, const char* contents) {
+	std::ofstream out(path.c_str());
+	out << contents;
+	return out.good();
+}
+
+/* Re-runs the test under a virtual display when there is none */
+static void ensureDisplay() {
+	if(getenv("DISPLAY") || getenv("WAYLAND_DISPLAY") || getenv("SHADE_TEST_XVFB")) return;
+	if(system("command -v xvfb-run >/dev/null 2>&1") != 0) return;
+	setenv("SHADE_TEST_XVFB", "1", 1);
+	execlp("xvfb-run", "xvfb-run", "-a", "/proc/self/exe", (char*)NULL);
+	perror("xvfb-run");
+}
+
+static void countLiveObjects(std::vector<int>& counts) {
+	counts.resize(GL_OBJECT_TYPE_COUNT);
+	for(int type = 0; type < GL_OBJECT_TYPE_COUNT; ++type) {
+		counts[type] = getLiveGLObjects((GLObjectType)type);
+	}
+}
+
+int main() {
+#if !TRACK_GL_OBJECTS
+	printf("GL objects aren't tracked in this build (NDEBUG), nothing to check\n");
+	return EXIT_SUCCESS;
+#else
+	setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+	setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+	ensureDisplay();
+	// Expected compile and link errors would flood the output
+	loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+
+	char dirTemplate[] = "/tmp/shade_gl_leaksXXXXXX";
+	if(!mkdtemp(dirTemplate)) {
+		perror("mkdtemp");
+		return EXIT_FAILURE;
+	}
+	std::string dir = dirTemplate;
+
+	Variant variants[] = {
+		{ "valid.glsl", VALID_SHADER, true },
+		{ "compile_error.glsl", COMPILE_ERROR_SHADER, false },
+		{ "link_error.glsl", LINK_ERROR_SHADER, false },
+		{ "parameters.glsl", PARAMETERS_SHADER, true },
+		{ "project.json", PROJECT, true }
+	};
+	const int variantCount = sizeof(variants) / sizeof(variants[0]);
+	// loadFragmentShader() keeps the path, so the strings must outlive the app
+	std::vector<std::string> paths;
+	for(int v = 0; v < variantCount; ++v) {
+		paths.push_back(dir + "/" + variants[v].file);
+		if(!writeFile(paths.back(), variants[v].source)) {
+			fprintf(stderr, "Couldn't write '%s'\n", paths.back().c_str());
+			return EXIT_FAILURE;
+		}
+	}
+
+	ShadeApp app;
+	if(!app.init("gl_leaks", 64, 64, true)) {
+		fprintf(stderr, "Couldn't create a GL context\n");
+		return EXIT_FAILURE;
+	}
+
+	ExportSettings exportSettings;
+	exportSettings.fps = 60;
+	exportSettings.frames.push_back(0);
+	exportSettings.frames.push_back(1);
+	exportSettings.outDir = dir + "/frames";
+
+	std::vector<int> baseline, counts;
+	int failures = 0;
+	for(int cycle = 0; cycle < CYCLES && failures == 0; ++cycle) {
+		for(int v = 0; v < variantCount; ++v) {
+			app.loadFragmentShader(paths[v].c_str());
+			if(variants[v].exportable && cycle % EXPORT_INTERVAL == 0) {
+				app.exportFrames(exportSettings);
+			}
+		}
+
+		// The first cycle creates what's kept for the app's lifetime (eg. export targets)
+		countLiveObjects(counts);
+		if(cycle == 0) {
+			baseline = counts;
+			continue;
+		}
+		for(int type = 0; type < GL_OBJECT_TYPE_COUNT; ++type) {
+			if(counts[type] != baseline[type]) {
+				fprintf(stderr, "Cycle %d: %d live %s objects, %d after the first cycle\n", cycle, counts[type],
+					getGLObjectTypeName((GLObjectType)type), baseline[type]);
+				++failures;
+			}
+		}
+	}
+
+	if(getStaleGLDeletes() != 0) {
+		fprintf(stderr, "%d deletes of objects that weren't live\n", getStaleGLDeletes());
+		++failures;
+	}
+	if(failures != 0) {
+		loguru::g_stderr_verbosity = loguru::Verbosity_INFO;
+		logLiveGLObjects(true);
+	}
+
+	printf("%d reloads, live objects:", CYCLES * variantCount);
+	for(int type = 0; type < GL_OBJECT_TYPE_COUNT; ++type) {
+		printf(" %d %s%s", counts[type], getGLObjectTypeName((GLObjectType)type), type + 1 < GL_OBJECT_TYPE_COUNT ? "," : "\n");
+	}
+
+	std::string cleanup = "rm -rf '" + dir + "'";
+	if(system(cleanup.c_str()) != 0) {
+		fprintf(stderr, "Couldn't remove '%s'\n", dir.c_str());
+	}
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+#endif
+}
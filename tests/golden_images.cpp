@@ -0,0 +1,305 @@
+/**
+ * Golden-image regression test.
+ *
+ * Renders every image shader in examples/ headlessly with the shade
+ * executable, at a fixed size and time, and compares the frame against
+ * tests/golden/<name>.png.  A frame fails if its PSNR or SSIM drops below a
+ * threshold or a channel differs by more than MAX_CHANNEL_DIFF; the frame
+ * and an amplified difference image are then written to golden_output/.
+ *
+ * Rendering is forced onto Mesa's llvmpipe (LIBGL_ALWAYS_SOFTWARE) so the
+ * results don't depend on the GPU, and runs under xvfb-run when there is no
+ * display.  Set SHADE_UPDATE_GOLDENS=1 to replace the goldens with the
+ * current output after an intended change.
+ */
+
+// stb is implemented in shade_core
+#include <stb/stb_image.h>
+#include <stb/stb_image_write.h>
+
+#include <dirent.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const int WIDTH = 128;
+static const int HEIGHT = 96;
+static const int FRAME = 30;
+
+static const double MIN_PSNR = 40.0;
+static const double MIN_SSIM = 0.98;
+static const int MAX_CHANNEL_DIFF = 8;
+
+struct ImageDiff {
+	double psnr;
+	double ssim;
+	int maxDiff;
+};
+
+/* Sum of squared differences and largest difference of the RGB channels of RGBA8 pixels */
+static void compareChannels(const uint8_t* a, const uint8_t* b, size_t pixels, uint64_t& sumSquares, int& maxDiff) {
+	sumSquares = 0;
+	maxDiff = 0;
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	// Alpha is the high byte of each little-endian pixel
+	const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+	__m128i maxv = zero;
+	while(i + 4 <= pixels) {
+		// Each round adds at most 2 * 2 * 255^2 per 32-bit lane, flush well before it overflows
+		__m128i acc = zero;
+		size_t end = std::min(pixels, i + 4 * 4096);
+		for(; i + 4 <= end; i += 4) {
+			__m128i va = _mm_loadu_si128((const __m128i*)(a + i * 4));
+			__m128i vb = _mm_loadu_si128((const __m128i*)(b + i * 4));
+			__m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+			d = _mm_and_si128(d, rgbMask);
+			maxv = _mm_max_epu8(maxv, d);
+			__m128i lo = _mm_unpacklo_epi8(d, zero);
+			__m128i hi = _mm_unpackhi_epi8(d, zero);
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(lo, lo));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(hi, hi));
+		}
+		uint32_t lanes[4];
+		_mm_storeu_si128((__m128i*)lanes, acc);
+		sumSquares += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+	uint8_t maxBytes[16];
+	_mm_storeu_si128((__m128i*)maxBytes, maxv);
+	for(int k = 0; k < 16; ++k) {
+		maxDiff = std::max(maxDiff, (int)maxBytes[k]);
+	}
+#endif
+	for(; i < pixels; ++i) {
+		for(int c = 0; c < 3; ++c) {
+			int d = abs((int)a[i * 4 + c] - (int)b[i * 4 + c]);
+			sumSquares += d * d;
+			maxDiff = std::max(maxDiff, d);
+		}
+	}
+}
+
+/* Rec. 601 luma of RGBA8 pixels, in 8 bits */
+static void toLuma(const uint8_t* rgba, size_t pixels, std::vector<uint8_t>& luma) {
+	luma.resize(pixels);
+	for(size_t i = 0; i < pixels; ++i) {
+		luma[i] = (uint8_t)((77 * rgba[i * 4] + 150 * rgba[i * 4 + 1] + 29 * rgba[i * 4 + 2] + 128) >> 8);
+	}
+}
+
+/* Sums of x, y, x^2, y^2 and xy over an 8x8 block of two luma images */
+static void blockSums(const uint8_t* x, const uint8_t* y, int stride, int64_t sums[5]) {
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi16(1);
+	__m128i sx = zero, sy = zero, sxx = zero, syy = zero, sxy = zero;
+	for(int row = 0; row < 8; ++row) {
+		__m128i vx = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(x + row * stride)), zero);
+		__m128i vy = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(y + row * stride)), zero);
+		sx = _mm_add_epi32(sx, _mm_madd_epi16(vx, ones));
+		sy = _mm_add_epi32(sy, _mm_madd_epi16(vy, ones));
+		sxx = _mm_add_epi32(sxx, _mm_madd_epi16(vx, vx));
+		syy = _mm_add_epi32(syy, _mm_madd_epi16(vy, vy));
+		sxy = _mm_add_epi32(sxy, _mm_madd_epi16(vx, vy));
+	}
+	__m128i all[5] = { sx, sy, sxx, syy, sxy };
+	for(int s = 0; s < 5; ++s) {
+		int32_t lanes[4];
+		_mm_storeu_si128((__m128i*)lanes, all[s]);
+		sums[s] = (int64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+#else
+	memset(sums, 0, 5 * sizeof(int64_t));
+	for(int row = 0; row < 8; ++row) {
+		for(int col = 0; col < 8; ++col) {
+			int vx = x[row * stride + col], vy = y[row * stride + col];
+			sums[0] += vx;
+			sums[1] += vy;
+			sums[2] += vx * vx;
+			sums[3] += vy * vy;
+			sums[4] += vx * vy;
+		}
+	}
+#endif
+}
+
+/* Mean SSIM of the luma over 8x8 blocks (a partial block at the edges is left out) */
+static double structuralSimilarity(const uint8_t* a, const uint8_t* b, int width, int height) {
+	std::vector<uint8_t> x, y;
+	toLuma(a, (size_t)width * height, x);
+	toLuma(b, (size_t)width * height, y);
+
+	const double c1 = (0.01 * 255) * (0.01 * 255);
+	const double c2 = (0.03 * 255) * (0.03 * 255);
+	double total = 0.0;
+	int blocks = 0;
+	for(int by = 0; by + 8 <= height; by += 8) {
+		for(int bx = 0; bx + 8 <= width; bx += 8) {
+			int64_t sums[5];
+			blockSums(&x[by * width + bx], &y[by * width + bx], width, sums);
+			double n = 64.0;
+			double mx = sums[0] / n, my = sums[1] / n;
+			double vx = sums[2] / n - mx * mx, vy = sums[3] / n - my * my;
+			double cov = sums[4] / n - mx * my;
+			total += ((2 * mx * my + c1) * (2 * cov + c2)) / ((mx * mx + my * my + c1) * (vx + vy + c2));
+			++blocks;
+		}
+	}
+	return blocks > 0 ? total / blocks : 1.0;
+}
+
+static ImageDiff compareImages(const uint8_t* a, const uint8_t* b, int width, int height) {
+	ImageDiff diff;
+	uint64_t sumSquares;
+	compareChannels(a, b, (size_t)width * height, sumSquares, diff.maxDiff);
+	double mse = (double)sumSquares / ((double)width * height * 3);
+	diff.psnr = mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+	diff.ssim = structuralSimilarity(a, b, width, height);
+	return diff;
+}
+
+/* Absolute differences amplified 8x, so single-step errors are visible */
+static bool writeDiffImage(const std::string& path, const uint8_t* a, const uint8_t* b, int width, int height) {
+	std::vector<uint8_t> pixels((size_t)width * height * 4);
+	for(size_t i = 0; i < pixels.size(); ++i) {
+		int d = (i % 4 == 3) ? 255 : abs((int)a[i] - (int)b[i]) * 8;
+		pixels[i] = (uint8_t)std::min(d, 255);
+	}
+	return stbi_write_png(path.c_str(), width, height, 4, &pixels[0], width * 4) != 0;
+}
+
+static bool readFile(const std::string& path, std::string& contents) {
+	std::ifstream in(path.c_str(), std::ios::binary);
+	if(!in) return false;
+	std::stringstream buffer;
+	buffer << in.rdbuf();
+	contents = buffer.str();
+	return true;
+}
+
+static bool copyFile(const std::string& from, const std::string& to) {
+	std::string contents;
+	if(!readFile(from, contents)) return false;
+	std::ofstream out(to.c_str(), std::ios::binary);
+	out << contents;
+	return (bool)out;
+}
+
+/* Example shaders that draw an image, sound shaders are left out */
+static std::vector<std::string> listImageShaders(const std::string& dir) {
+	std::vector<std::string> names;
+	DIR* d = opendir(dir.c_str());
+	if(!d) return names;
+	struct dirent* entry;
+	while((entry = readdir(d)) != NULL) {
+		std::string name = entry->d_name;
+		if(name.size() < 6 || name.compare(name.size() - 5, 5, ".glsl") != 0) continue;
+		std::string source;
+		if(readFile(dir + "/" + name, source) && source.find("mainSound") == std::string::npos) {
+			names.push_back(name.substr(0, name.size() - 5));
+		}
+	}
+	closedir(d);
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+/* Inputs an example needs to draw something worth comparing, eg. keys held for the keyboard channel */
+static std::string extraArguments(const std::string& name, const std::string& goldens) {
+	if(name == "keyboard") {
+		// Right and up held, space pressed once: the dot is moved and blue
+		return " --channel0 keyboard --replay \"" + goldens + "/keyboard.input\"";
+	}
+	return "";
+}
+
+static std::string renderCommand(const std::string& shader, const std::string& extra, const std::string& outDir) {
+	// A hidden GLFW window still needs an X server
+	std::string prefix;
+	if(!getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY") && system("command -v xvfb-run >/dev/null 2>&1") == 0) {
+		prefix = "xvfb-run -a ";
+	}
+	char args[128];
+	snprintf(args, sizeof(args), " --width %d --height %d --frames %d --out ", WIDTH, HEIGHT, FRAME);
+	return prefix + "\"" SHADE_EXECUTABLE "\"" + args + "\"" + outDir + "\"" + extra + " \"" + shader + "\"";
+}
+
+int main() {
+	// Deterministic software rasterization, whatever GPU the box has
+	setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+	setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+	bool update = getenv("SHADE_UPDATE_GOLDENS") != NULL;
+
+	std::string examples = SHADE_SOURCE_DIR "/examples";
+	std::string goldens = SHADE_SOURCE_DIR "/tests/golden";
+	std::string outDir = "golden_output";
+	mkdir(outDir.c_str(), 0755);
+
+	std::vector<std::string> shaders = listImageShaders(examples);
+	if(shaders.empty()) {
+		fprintf(stderr, "No shaders found in %s\n", examples.c_str());
+		return EXIT_FAILURE;
+	}
+
+	int failures = 0;
+	for(size_t i = 0; i < shaders.size(); ++i) {
+		const std::string& name = shaders[i];
+		char frameName[64];
+		snprintf(frameName, sizeof(frameName), "/%s_%05d.png", name.c_str(), FRAME);
+		std::string rendered = outDir + frameName;
+		std::string golden = goldens + "/" + name + ".png";
+		remove(rendered.c_str());
+
+		std::string command = renderCommand(examples + "/" + name + ".glsl", extraArguments(name, goldens), outDir);
+		if(system(command.c_str()) != 0) {
+			fprintf(stderr, "FAIL %s: render failed (%s)\n", name.c_str(), command.c_str());
+			++failures;
+			continue;
+		}
+
+		if(update) {
+			bool copied = copyFile(rendered, golden);
+			printf("%s %s\n", copied ? "UPDATED" : "FAIL", golden.c_str());
+			if(!copied) ++failures;
+			continue;
+		}
+
+		int w, h, gw, gh, components;
+		uint8_t* actual = stbi_load(rendered.c_str(), &w, &h, &components, 4);
+		uint8_t* expected = stbi_load(golden.c_str(), &gw, &gh, &components, 4);
+		if(!actual || !expected || w != gw || h != gh) {
+			fprintf(stderr, "FAIL %s: %s\n", name.c_str(), !actual ? "no rendered frame" :
+				(!expected ? "no golden image, render it with SHADE_UPDATE_GOLDENS=1" : "size differs from the golden image"));
+			++failures;
+		} else {
+			ImageDiff diff = compareImages(actual, expected, w, h);
+			bool ok = diff.psnr >= MIN_PSNR && diff.ssim >= MIN_SSIM && diff.maxDiff <= MAX_CHANNEL_DIFF;
+			printf("%s %-16s PSNR %6.2f dB  SSIM %.4f  max diff %3d\n", ok ? "ok  " : "FAIL", name.c_str(), diff.psnr, diff.ssim, diff.maxDiff);
+			if(!ok) {
+				std::string diffPath = outDir + "/" + name + "_diff.png";
+				writeDiffImage(diffPath, actual, expected, w, h);
+				fprintf(stderr, "     rendered %s, difference %s\n", rendered.c_str(), diffPath.c_str());
+				++failures;
+			}
+		}
+		stbi_image_free(actual);
+		stbi_image_free(expected);
+	}
+
+	printf("%d of %d shaders match their golden image\n", (int)shaders.size() - failures, (int)shaders.size());
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}